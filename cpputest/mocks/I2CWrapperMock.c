@@ -23,3 +23,55 @@ I2CWrapperReturnCode I2CWrapperMock_LaunchI2CTransfer(I2CSetupInfo*
                           transacton_descriptor);
     return (I2CReturnCode) mock_c()->returnValue().value.intValue;
 }
+
+// Returns the device handle of the expectation, NULL when the registry is full
+I2CWrapperReturnCode I2CWrapperMock_RegisterDevice(const I2CWrapperDeviceProfile* profile,
+                                                   I2CWrapperDevice**             device)
+{
+    mock_c()->actualCall("I2CWrapper_RegisterDevice")
+    ->withParameterOfType("I2CWrapperDeviceProfile*", "profile", profile);
+    *device = (I2CWrapperDevice*) mock_c()->returnValue().value.pointerValue;
+    return (*device != NULL) ? I2C_WRAPPER_OK : I2C_WRAPPER_REGISTRY_FULL;
+}
+
+I2CWrapperReturnCode I2CWrapperMock_UnregisterDevice(I2CWrapperDevice* device)
+{
+    mock_c()->actualCall("I2CWrapper_UnregisterDevice")
+    ->withPointerParameters("device", device);
+    return I2C_WRAPPER_OK;
+}
+
+I2CWrapperReturnCode I2CWrapperMock_LaunchDeviceTransaction(I2CWrapperDevice*         device,
+                                                            I2CTransactionDescriptor* descriptor)
+{
+    mock_c()->actualCall("I2CWrapper_LaunchDeviceTransaction")
+    ->withPointerParameters("device", device)
+    ->withParameterOfType("I2CTransactionDescriptor*", "transaction_descriptor", descriptor);
+    return (I2CWrapperReturnCode) mock_c()->returnValue().value.intValue;
+}
+
+// One expected call per step, in order: the steps after a failed one are not run
+I2CWrapperReturnCode I2CWrapperMock_LaunchDeviceBatch(I2CWrapperDevice*    device,
+                                                      I2CWrapperBatchStep* steps,
+                                                      uint8_t              step_count)
+{
+    mock_c()->actualCall("I2CWrapper_LaunchDeviceBatch")
+    ->withPointerParameters("device", device)
+    ->withUnsignedIntParameters("step_count", step_count);
+
+    for (uint8_t i = 0; i < step_count; i++) {
+        steps[i].return_code = I2C_WRAPPER_STEP_NOT_RUN;
+    }
+    for (uint8_t i = 0; i < step_count; i++) {
+        mock_c()->actualCall("I2CWrapper_LaunchDeviceBatch_Step")
+        ->withParameterOfType("I2CTransactionDescriptor*",
+                              "transaction_descriptor",
+                              steps[i].descriptor)
+        ->withUnsignedIntParameters("delay_ms", steps[i].delay_ms);
+        steps[i].return_code = (I2CWrapperReturnCode) mock_c()->returnValue().value.intValue;
+        if (steps[i].return_code != I2C_WRAPPER_OK) {
+            return steps[i].return_code;
+        }
+    }
+    return I2C_WRAPPER_OK;
+}
@@ -21,6 +21,14 @@ extern "C" {
 
 I2CWrapperReturnCode I2CWrapperMock_LaunchI2CTransfer(I2CSetupInfo*             setup_info,
                                                       I2CTransactionDescriptor* transacton_descriptor);
+I2CWrapperReturnCode I2CWrapperMock_RegisterDevice(const I2CWrapperDeviceProfile* profile,
+                                                   I2CWrapperDevice**             device);
+I2CWrapperReturnCode I2CWrapperMock_UnregisterDevice(I2CWrapperDevice* device);
+I2CWrapperReturnCode I2CWrapperMock_LaunchDeviceTransaction(I2CWrapperDevice*         device,
+                                                            I2CTransactionDescriptor* descriptor);
+I2CWrapperReturnCode I2CWrapperMock_LaunchDeviceBatch(I2CWrapperDevice*    device,
+                                                      I2CWrapperBatchStep* steps,
+                                                      uint8_t              step_count);
 
 #ifdef __cplusplus
 }
@@ -13,20 +13,24 @@
 #include "CppUTest/TestHarness.h"
 #include "CppUTestExt/MockSupport.h"
 #include "I2CMock.h"
+#include "I2CWrapper.h"
 #include <string.h>
 
-class Si7021_I2CSetupInfo_Comparator : public MockNamedValueComparator
+class Si7021_DeviceProfile_Comparator : public MockNamedValueComparator
 {
 public:
 bool isEqual(const void* object1,
              const void* object2)
 {
-    const auto* I2CSetupInfo1 = (const I2CSetupInfo*) object1;
-    const auto* I2CSetupInfo2 = (const I2CSetupInfo*) object2;
-    bool ret                  = true;
+    const auto* DeviceProfile1 = (const I2CWrapperDeviceProfile*) object1;
+    const auto* DeviceProfile2 = (const I2CWrapperDeviceProfile*) object2;
+    bool ret                   = true;
 
-    CHECK(ret &= (I2CSetupInfo1->mode == I2CSetupInfo2->mode));
-    CHECK(ret &= (I2CSetupInfo1->role == I2CSetupInfo2->role));
+    CHECK(ret &= (DeviceProfile1->mode == DeviceProfile2->mode));
+    CHECK(ret &= (DeviceProfile1->timing == DeviceProfile2->timing));
+    CHECK(ret &= (DeviceProfile1->addressing_mode == DeviceProfile2->addressing_mode));
+    CHECK(ret &= (DeviceProfile1->address == DeviceProfile2->address));
+    CHECK(ret &= (DeviceProfile1->data_path == DeviceProfile2->data_path));
 
     return ret;
 }
@@ -47,11 +51,13 @@ bool isEqual(const void* object1,
     const auto* I2CTransactionDesc2 = (const I2CTransactionDescriptor*) object2;
     bool ret                        = true;
 
-    ret &= (I2CTransactionDesc1->addressing_mode == I2CTransactionDesc2->addressing_mode);
-    ret &= (I2CTransactionDesc1->address == I2CTransactionDesc2->address);
+    ret &= (I2CTransactionDesc1->type == I2CTransactionDesc2->type);
     ret &= (I2CTransactionDesc1->direction == I2CTransactionDesc2->direction);
-    ret &= (I2CTransactionDesc1->data_path == I2CTransactionDesc2->data_path);
     ret &= (I2CTransactionDesc1->data_count == I2CTransactionDesc2->data_count);
+    ret &= (I2CTransactionDesc1->crc == I2CTransactionDesc2->crc);
+    if (I2CTransactionDesc1->crc != I2C_CRC_NONE) {
+        ret &= (I2CTransactionDesc1->crc_polynomial == I2CTransactionDesc2->crc_polynomial);
+    }
     if (I2CTransactionDesc1->direction == I2C_TX) {
         ret &= (0 == memcmp(I2CTransactionDesc1->data,
                             I2CTransactionDesc2->data,
@@ -61,6 +67,12 @@ bool isEqual(const void* object1,
                I2CTransactionDesc1->data,
                I2CTransactionDesc1->data_count);
     }
+    if (I2CTransactionDesc1->type == I2C_WRITE_READ_TRANSACTION) {
+        ret &= (I2CTransactionDesc1->rx_data_count == I2CTransactionDesc2->rx_data_count);
+        memcpy(I2CTransactionDesc2->rx_data,
+               I2CTransactionDesc1->rx_data,
+               I2CTransactionDesc1->rx_data_count);
+    }
 
     return ret;
 }
@@ -71,7 +83,7 @@ SimpleString valueToString(const void* object)
 }
 };
 
-Si7021_I2CSetupInfo_Comparator si7021_setup_info_comparator;
+Si7021_DeviceProfile_Comparator si7021_device_profile_comparator;
 Si7021_TransactionDescriptor_Comparator si7021_transaction_descriptor_comparator;
 
 extern "C" {
@@ -88,10 +100,14 @@ typedef uint8_t MockSi7021Measurement[3];
 
 static SemaphoreHandle_t mock_Si7021_mutex_handle = NEW_MUTEX(0);
 static TaskHandle_t mock_Si7021_task_handle       = NEW_TASK(0);
+static I2CWrapperDevice* mock_Si7021_device       = (I2CWrapperDevice*) 0x3000;
 
-static I2CSetupInfo expected_setup_info;
+static I2CWrapperDeviceProfile expected_device_profile;
+static I2CWrapperDeviceProfile expected_other_device_profile;
+static bool device_registered; // Expected to be unregistered by Si7021_Destroy
 static I2CTransactionDescriptor expected_write_transaction_descriptor;
 static I2CTransactionDescriptor expected_read_transaction_descriptor;
+static I2CTransactionDescriptor expected_write_read_transaction_descriptor;
 
 static uint8_t si7021_cmd_buffer[SI7021_MAX_CMD_LENGTH];
 
@@ -146,32 +162,92 @@ static void ResetStaticVariables(void)
 
     humidity = 0;
 
-    expected_setup_info.role = I2C_MASTER;
-    expected_setup_info.mode = I2C_STANDARD_MODE;
+    expected_device_profile.mode            = I2C_STANDARD_MODE;
+    expected_device_profile.timing          = NULL;
+    expected_device_profile.addressing_mode = I2C_ADDRESSING_MODE_7_BIT;
+    expected_device_profile.address         = DEFAULT_SLAVE_ADDR;
+    expected_device_profile.data_path       = I2C_USE_AUTO;
+
+    expected_other_device_profile         = expected_device_profile;
+    expected_other_device_profile.address = DEFAULT_SLAVE_ADDR + 1;
+    device_registered                     = false;
 
+    expected_write_transaction_descriptor.type            = I2C_SIMPLE_TRANSACTION;
     expected_write_transaction_descriptor.direction       = I2C_TX;
-    expected_write_transaction_descriptor.addressing_mode = I2C_ADDRESSING_MODE_7_BIT;
-    expected_write_transaction_descriptor.address         = DEFAULT_SLAVE_ADDR;
-    expected_write_transaction_descriptor.data_path       = I2C_USE_FIFO;
     expected_write_transaction_descriptor.data            = si7021_cmd_buffer;
     expected_write_transaction_descriptor.data_count      = 0;
+    expected_write_transaction_descriptor.rx_data         = NULL;
+    expected_write_transaction_descriptor.rx_data_count   = 0;
     expected_write_transaction_descriptor.callback        = NULL;
+    expected_write_transaction_descriptor.crc             = I2C_CRC_NONE;
+    expected_write_transaction_descriptor.crc_polynomial  = 0;
 
+    expected_read_transaction_descriptor.type            = I2C_SIMPLE_TRANSACTION;
     expected_read_transaction_descriptor.direction       = I2C_RX;
-    expected_read_transaction_descriptor.addressing_mode = I2C_ADDRESSING_MODE_7_BIT;
-    expected_read_transaction_descriptor.address         = DEFAULT_SLAVE_ADDR;
-    expected_read_transaction_descriptor.data_path       = I2C_USE_FIFO;
     expected_read_transaction_descriptor.data            = NULL;
     expected_read_transaction_descriptor.data_count      = 0;
+    expected_read_transaction_descriptor.rx_data         = NULL;
+    expected_read_transaction_descriptor.rx_data_count   = 0;
     expected_read_transaction_descriptor.callback        = NULL;
+    expected_read_transaction_descriptor.crc             = I2C_CRC_DATA;
+    expected_read_transaction_descriptor.crc_polynomial  = SI7021_CRC8_POLYNOMIAL;
+
+    expected_write_read_transaction_descriptor.type            = I2C_WRITE_READ_TRANSACTION;
+    expected_write_read_transaction_descriptor.direction       = I2C_TX;
+    expected_write_read_transaction_descriptor.data            = si7021_cmd_buffer;
+    expected_write_read_transaction_descriptor.data_count      = 0;
+    expected_write_read_transaction_descriptor.rx_data         = NULL;
+    expected_write_read_transaction_descriptor.rx_data_count   = 0;
+    expected_write_read_transaction_descriptor.callback        = NULL;
+    expected_write_read_transaction_descriptor.crc             = I2C_CRC_NONE;
+    expected_write_read_transaction_descriptor.crc_polynomial  = 0;
+}
+
+static void ExpectDeviceRegistration(void)
+{
+    mock().expectOneCall("I2CWrapper_RegisterDevice")
+    .withParameterOfType("I2CWrapperDeviceProfile*", "profile", &expected_device_profile)
+    .andReturnValue((void*) mock_Si7021_device);
+    device_registered = true;
+}
+
+static void ExpectOtherDeviceRegistration(void)
+{
+    mock().expectOneCall("I2CWrapper_RegisterDevice")
+    .withParameterOfType("I2CWrapperDeviceProfile*", "profile", &expected_other_device_profile)
+    .andReturnValue((void*) mock_Si7021_device);
+    device_registered = true;
+}
+
+static void RefuseDeviceRegistration(void)
+{
+    mock().expectOneCall("I2CWrapper_RegisterDevice")
+    .withParameterOfType("I2CWrapperDeviceProfile*", "profile", &expected_device_profile)
+    .andReturnValue((void*) NULL);
+}
+
+static void ExpectDeviceUnregistration(void)
+{
+    mock().expectOneCall("I2CWrapper_UnregisterDevice")
+    .withPointerParameter("device", mock_Si7021_device);
+    device_registered = false;
+}
+
+static void ExpectDestroy(void)
+{
+    ExpectTaskDeletion(mock_Si7021_task_handle);
+    if (device_registered) {
+        ExpectDeviceUnregistration();
+    }
+    ExpectSemaphoreDeletion(mock_Si7021_mutex_handle);
 }
 
-static void I2CTransactionReturns(I2CSetupInfo*             setup_info,
+static void I2CTransactionReturns(I2CWrapperDevice*         device,
                                   I2CTransactionDescriptor* transaction_descriptor,
                                   I2CWrapperReturnCode      return_code)
 {
-    mock().expectOneCall("I2CWrapper_LaunchI2CTransaction")
-    .withParameterOfType("I2CSetupInfo*", "setup_info", setup_info)
+    mock().expectOneCall("I2CWrapper_LaunchDeviceTransaction")
+    .withPointerParameter("device", device)
     .withParameterOfType("I2CTransactionDescriptor*",
                          "transaction_descriptor",
                          transaction_descriptor)
@@ -182,50 +258,55 @@ static void ExpectResetCmdTransactionAndReturn(I2CWrapperReturnCode return_code)
 {
     si7021_cmd_buffer[0]                             = SI7021_RESET_CMD;
     expected_write_transaction_descriptor.data_count = 1;
-    I2CTransactionReturns(&expected_setup_info,
+    I2CTransactionReturns(mock_Si7021_device,
                           &expected_write_transaction_descriptor,
                           return_code);
 }
 
-static void ExpectRevisionCmdTransactionAndReturn(I2CWrapperReturnCode return_code)
+static void ExpectMeasBatch(void)
 {
-    si7021_cmd_buffer[0]                             = SI7021_REVISION_CMD >> 8;
-    si7021_cmd_buffer[1]                             = SI7021_REVISION_CMD & 0xFF;
-    expected_write_transaction_descriptor.data_count = 2;
-    I2CTransactionReturns(&expected_setup_info,
-                          &expected_write_transaction_descriptor,
-                          return_code);
+    mock().expectOneCall("I2CWrapper_LaunchDeviceBatch")
+    .withPointerParameter("device", mock_Si7021_device)
+    .withParameter("step_count", 2u);
 }
 
-static void ExpectMeasCmdTransactionAndReturn(uint8_t              cmd_id,
-                                              I2CWrapperReturnCode return_code)
+static void ExpectMeasCmdStepAndReturn(uint8_t              cmd_id,
+                                       uint32_t             delay_ms,
+                                       I2CWrapperReturnCode return_code)
 {
     si7021_cmd_buffer[0]                             = cmd_id;
     expected_write_transaction_descriptor.data_count = 1;
-    I2CTransactionReturns(&expected_setup_info,
-                          &expected_write_transaction_descriptor,
-                          return_code);
+    mock().expectOneCall("I2CWrapper_LaunchDeviceBatch_Step")
+    .withParameterOfType("I2CTransactionDescriptor*",
+                         "transaction_descriptor",
+                         &expected_write_transaction_descriptor)
+    .withParameter("delay_ms", delay_ms)
+    .andReturnValue(return_code);
 }
 
-static void ExpectRevisionReadTransactionAndReturn(I2CWrapperReturnCode   return_code,
-                                                   Si7021FirmwareRevision mock_revision)
+static void ExpectRevisionWriteReadTransactionAndReturn(I2CWrapperReturnCode   return_code,
+                                                        Si7021FirmwareRevision mock_revision)
 {
+    si7021_cmd_buffer[0] = SI7021_REVISION_CMD >> 8;
+    si7021_cmd_buffer[1] = SI7021_REVISION_CMD & 0xFF;
+    expected_write_read_transaction_descriptor.data_count = 2;
+
     switch (mock_revision) {
         case SI7021_REV_1:
-            expected_read_transaction_descriptor.data = mock_si7021_fw_revision_1;
+            expected_write_read_transaction_descriptor.rx_data = mock_si7021_fw_revision_1;
             break;
 
         case SI7021_REV_2:
-            expected_read_transaction_descriptor.data = mock_si7021_fw_revision_2;
+            expected_write_read_transaction_descriptor.rx_data = mock_si7021_fw_revision_2;
             break;
 
         default:
-            expected_read_transaction_descriptor.data = mock_si7021_fw_revision_unknown;
+            expected_write_read_transaction_descriptor.rx_data = mock_si7021_fw_revision_unknown;
             break;
     }
-    expected_read_transaction_descriptor.data_count = sizeof(MockSi7021Revision);
-    I2CTransactionReturns(&expected_setup_info,
-                          &expected_read_transaction_descriptor,
+    expected_write_read_transaction_descriptor.rx_data_count = sizeof(MockSi7021Revision);
+    I2CTransactionReturns(mock_Si7021_device,
+                          &expected_write_read_transaction_descriptor,
                           return_code);
 }
 
@@ -235,16 +316,33 @@ static void ExpectMeasReadTransactionAndReturn(I2CWrapperReturnCode  return_code
     expected_read_transaction_descriptor.data       = mock_measurement;
     expected_read_transaction_descriptor.data_count = sizeof(MockSi7021Measurement);
 
-    I2CTransactionReturns(&expected_setup_info,
+    I2CTransactionReturns(mock_Si7021_device,
                           &expected_read_transaction_descriptor,
                           return_code);
 }
 
+static void ExpectMeasReadStepAndReturn(I2CWrapperReturnCode  return_code,
+                                        MockSi7021Measurement mock_measurement)
+{
+    expected_read_transaction_descriptor.data       = mock_measurement;
+    expected_read_transaction_descriptor.data_count = sizeof(MockSi7021Measurement);
+
+    mock().expectOneCall("I2CWrapper_LaunchDeviceBatch_Step")
+    .withParameterOfType("I2CTransactionDescriptor*",
+                         "transaction_descriptor",
+                         &expected_read_transaction_descriptor)
+    .withParameter("delay_ms", 0u)
+    .andReturnValue(return_code);
+}
+
 static void StandardSetup(void)
 {
     mock().strictOrder();
-    UT_PTR_SET(I2CWrapper_LaunchI2CTransaction, I2CWrapperMock_LaunchI2CTransfer);
-    mock().installComparator("I2CSetupInfo*", si7021_setup_info_comparator);
+    UT_PTR_SET(I2CWrapper_RegisterDevice, I2CWrapperMock_RegisterDevice);
+    UT_PTR_SET(I2CWrapper_UnregisterDevice, I2CWrapperMock_UnregisterDevice);
+    UT_PTR_SET(I2CWrapper_LaunchDeviceTransaction, I2CWrapperMock_LaunchDeviceTransaction);
+    UT_PTR_SET(I2CWrapper_LaunchDeviceBatch, I2CWrapperMock_LaunchDeviceBatch);
+    mock().installComparator("I2CWrapperDeviceProfile*", si7021_device_profile_comparator);
     mock().installComparator("I2CTransactionDescriptor*",
                              si7021_transaction_descriptor_comparator);
     ResetStaticVariables();
@@ -253,6 +351,7 @@ static void StandardSetup(void)
     LONGS_EQUAL(SI7021_OK, Si7021_Create());
 
     ExpectSemaphoreTakeBeforeTimeout(mock_Si7021_mutex_handle, IMMEDIATE_TIMEOUT);
+    ExpectDeviceRegistration();
     ExpectResetCmdTransactionAndReturn(I2C_WRAPPER_OK);
     ExpectTaskDelay(pdMS_TO_TICKS(SI7021_RESET_DELAY));
     LONGS_EQUAL(SI7021_OK, Si7021_Acquire(DEFAULT_SLAVE_ADDR));
@@ -262,8 +361,7 @@ static void StandardTeardown(void)
 {
     ExpectSemaphoreGive(mock_Si7021_mutex_handle);
     Si7021_Release();
-    ExpectTaskDeletion(mock_Si7021_task_handle);
-    ExpectSemaphoreDeletion(mock_Si7021_mutex_handle);
+    ExpectDestroy();
     Si7021_Destroy();
     mock().checkExpectations();
     mock().clear();
@@ -313,8 +411,10 @@ TEST_GROUP(Si7021AcquireRelease)
     void setup()
     {
         mock().strictOrder();
-        UT_PTR_SET(I2CWrapper_LaunchI2CTransaction, I2CWrapperMock_LaunchI2CTransfer);
-        mock().installComparator("I2CSetupInfo*", si7021_setup_info_comparator);
+        UT_PTR_SET(I2CWrapper_RegisterDevice, I2CWrapperMock_RegisterDevice);
+        UT_PTR_SET(I2CWrapper_UnregisterDevice, I2CWrapperMock_UnregisterDevice);
+        UT_PTR_SET(I2CWrapper_LaunchDeviceTransaction, I2CWrapperMock_LaunchDeviceTransaction);
+        mock().installComparator("I2CWrapperDeviceProfile*", si7021_device_profile_comparator);
         mock().installComparator("I2CTransactionDescriptor*",
                                  si7021_transaction_descriptor_comparator);
         ResetStaticVariables();
@@ -325,8 +425,7 @@ TEST_GROUP(Si7021AcquireRelease)
 
     void teardown()
     {
-        ExpectTaskDeletion(mock_Si7021_task_handle);
-        ExpectSemaphoreDeletion(mock_Si7021_mutex_handle);
+        ExpectDestroy();
         Si7021_Destroy();
         mock().checkExpectations();
         mock().clear();
@@ -345,9 +444,18 @@ TEST(Si7021AcquireRelease, MutexUnavailable)
     LONGS_EQUAL(SI7021_MUTEX_UNAVAILABLE, Si7021_Acquire(DEFAULT_SLAVE_ADDR));
 }
 
+TEST(Si7021AcquireRelease, RegistryFull)
+{
+    ExpectSemaphoreTakeBeforeTimeout(mock_Si7021_mutex_handle, IMMEDIATE_TIMEOUT);
+    RefuseDeviceRegistration();
+    ExpectSemaphoreGive(mock_Si7021_mutex_handle);
+    LONGS_EQUAL(SI7021_DEVICE_NOT_REGISTERED, Si7021_Acquire(DEFAULT_SLAVE_ADDR));
+}
+
 TEST(Si7021AcquireRelease, I2CError)
 {
     ExpectSemaphoreTakeBeforeTimeout(mock_Si7021_mutex_handle, IMMEDIATE_TIMEOUT);
+    ExpectDeviceRegistration();
     ExpectResetCmdTransactionAndReturn(I2C_WRAPPER_I2C_ERROR);
     ExpectSemaphoreGive(mock_Si7021_mutex_handle);
     LONGS_EQUAL(SI7021_I2C_ERROR, Si7021_Acquire(DEFAULT_SLAVE_ADDR));
@@ -356,6 +464,7 @@ TEST(Si7021AcquireRelease, I2CError)
 TEST(Si7021AcquireRelease, Succeeds)
 {
     ExpectSemaphoreTakeBeforeTimeout(mock_Si7021_mutex_handle, IMMEDIATE_TIMEOUT);
+    ExpectDeviceRegistration();
     ExpectResetCmdTransactionAndReturn(I2C_WRAPPER_OK);
     ExpectTaskDelay(pdMS_TO_TICKS(SI7021_RESET_DELAY));
     LONGS_EQUAL(SI7021_OK, Si7021_Acquire(DEFAULT_SLAVE_ADDR));
@@ -364,6 +473,7 @@ TEST(Si7021AcquireRelease, Succeeds)
 TEST(Si7021AcquireRelease, ReleaseGivesMutex)
 {
     ExpectSemaphoreTakeBeforeTimeout(mock_Si7021_mutex_handle, IMMEDIATE_TIMEOUT);
+    ExpectDeviceRegistration();
     ExpectResetCmdTransactionAndReturn(I2C_WRAPPER_OK);
     ExpectTaskDelay(pdMS_TO_TICKS(SI7021_RESET_DELAY));
     LONGS_EQUAL(SI7021_OK, Si7021_Acquire(DEFAULT_SLAVE_ADDR));
@@ -371,6 +481,40 @@ TEST(Si7021AcquireRelease, ReleaseGivesMutex)
     Si7021_Release();
 }
 
+TEST(Si7021AcquireRelease, DeviceStaysRegisteredForTheNextAcquire)
+{
+    ExpectSemaphoreTakeBeforeTimeout(mock_Si7021_mutex_handle, IMMEDIATE_TIMEOUT);
+    ExpectDeviceRegistration();
+    ExpectResetCmdTransactionAndReturn(I2C_WRAPPER_OK);
+    ExpectTaskDelay(pdMS_TO_TICKS(SI7021_RESET_DELAY));
+    LONGS_EQUAL(SI7021_OK, Si7021_Acquire(DEFAULT_SLAVE_ADDR));
+    ExpectSemaphoreGive(mock_Si7021_mutex_handle);
+    Si7021_Release();
+
+    ExpectSemaphoreTakeBeforeTimeout(mock_Si7021_mutex_handle, IMMEDIATE_TIMEOUT);
+    ExpectResetCmdTransactionAndReturn(I2C_WRAPPER_OK);
+    ExpectTaskDelay(pdMS_TO_TICKS(SI7021_RESET_DELAY));
+    LONGS_EQUAL(SI7021_OK, Si7021_Acquire(DEFAULT_SLAVE_ADDR));
+}
+
+TEST(Si7021AcquireRelease, AnotherAddressIsRegisteredAgain)
+{
+    ExpectSemaphoreTakeBeforeTimeout(mock_Si7021_mutex_handle, IMMEDIATE_TIMEOUT);
+    ExpectDeviceRegistration();
+    ExpectResetCmdTransactionAndReturn(I2C_WRAPPER_OK);
+    ExpectTaskDelay(pdMS_TO_TICKS(SI7021_RESET_DELAY));
+    LONGS_EQUAL(SI7021_OK, Si7021_Acquire(DEFAULT_SLAVE_ADDR));
+    ExpectSemaphoreGive(mock_Si7021_mutex_handle);
+    Si7021_Release();
+
+    ExpectSemaphoreTakeBeforeTimeout(mock_Si7021_mutex_handle, IMMEDIATE_TIMEOUT);
+    ExpectDeviceUnregistration();
+    ExpectOtherDeviceRegistration();
+    ExpectResetCmdTransactionAndReturn(I2C_WRAPPER_OK);
+    ExpectTaskDelay(pdMS_TO_TICKS(SI7021_RESET_DELAY));
+    LONGS_EQUAL(SI7021_OK, Si7021_Acquire(DEFAULT_SLAVE_ADDR + 1));
+}
+
 TEST_GROUP(Si7021ReadRevision)
 {
     void setup()
@@ -389,39 +533,30 @@ TEST(Si7021ReadRevision, NullFirmwareRevisionReturnsInvalidData)
     LONGS_EQUAL(SI7021_INVALID_INPUT_DATA, Si7021_ReadRevision(NULL));
 }
 
-TEST(Si7021ReadRevision, I2CErrorSendingCommand)
-{
-    ExpectRevisionCmdTransactionAndReturn(I2C_WRAPPER_I2C_ERROR);
-    LONGS_EQUAL(SI7021_I2C_ERROR, Si7021_ReadRevision(&fw_revision));
-}
-
 TEST(Si7021ReadRevision, I2CErrorReadingValue)
 {
-    ExpectRevisionCmdTransactionAndReturn(I2C_WRAPPER_OK);
-    ExpectRevisionReadTransactionAndReturn(I2C_WRAPPER_I2C_ERROR, SI7021_REV_2);
+    ExpectRevisionWriteReadTransactionAndReturn(I2C_WRAPPER_I2C_ERROR, SI7021_REV_2);
     LONGS_EQUAL(SI7021_I2C_ERROR, Si7021_ReadRevision(&fw_revision));
+    LONGS_EQUAL(SI7021_REV_UNKNOWN, fw_revision);
 }
 
 TEST(Si7021ReadRevision, Revision1)
 {
-    ExpectRevisionCmdTransactionAndReturn(I2C_WRAPPER_OK);
-    ExpectRevisionReadTransactionAndReturn(I2C_WRAPPER_OK, SI7021_REV_1);
+    ExpectRevisionWriteReadTransactionAndReturn(I2C_WRAPPER_OK, SI7021_REV_1);
     LONGS_EQUAL(SI7021_OK, Si7021_ReadRevision(&fw_revision));
     LONGS_EQUAL(SI7021_REV_1, fw_revision);
 }
 
 TEST(Si7021ReadRevision, Revision2)
 {
-    ExpectRevisionCmdTransactionAndReturn(I2C_WRAPPER_OK);
-    ExpectRevisionReadTransactionAndReturn(I2C_WRAPPER_OK, SI7021_REV_2);
+    ExpectRevisionWriteReadTransactionAndReturn(I2C_WRAPPER_OK, SI7021_REV_2);
     LONGS_EQUAL(SI7021_OK, Si7021_ReadRevision(&fw_revision));
     LONGS_EQUAL(SI7021_REV_2, fw_revision);
 }
 
 TEST(Si7021ReadRevision, RevisionUnknown)
 {
-    ExpectRevisionCmdTransactionAndReturn(I2C_WRAPPER_OK);
-    ExpectRevisionReadTransactionAndReturn(I2C_WRAPPER_OK, SI7021_REV_UNKNOWN);
+    ExpectRevisionWriteReadTransactionAndReturn(I2C_WRAPPER_OK, SI7021_REV_UNKNOWN);
     LONGS_EQUAL(SI7021_OK, Si7021_ReadRevision(&fw_revision));
     LONGS_EQUAL(SI7021_REV_UNKNOWN, fw_revision);
 }
@@ -446,43 +581,47 @@ TEST(Si7021ReadTemperature, NullTemperatureReturnsInvalidData)
 
 TEST(Si7021ReadTemperature, I2CErrorSendingCommand)
 {
-    ExpectMeasCmdTransactionAndReturn(SI7021_MEASTEMP_NOHOLD_CMD, I2C_WRAPPER_I2C_ERROR);
+    ExpectMeasBatch();
+    ExpectMeasCmdStepAndReturn(SI7021_MEASTEMP_NOHOLD_CMD,
+                               SI7021_MEASTEMP_DELAY,
+                               I2C_WRAPPER_I2C_ERROR);
     LONGS_EQUAL(SI7021_I2C_ERROR, Si7021_ReadTemperature(&temperature));
 }
 
 TEST(Si7021ReadTemperature, I2CErrorReadingValue)
 {
-    ExpectMeasCmdTransactionAndReturn(SI7021_MEASTEMP_NOHOLD_CMD, I2C_WRAPPER_OK);
-    ExpectTaskDelay(pdMS_TO_TICKS(SI7021_MEASTEMP_DELAY));
+    ExpectMeasBatch();
+    ExpectMeasCmdStepAndReturn(SI7021_MEASTEMP_NOHOLD_CMD, SI7021_MEASTEMP_DELAY, I2C_WRAPPER_OK);
+    ExpectMeasReadStepAndReturn(I2C_WRAPPER_I2C_ERROR, mock_si7021_valid_temp_measurement);
     for (uint8_t i = 0; i < SI7021_MAX_READ_VAL_ATTEMPTS - 1; i++) {
         ExpectMeasReadTransactionAndReturn(I2C_WRAPPER_I2C_ERROR,
                                            mock_si7021_valid_temp_measurement);
     }
-    ExpectMeasReadTransactionAndReturn(I2C_WRAPPER_I2C_ERROR, mock_si7021_valid_temp_measurement);
     LONGS_EQUAL(SI7021_I2C_ERROR, Si7021_ReadTemperature(&temperature));
 }
 
 TEST(Si7021ReadTemperature, ChecksumError)
 {
-    ExpectMeasCmdTransactionAndReturn(SI7021_MEASTEMP_NOHOLD_CMD, I2C_WRAPPER_OK);
-    ExpectTaskDelay(pdMS_TO_TICKS(SI7021_MEASTEMP_DELAY));
-    ExpectMeasReadTransactionAndReturn(I2C_WRAPPER_OK, mock_si7021_invalid_temp_measurement);
+    ExpectMeasBatch();
+    ExpectMeasCmdStepAndReturn(SI7021_MEASTEMP_NOHOLD_CMD, SI7021_MEASTEMP_DELAY, I2C_WRAPPER_OK);
+    ExpectMeasReadStepAndReturn(I2C_WRAPPER_CRC_ERROR, mock_si7021_invalid_temp_measurement);
     LONGS_EQUAL(SI7021_CHECKSUM_ERROR, Si7021_ReadTemperature(&temperature));
 }
 
 TEST(Si7021ReadTemperature, SucceedsOnFirstReadAttempt)
 {
-    ExpectMeasCmdTransactionAndReturn(SI7021_MEASTEMP_NOHOLD_CMD, I2C_WRAPPER_OK);
-    ExpectTaskDelay(pdMS_TO_TICKS(SI7021_MEASTEMP_DELAY));
-    ExpectMeasReadTransactionAndReturn(I2C_WRAPPER_OK, mock_si7021_valid_temp_measurement);
+    ExpectMeasBatch();
+    ExpectMeasCmdStepAndReturn(SI7021_MEASTEMP_NOHOLD_CMD, SI7021_MEASTEMP_DELAY, I2C_WRAPPER_OK);
+    ExpectMeasReadStepAndReturn(I2C_WRAPPER_OK, mock_si7021_valid_temp_measurement);
     LONGS_EQUAL(SI7021_OK, Si7021_ReadTemperature(&temperature));
 }
 
 TEST(Si7021ReadTemperature, SucceedsOnLastReadAttempt)
 {
-    ExpectMeasCmdTransactionAndReturn(SI7021_MEASTEMP_NOHOLD_CMD, I2C_WRAPPER_OK);
-    ExpectTaskDelay(pdMS_TO_TICKS(SI7021_MEASTEMP_DELAY));
-    for (uint8_t i = 0; i < SI7021_MAX_READ_VAL_ATTEMPTS - 1; i++) {
+    ExpectMeasBatch();
+    ExpectMeasCmdStepAndReturn(SI7021_MEASTEMP_NOHOLD_CMD, SI7021_MEASTEMP_DELAY, I2C_WRAPPER_OK);
+    ExpectMeasReadStepAndReturn(I2C_WRAPPER_I2C_ERROR, mock_si7021_valid_temp_measurement);
+    for (uint8_t i = 0; i < SI7021_MAX_READ_VAL_ATTEMPTS - 2; i++) {
         ExpectMeasReadTransactionAndReturn(I2C_WRAPPER_I2C_ERROR,
                                            mock_si7021_valid_temp_measurement);
     }
@@ -510,43 +649,47 @@ TEST(Si7021ReadHumidity, NullHumidityReturnsInvalidData)
 
 TEST(Si7021ReadHumidity, I2CErrorSendingCommand)
 {
-    ExpectMeasCmdTransactionAndReturn(SI7021_MEASRH_NOHOLD_CMD, I2C_WRAPPER_I2C_ERROR);
+    ExpectMeasBatch();
+    ExpectMeasCmdStepAndReturn(SI7021_MEASRH_NOHOLD_CMD,
+                               SI7021_MEASRH_DELAY,
+                               I2C_WRAPPER_I2C_ERROR);
     LONGS_EQUAL(SI7021_I2C_ERROR, Si7021_ReadHumidity(&humidity));
 }
 
 TEST(Si7021ReadHumidity, I2CErrorReadingValue)
 {
-    ExpectMeasCmdTransactionAndReturn(SI7021_MEASRH_NOHOLD_CMD, I2C_WRAPPER_OK);
-    ExpectTaskDelay(pdMS_TO_TICKS(SI7021_MEASRH_DELAY));
+    ExpectMeasBatch();
+    ExpectMeasCmdStepAndReturn(SI7021_MEASRH_NOHOLD_CMD, SI7021_MEASRH_DELAY, I2C_WRAPPER_OK);
+    ExpectMeasReadStepAndReturn(I2C_WRAPPER_I2C_ERROR, mock_si7021_valid_rh_measurement);
     for (uint8_t i = 0; i < SI7021_MAX_READ_VAL_ATTEMPTS - 1; i++) {
         ExpectMeasReadTransactionAndReturn(I2C_WRAPPER_I2C_ERROR,
                                            mock_si7021_valid_rh_measurement);
     }
-    ExpectMeasReadTransactionAndReturn(I2C_WRAPPER_I2C_ERROR, mock_si7021_valid_rh_measurement);
     LONGS_EQUAL(SI7021_I2C_ERROR, Si7021_ReadHumidity(&humidity));
 }
 
 TEST(Si7021ReadHumidity, ChecksumError)
 {
-    ExpectMeasCmdTransactionAndReturn(SI7021_MEASRH_NOHOLD_CMD, I2C_WRAPPER_OK);
-    ExpectTaskDelay(pdMS_TO_TICKS(SI7021_MEASRH_DELAY));
-    ExpectMeasReadTransactionAndReturn(I2C_WRAPPER_OK, mock_si7021_invalid_rh_measurement);
+    ExpectMeasBatch();
+    ExpectMeasCmdStepAndReturn(SI7021_MEASRH_NOHOLD_CMD, SI7021_MEASRH_DELAY, I2C_WRAPPER_OK);
+    ExpectMeasReadStepAndReturn(I2C_WRAPPER_CRC_ERROR, mock_si7021_invalid_rh_measurement);
     LONGS_EQUAL(SI7021_CHECKSUM_ERROR, Si7021_ReadHumidity(&humidity));
 }
 
 TEST(Si7021ReadHumidity, SucceedsOnFirstReadAttempt)
 {
-    ExpectMeasCmdTransactionAndReturn(SI7021_MEASRH_NOHOLD_CMD, I2C_WRAPPER_OK);
-    ExpectTaskDelay(pdMS_TO_TICKS(SI7021_MEASRH_DELAY));
-    ExpectMeasReadTransactionAndReturn(I2C_WRAPPER_OK, mock_si7021_valid_rh_measurement);
+    ExpectMeasBatch();
+    ExpectMeasCmdStepAndReturn(SI7021_MEASRH_NOHOLD_CMD, SI7021_MEASRH_DELAY, I2C_WRAPPER_OK);
+    ExpectMeasReadStepAndReturn(I2C_WRAPPER_OK, mock_si7021_valid_rh_measurement);
     LONGS_EQUAL(SI7021_OK, Si7021_ReadHumidity(&humidity));
 }
 
 TEST(Si7021ReadHumidity, SucceedsOnLastReadAttempt)
 {
-    ExpectMeasCmdTransactionAndReturn(SI7021_MEASRH_NOHOLD_CMD, I2C_WRAPPER_OK);
-    ExpectTaskDelay(pdMS_TO_TICKS(SI7021_MEASRH_DELAY));
-    for (uint8_t i = 0; i < SI7021_MAX_READ_VAL_ATTEMPTS - 1; i++) {
+    ExpectMeasBatch();
+    ExpectMeasCmdStepAndReturn(SI7021_MEASRH_NOHOLD_CMD, SI7021_MEASRH_DELAY, I2C_WRAPPER_OK);
+    ExpectMeasReadStepAndReturn(I2C_WRAPPER_I2C_ERROR, mock_si7021_valid_rh_measurement);
+    for (uint8_t i = 0; i < SI7021_MAX_READ_VAL_ATTEMPTS - 2; i++) {
         ExpectMeasReadTransactionAndReturn(I2C_WRAPPER_I2C_ERROR,
                                            mock_si7021_valid_rh_measurement);
     }
@@ -82,6 +82,13 @@ extern "C" {
 #include "CppUTestExt/MockSupport_c.h"
 #include "I2C.h"
 
+// The shadow register tests check the access counters, off in target builds
+#if !I2C_COUNT_MMIO_ACCESSES
+#error "Build the HAL and its tests with -DI2C_COUNT_MMIO_ACCESSES=1"
+#endif
+
+// Also built with -DI2C_PROFILE_SENSOR_NODE, the tests of the disabled features are left out
+
 #define EXPECTED_I2C_EXTERNAL_INTERRUPT_PRIORITY 1
 typedef struct {
     __IO uint32_t IdRev;
@@ -98,6 +105,9 @@ typedef struct {
 } MockI2CRegisters;
 
 MockI2CRegisters MOCK_HAL_I2C;
+MockI2CRegisters MOCK_HAL_I2C_2;
+
+void ExternalInterrupts_I2cIrqHandler(void);
 
 #define T_PCLK      20    // ns
 #define HAL_TPM     ((MOCK_HAL_I2C.TPM & I2C_TPM_TPM_MASK) >> I2C_TPM_TPM_OFFSET)
@@ -114,7 +124,14 @@ static void MockTransactionCompleteCallback(I2CReturnCode status)
     mock().actualCall("MockTransactionCompleteCallback").withParameter("status", status);
 }
 
+static void MockSecondTransactionCompleteCallback(I2CReturnCode status)
+{
+    mock().actualCall("MockSecondTransactionCompleteCallback").withParameter("status", status);
+}
+
 static uint8_t default_data_buffer[32];
+static uint8_t default_rx_data_buffer[4];
+static uint8_t large_data_buffer[600]; // Two full data phases and a partial one
 static I2CSetupInfo default_setup;
 static I2CTransactionDescriptor default_transaction;
 static DMACChannelConfig  expected_dmac_channel_config[2];
@@ -126,7 +143,7 @@ static void ResetStaticVariables(void)
     expected_dmac_channel_config[I2C_TX].src_bus_index      = 0;
     expected_dmac_channel_config[I2C_TX].dst_bus_index      = 0;
     expected_dmac_channel_config[I2C_TX].channel_priority   = 1;
-    expected_dmac_channel_config[I2C_TX].src_burst_size     = DMAC_BURST_SIZE_1;
+    expected_dmac_channel_config[I2C_TX].src_burst_size     = DMAC_BURST_SIZE_8;
     expected_dmac_channel_config[I2C_TX].src_transfer_width = DMAC_TRANSFER_WIDTH_BYTE;
     expected_dmac_channel_config[I2C_TX].dst_transfer_width = DMAC_TRANSFER_WIDTH_BYTE;
     expected_dmac_channel_config[I2C_TX].src_handshake_mode = false;
@@ -140,7 +157,7 @@ static void ResetStaticVariables(void)
     expected_dmac_channel_config[I2C_RX].src_bus_index      = 0;
     expected_dmac_channel_config[I2C_RX].dst_bus_index      = 0;
     expected_dmac_channel_config[I2C_RX].channel_priority   = 1;
-    expected_dmac_channel_config[I2C_RX].src_burst_size     = DMAC_BURST_SIZE_1;
+    expected_dmac_channel_config[I2C_RX].src_burst_size     = DMAC_BURST_SIZE_8;
     expected_dmac_channel_config[I2C_RX].src_transfer_width = DMAC_TRANSFER_WIDTH_BYTE;
     expected_dmac_channel_config[I2C_RX].dst_transfer_width = DMAC_TRANSFER_WIDTH_BYTE;
     expected_dmac_channel_config[I2C_RX].src_handshake_mode = true;
@@ -167,13 +184,33 @@ static void ResetStaticVariables(void)
     default_setup.role = I2C_MASTER;
     default_setup.mode = I2C_STANDARD_MODE;
 
-    default_transaction.addressing_mode = I2C_ADDRESSING_MODE_7_BIT;
-    default_transaction.direction       = I2C_TX;
-    default_transaction.data_path       = I2C_USE_FIFO;
-    default_transaction.address         = I2C_ADDR_MAX_7BIT;
-    default_transaction.data            = default_data_buffer;
-    default_transaction.data_count      = sizeof(default_data_buffer);
-    default_transaction.callback        = &(MockTransactionCompleteCallback);
+    for (uint16_t i = 0; i < sizeof(default_rx_data_buffer); i++) {
+        default_rx_data_buffer[i] = 0;
+    }
+
+    for (uint16_t i = 0; i < sizeof(large_data_buffer); i++) {
+        large_data_buffer[i] = 0;
+    }
+
+    default_transaction.type             = I2C_SIMPLE_TRANSACTION;
+    default_transaction.addressing_mode  = I2C_ADDRESSING_MODE_7_BIT;
+    default_transaction.direction        = I2C_TX;
+    default_transaction.data_path        = I2C_USE_FIFO;
+    default_transaction.address          = I2C_ADDR_MAX_7BIT;
+    default_transaction.data             = default_data_buffer;
+    default_transaction.data_count       = sizeof(default_data_buffer);
+    default_transaction.rx_data          = NULL;
+    default_transaction.segments         = NULL;
+    default_transaction.segment_count    = 0;
+    default_transaction.context_callback = NULL;
+    default_transaction.context          = NULL;
+    default_transaction.rx_data_count    = 0;
+    default_transaction.callback         = &(MockTransactionCompleteCallback);
+    default_transaction.dma_priority     = I2C_DMA_PRIORITY_DEFAULT;
+    default_transaction.dma_burst_size   = I2C_DMA_BURST_SIZE_AUTO;
+    default_transaction.crc              = I2C_CRC_NONE;
+    default_transaction.crc_polynomial   = 0;
+    default_transaction.timeout          = 0;
 }
 
 static void ExpectExternalInterruptEnabled(void)
@@ -189,6 +226,7 @@ static void ExpectExternalInterruptDisabled(void)
     .withParameter("source", EXTERNAL_IRQ_I2C_SOURCE);
 }
 
+#if I2C_FEATURE_DMA
 static void ExpectDMACChannelSetup(I2CDirection dir)
 {
     mock().expectOneCall("DMAC_SetupChannel")
@@ -220,6 +258,7 @@ static void ExpectDMACChannelEnabled(void)
     .withParameter("channel", DMAC_CHANNEL_I2C)
     .andReturnValue(DMAC_OK);
 }
+#endif
 
 static void ExpectTransactionComplete(I2CReturnCode status)
 {
@@ -227,6 +266,12 @@ static void ExpectTransactionComplete(I2CReturnCode status)
     .withParameter("status", status);
 }
 
+static void ExpectSecondTransactionComplete(I2CReturnCode status)
+{
+    mock().expectOneCall("MockSecondTransactionCompleteCallback")
+    .withParameter("status", status);
+}
+
 static void InstallMockFunctions(void)
 {
     UT_PTR_SET(DMAC_SetupChannel, DMACMock_SetupChannel);
@@ -250,6 +295,19 @@ static void ResetControllerRegisters(void)
     MOCK_HAL_I2C.IdRev  = 0x020210AB;
 }
 
+static void ResetSecondControllerRegisters(void)
+{
+    MOCK_HAL_I2C_2.IdRev  = 0x020210CD; // Major: 0xC, Minor: 0xD
+    MOCK_HAL_I2C_2.Cfg    = 0x00000001; // 4 bytes FIFO
+    MOCK_HAL_I2C_2.IntEn  = 0x00000000;
+    MOCK_HAL_I2C_2.Status = 0x00000001;
+    MOCK_HAL_I2C_2.Addr   = 0x00000000;
+    MOCK_HAL_I2C_2.Data   = 0x00000000;
+    MOCK_HAL_I2C_2.Ctrl   = 0x00001E00;
+    MOCK_HAL_I2C_2.Cmd    = 0x00000000;
+    MOCK_HAL_I2C_2.Setup  = 0x05252100;
+}
+
 static void CheckTimingParams(const I2CMode mode)
 {
     //
@@ -326,11 +384,13 @@ static void SetupController(I2CRole role,
 
 static void LaunchDefaultTransaction(void)
 {
+#if I2C_FEATURE_DMA
     if ((default_transaction.data_path == I2C_USE_DMA) && (default_transaction.data_count != 0)) {
         ExpectDMACChannelSetup(default_transaction.direction);
         ExpectDMACTransferSetup(default_transaction.direction);
         ExpectDMACChannelEnabled();
     }
+#endif
     ExpectExternalInterruptEnabled();
     LONGS_EQUAL(I2C_OK, I2C_LaunchTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction));
 }
@@ -344,6 +404,45 @@ static void LaunchTransaction(I2CDirection dir,
     LaunchDefaultTransaction();
 }
 
+static void SetupWriteReadTransaction(void)
+{
+    default_transaction.type          = I2C_WRITE_READ_TRANSACTION;
+    default_transaction.data_count    = 2;
+    default_transaction.rx_data       = default_rx_data_buffer;
+    default_transaction.rx_data_count = sizeof(default_rx_data_buffer);
+}
+
+static void SetupLargeTransaction(uint16_t data_count)
+{
+    default_transaction.data       = large_data_buffer;
+    default_transaction.data_count = data_count;
+
+    expected_dmac_transfer_config[I2C_TX].src_address = (uint32_t) large_data_buffer;
+    expected_dmac_transfer_config[I2C_RX].dst_address = (uint32_t) large_data_buffer;
+}
+
+static void DrainFifo(I2CDirection dir,
+                      uint16_t     phase_length)
+{
+    // FIFO interrupts of a data phase, the last FIFO is handled on completion
+    for (uint16_t i = 16; i < phase_length; i += 16) {
+        MOCK_HAL_I2C.Status = (dir == I2C_TX) ? I2C_STATUS_FIFOEMPTY_MASK : I2C_STATUS_FIFOFULL_MASK;
+        LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+    }
+}
+
+static void CheckCtrlRegister(uint32_t     phases,
+                              I2CDirection dir,
+                              uint16_t     data_count)
+{
+    CHECK_EQUAL(phases,
+                MOCK_HAL_I2C.Ctrl & (I2C_CTRL_PHASE_START_MASK | I2C_CTRL_PHASE_ADDR_MASK |
+                                     I2C_CTRL_PHASE_DATA_MASK | I2C_CTRL_PHASE_STOP_MASK));
+    CHECK_EQUAL(dir, (MOCK_HAL_I2C.Ctrl & I2C_CTRL_DIR_MASK) >> I2C_CTRL_DIR_OFFSET);
+    CHECK_EQUAL(data_count & I2C_CTRL_DATACNT_MASK,
+                (MOCK_HAL_I2C.Ctrl & I2C_CTRL_DATACNT_MASK) >> I2C_CTRL_DATACNT_OFFSET);
+}
+
 static void CheckSetupShutdownController(I2CRole role,
                                          I2CMode mode)
 {
@@ -384,6 +483,12 @@ TEST(I2C_DeviceIrqHandler, NullDeviceReturnsInvalidInputData)
     LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_DeviceIrqHandler(NULL));
 }
 
+TEST(I2C_DeviceIrqHandler, UnregisteredDeviceReturnsDeviceNotRegistered)
+{
+    LONGS_EQUAL(I2C_DEVICE_NOT_REGISTERED,
+                I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C_2));
+}
+
 TEST(I2C_DeviceIrqHandler, TxMasterFifoCallbackCalledWithAddrHit)
 {
     LaunchTransaction(I2C_TX, I2C_USE_FIFO);
@@ -430,6 +535,7 @@ TEST(I2C_DeviceIrqHandler, RxMasterFifoCallbackNotCalledWithFifoFull)
     LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
 }
 
+#if I2C_FEATURE_DMA
 TEST(I2C_DeviceIrqHandler, TxMasterDmaCallbackCalledWithAddrHit)
 {
     LaunchTransaction(I2C_TX, I2C_USE_DMA);
@@ -465,6 +571,165 @@ TEST(I2C_DeviceIrqHandler, RxMasterDmaCallbackCalledWithAddrHitError)
     ExpectTransactionComplete(I2C_ADDR_HIT_ERROR);
     LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
 }
+#endif
+
+TEST(I2C_DeviceIrqHandler, WriteReadIssuesRepeatedStartReadPhaseWithoutCallback)
+{
+    SetupWriteReadTransaction();
+    LaunchDefaultTransaction();
+
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+    MOCK_HAL_I2C.Cmd    = I2C_CMD_NO_ACTION;
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+
+    CheckCtrlRegister(I2C_CTRL_PHASE_START_MASK | I2C_CTRL_PHASE_ADDR_MASK |
+                      I2C_CTRL_PHASE_DATA_MASK | I2C_CTRL_PHASE_STOP_MASK,
+                      I2C_RX,
+                      sizeof(default_rx_data_buffer));
+    CHECK((MOCK_HAL_I2C.IntEn & I2C_INTEN_FIFOFULL_MASK) >> I2C_INTEN_FIFOFULL_OFFSET);
+    CHECK_EQUAL(0x01u, (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
+
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+    MOCK_HAL_I2C.Data   = 0xA5;
+    ExpectTransactionComplete(I2C_OK);
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+    for (uint16_t i = 0; i < sizeof(default_rx_data_buffer); i++) {
+        BYTES_EQUAL(0xA5, default_rx_data_buffer[i]);
+    }
+}
+
+#if I2C_FEATURE_DMA
+TEST(I2C_DeviceIrqHandler, WriteReadDmaReprogramsChannelForReadPhase)
+{
+    SetupWriteReadTransaction();
+    expected_dmac_channel_config[I2C_TX].src_burst_size = DMAC_BURST_SIZE_2;
+    expected_dmac_transfer_config[I2C_TX].transfer_size = default_transaction.data_count;
+    LaunchTransaction(I2C_TX, I2C_USE_DMA);
+
+    expected_dmac_channel_config[I2C_RX].src_burst_size = DMAC_BURST_SIZE_4;
+    expected_dmac_transfer_config[I2C_RX].transfer_size = sizeof(default_rx_data_buffer);
+    expected_dmac_transfer_config[I2C_RX].dst_address   = (uint32_t) default_rx_data_buffer;
+    ExpectDMACChannelSetup(I2C_RX);
+    ExpectDMACTransferSetup(I2C_RX);
+    ExpectDMACChannelEnabled();
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+    ExpectTransactionComplete(I2C_OK);
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+}
+#endif
+
+TEST(I2C_DeviceIrqHandler, WriteReadNackReleasesBusBeforeCallback)
+{
+    SetupWriteReadTransaction();
+    LaunchDefaultTransaction();
+
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK;
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+    CheckCtrlRegister(I2C_CTRL_PHASE_STOP_MASK, I2C_TX, 0);
+
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK;
+    ExpectTransactionComplete(I2C_ADDR_HIT_ERROR);
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+    for (uint16_t i = 0; i < sizeof(default_rx_data_buffer); i++) {
+        BYTES_EQUAL(0x00, default_rx_data_buffer[i]);
+    }
+}
+
+TEST(I2C_DeviceIrqHandler, LargeFifoTransferIsSplitIntoContinuedDataPhases)
+{
+    uint16_t phase_lengths[] = {256, 256, 88};
+
+    SetupLargeTransaction(sizeof(large_data_buffer));
+
+    for (I2CDirection dir = I2C_TX; dir <= I2C_RX; dir++) {
+        LaunchTransaction(dir, I2C_USE_FIFO);
+        MOCK_HAL_I2C.Data = 0x5A;
+
+        for (uint8_t i = 1; i < 3; i++) {
+            DrainFifo(dir, phase_lengths[i - 1]);
+            MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+            MOCK_HAL_I2C.Cmd    = I2C_CMD_NO_ACTION;
+            LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+
+            // Same direction, no START nor ADDR, STOP only with the last data phase
+            CheckCtrlRegister(I2C_CTRL_PHASE_DATA_MASK |
+                              ((i == 2) ? I2C_CTRL_PHASE_STOP_MASK : 0),
+                              dir,
+                              phase_lengths[i]);
+            CHECK_EQUAL(0x01u, (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
+        }
+
+        // Single completion for the whole transfer
+        DrainFifo(dir, phase_lengths[2]);
+        MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+        MOCK_HAL_I2C.Cmd    = I2C_CMD_NO_ACTION;
+        ExpectTransactionComplete(I2C_OK);
+        LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+    }
+
+    for (uint16_t i = 0; i < sizeof(large_data_buffer); i++) {
+        BYTES_EQUAL(0x5A, large_data_buffer[i]);
+    }
+}
+
+#if I2C_FEATURE_DMA
+TEST(I2C_DeviceIrqHandler, LargeDmaTransferReprogramsChannelForEachDataPhase)
+{
+    uint16_t phase_lengths[] = {256, 256, 88};
+
+    SetupLargeTransaction(sizeof(large_data_buffer));
+    expected_dmac_transfer_config[I2C_TX].transfer_size = phase_lengths[0];
+    LaunchTransaction(I2C_TX, I2C_USE_DMA);
+
+    for (uint8_t i = 1; i < 3; i++) {
+        expected_dmac_transfer_config[I2C_TX].transfer_size = phase_lengths[i];
+        expected_dmac_transfer_config[I2C_TX].src_address   =
+            (uint32_t) &(large_data_buffer[i * 256]);
+        ExpectDMACChannelSetup(I2C_TX);
+        ExpectDMACTransferSetup(I2C_TX);
+        ExpectDMACChannelEnabled();
+        MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+        MOCK_HAL_I2C.Cmd    = I2C_CMD_NO_ACTION;
+        LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+        CheckCtrlRegister(I2C_CTRL_PHASE_DATA_MASK |
+                          ((i == 2) ? I2C_CTRL_PHASE_STOP_MASK : 0),
+                          I2C_TX,
+                          phase_lengths[i]);
+    }
+
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+    ExpectTransactionComplete(I2C_OK);
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+}
+#endif
+
+TEST(I2C_DeviceIrqHandler, LargeWriteReadSplitsTheReadPhase)
+{
+    SetupWriteReadTransaction();
+    default_transaction.rx_data       = large_data_buffer;
+    default_transaction.rx_data_count = 300;
+    LaunchDefaultTransaction();
+
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+    MOCK_HAL_I2C.Cmd    = I2C_CMD_NO_ACTION;
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+    CheckCtrlRegister(I2C_CTRL_PHASE_START_MASK | I2C_CTRL_PHASE_ADDR_MASK |
+                      I2C_CTRL_PHASE_DATA_MASK,
+                      I2C_RX,
+                      256);
+
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+    MOCK_HAL_I2C.Cmd    = I2C_CMD_NO_ACTION;
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+    CheckCtrlRegister(I2C_CTRL_PHASE_DATA_MASK | I2C_CTRL_PHASE_STOP_MASK, I2C_RX, 44);
+
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+    ExpectTransactionComplete(I2C_OK);
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+}
 
 TEST(I2C_DeviceIrqHandler, NullCallbackDoesNotSnag)
 {
@@ -517,6 +782,13 @@ TEST(I2C_LaunchTransaction, NullDescriptorReturnsInvalidInputData)
                 I2C_LaunchTransaction((I2CRegisters*) &MOCK_HAL_I2C, NULL));
 }
 
+TEST(I2C_LaunchTransaction, UnregisteredDeviceReturnsDeviceNotRegistered)
+{
+    LONGS_EQUAL(I2C_DEVICE_NOT_REGISTERED,
+                I2C_LaunchTransaction((I2CRegisters*) &MOCK_HAL_I2C_2, &default_transaction));
+}
+
+#if I2C_VALIDATION_LEVEL == I2C_VALIDATION_FULL
 TEST(I2C_LaunchTransaction, NullDataBufferWithNonZeroLengthReturnsInvalidInputData)
 {
     default_transaction.data = NULL;
@@ -539,14 +811,28 @@ TEST(I2C_LaunchTransaction, RxMasterWithNullDataBufferAndZeroDataLengthReturnsIn
     LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
                 I2C_LaunchTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction));
 }
+#endif
 
-TEST(I2C_LaunchTransaction, MoreThan256bytesReturnsInvalidInputData)
+TEST(I2C_LaunchTransaction, MoreThan256bytesKeepsTheBusAfterFirstDataPhase)
 {
-    default_transaction.data_count = 257;
-    LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
-                I2C_LaunchTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction));
+    SetupLargeTransaction(sizeof(large_data_buffer));
+
+    for (I2CDataPath path = I2C_USE_FIFO; path <= I2C_USE_DMA; path++) {
+        for (I2CDirection dir = I2C_TX; dir <= I2C_RX; dir++) {
+            expected_dmac_transfer_config[dir].transfer_size = 256;
+            LaunchTransaction(dir, path);
+
+            // No STOP phase: the next 256 bytes follow as a continued data phase
+            CheckCtrlRegister(I2C_CTRL_PHASE_START_MASK | I2C_CTRL_PHASE_ADDR_MASK |
+                              I2C_CTRL_PHASE_DATA_MASK,
+                              dir,
+                              256);
+            MOCK_HAL_I2C.Cmd = I2C_CMD_NO_ACTION;
+        }
+    }
 }
 
+#if I2C_VALIDATION_LEVEL == I2C_VALIDATION_FULL
 TEST(I2C_LaunchTransaction, OutOfBound10bitAddressReturnsInvalidInputData)
 {
     default_transaction.addressing_mode = I2C_ADDRESSING_MODE_10_BIT;
@@ -563,9 +849,56 @@ TEST(I2C_LaunchTransaction, OutOfBound7bitAddressReturnsInvalidInputData)
                 I2C_LaunchTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction));
 }
 
+TEST(I2C_LaunchTransaction, UnsupportedTransactionTypeReturnsInvalidInputData)
+{
+    default_transaction.type = I2C_UNSUPPORTED_TRANSACTION;
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
+                I2C_LaunchTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction));
+}
+
+TEST(I2C_LaunchTransaction, WriteReadWithInvalidDescriptorReturnsInvalidInputData)
+{
+    SetupWriteReadTransaction();
+    default_transaction.rx_data = NULL;
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
+                I2C_LaunchTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction));
+
+    SetupWriteReadTransaction();
+    default_transaction.rx_data_count = 0;
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
+                I2C_LaunchTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction));
+
+    SetupWriteReadTransaction();
+    default_transaction.direction = I2C_RX;
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
+                I2C_LaunchTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction));
+
+    SetupWriteReadTransaction();
+    default_transaction.data       = NULL;
+    default_transaction.data_count = 0;
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
+                I2C_LaunchTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction));
+}
+#endif
+
+#if (I2C_VALIDATION_LEVEL == I2C_VALIDATION_FULL) && I2C_FEATURE_DMA
+TEST(I2C_LaunchTransaction, UnsupportedDmaSettingsReturnInvalidInputData)
+{
+    default_transaction.dma_priority = I2C_DMA_PRIORITY_UNSUPPORTED;
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
+                I2C_LaunchTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction));
+
+    default_transaction.dma_priority   = I2C_DMA_PRIORITY_DEFAULT;
+    default_transaction.dma_burst_size = I2C_DMA_BURST_SIZE_UNSUPPORTED;
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
+                I2C_LaunchTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction));
+}
+#endif
+
 TEST(I2C_LaunchTransaction, NotEnabledReturnsControllerNotEnabled)
 {
-    MOCK_HAL_I2C.Setup &= ~I2C_SETUP_IICEN_MASK;
+    ExpectExternalInterruptDisabled();
+    LONGS_EQUAL(I2C_OK, I2C_ShutdownController((I2CRegisters*) &MOCK_HAL_I2C));
     LONGS_EQUAL(I2C_CONTROLLER_NOT_ENABLED,
                 I2C_LaunchTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction));
 }
@@ -590,6 +923,7 @@ TEST(I2C_LaunchTransaction, MasterFifoSetsDataCountToZeroWhenSending256bytes)
     }
 }
 
+#if I2C_FEATURE_DMA
 TEST(I2C_LaunchTransaction, MasterDmaSetsDataCountToZeroWhenSending256bytes)
 {
     MOCK_HAL_I2C.Ctrl             |= I2C_CTRL_DATACNT_MASK;
@@ -603,7 +937,9 @@ TEST(I2C_LaunchTransaction, MasterDmaSetsDataCountToZeroWhenSending256bytes)
         MOCK_HAL_I2C.Cmd = I2C_CMD_NO_ACTION;
     }
 }
+#endif
 
+#if I2C_FEATURE_10_BIT_ADDRESSING
 TEST(I2C_LaunchTransaction, Master10bitsAddressingMode)
 {
     default_transaction.addressing_mode = I2C_ADDRESSING_MODE_10_BIT;
@@ -618,6 +954,7 @@ TEST(I2C_LaunchTransaction, Master10bitsAddressingMode)
         }
     }
 }
+#endif
 
 TEST(I2C_LaunchTransaction, TxMasterWithNullDataBufferAndZeroDataLengthLaunchesScan)
 {
@@ -710,6 +1047,7 @@ TEST(I2C_LaunchTransaction, RxMasterFifoWorksAsExpected)
     CHECK_EQUAL(0x01u, (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
 }
 
+#if I2C_FEATURE_DMA
 TEST(I2C_LaunchTransaction, TxMasterDmaWorksAsExpected)
 {
     LaunchTransaction(I2C_TX, I2C_USE_DMA);
@@ -779,80 +1117,110 @@ TEST(I2C_LaunchTransaction, RxMasterDmaWorksAsExpected)
     // Check Command Register equals "Issue Transaction"
     CHECK_EQUAL(0x01u, (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
 }
+#endif
 
-TEST_GROUP(I2C_ShutdownController)
+#if I2C_FEATURE_DMA
+TEST(I2C_LaunchTransaction, MasterDmaUsesDescriptorPriorityAndBurstSize)
 {
-    void setup(void)
-    {
-        mock().strictOrder();
-        ResetControllerRegisters();
-        LONGS_EQUAL(I2C_OK, I2C_Create((I2CRegisters*) &MOCK_HAL_I2C));
-    }
+    default_transaction.dma_priority   = I2C_DMA_PRIORITY_LOW;
+    default_transaction.dma_burst_size = I2C_DMA_BURST_SIZE_16;
 
-    void teardown(void)
-    {
-        mock().checkExpectations();
-        mock().clear();
+    for (I2CDirection dir = I2C_TX; dir <= I2C_RX; dir++) {
+        expected_dmac_channel_config[dir].channel_priority = 0;
+        expected_dmac_channel_config[dir].src_burst_size   = DMAC_BURST_SIZE_16;
+        LaunchTransaction(dir, I2C_USE_DMA);
+        MOCK_HAL_I2C.Cmd = I2C_CMD_NO_ACTION;
     }
-};
 
-TEST(I2C_ShutdownController, NullDeviceReturnsInvalidInputData)
-{
-    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_ShutdownController(NULL));
+    default_transaction.dma_priority   = I2C_DMA_PRIORITY_HIGH;
+    default_transaction.dma_burst_size = I2C_DMA_BURST_SIZE_1;
+    expected_dmac_channel_config[I2C_TX].channel_priority = 1;
+    expected_dmac_channel_config[I2C_TX].src_burst_size   = DMAC_BURST_SIZE_1;
+    LaunchTransaction(I2C_TX, I2C_USE_DMA);
 }
 
-TEST_GROUP(I2C_SetupController)
+TEST(I2C_LaunchTransaction, MasterDmaBurstSizeSplitsDataPhaseInWholeBursts)
 {
-    void setup(void)
-    {
-        mock().strictOrder();
-        ResetControllerRegisters();
-        LONGS_EQUAL(I2C_OK, I2C_Create((I2CRegisters*) &MOCK_HAL_I2C));
-    }
-
-    void teardown(void)
-    {
-        mock().checkExpectations();
-        mock().clear();
-    }
-};
+    // 6 bytes: neither 8 (half the FIFO) nor 4 bytes bursts fit
+    default_transaction.data_count                      = 6;
+    expected_dmac_channel_config[I2C_TX].src_burst_size = DMAC_BURST_SIZE_2;
+    expected_dmac_transfer_config[I2C_TX].transfer_size = 6;
+    LaunchTransaction(I2C_TX, I2C_USE_DMA);
+}
 
-TEST(I2C_SetupController, NullDeviceReturnsInvalidInputData)
+TEST(I2C_LaunchTransaction, MasterDmaBurstSizeIsLimitedToFifoSize)
 {
-    I2CSetupInfo setup_info = {I2C_MASTER, I2C_STANDARD_MODE};
+    MOCK_HAL_I2C.Cfg = 0x00000001; // 4 bytes FIFO
+    LONGS_EQUAL(I2C_OK, I2C_Create((I2CRegisters*) &MOCK_HAL_I2C));
 
-    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_SetupController(NULL, &setup_info));
+    default_transaction.dma_burst_size                  = I2C_DMA_BURST_SIZE_16;
+    expected_dmac_channel_config[I2C_RX].src_burst_size = DMAC_BURST_SIZE_4;
+    LaunchTransaction(I2C_RX, I2C_USE_DMA);
 }
+#endif
 
-TEST(I2C_SetupController, NullSetupInfoReturnsInvalidInputData)
+TEST(I2C_LaunchTransaction, WriteReadWritePhaseKeepsTheBus)
 {
-    LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
-                I2C_SetupController((I2CRegisters*) &MOCK_HAL_I2C, NULL));
-}
+    SetupWriteReadTransaction();
+    expected_dmac_channel_config[I2C_TX].src_burst_size = DMAC_BURST_SIZE_2;
 
-TEST(I2C_SetupController, UnsupportedModeReturnsInvalidInputData)
-{
-    I2CSetupInfo setup_info = {I2C_MASTER, I2C_UNSUPPORTED_MODE};
+    for (I2CDataPath path = I2C_USE_FIFO; path <= I2C_USE_DMA; path++) {
+        expected_dmac_transfer_config[I2C_TX].transfer_size = default_transaction.data_count;
+        LaunchTransaction(I2C_TX, path);
 
-    LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
-                I2C_SetupController((I2CRegisters*) &MOCK_HAL_I2C, &setup_info));
+        // No STOP phase: the read phase follows with a repeated START
+        CheckCtrlRegister(I2C_CTRL_PHASE_START_MASK | I2C_CTRL_PHASE_ADDR_MASK |
+                          I2C_CTRL_PHASE_DATA_MASK,
+                          I2C_TX,
+                          default_transaction.data_count);
+        CHECK_EQUAL(0x01u, (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
+        MOCK_HAL_I2C.Cmd = I2C_CMD_NO_ACTION;
+    }
 }
 
-TEST(I2C_SetupController, SetupShutdownWorksAsExpected)
+TEST(I2C_LaunchTransaction, RepeatedTransactionSkipsUnchangedRegisterWrites)
 {
-    CheckSetupShutdownController(I2C_MASTER, I2C_STANDARD_MODE);
-    CheckSetupShutdownController(I2C_SLAVE, I2C_STANDARD_MODE);
-    CheckSetupShutdownController(I2C_MASTER, I2C_FAST_MODE);
-    CheckSetupShutdownController(I2C_SLAVE, I2C_FAST_MODE);
-    CheckSetupShutdownController(I2C_MASTER, I2C_FAST_MODE_PLUS);
-    CheckSetupShutdownController(I2C_SLAVE, I2C_FAST_MODE_PLUS);
+    I2CStats* stats = NULL;
+
+    LONGS_EQUAL(I2C_OK, I2C_GetStats((I2CRegisters*) &MOCK_HAL_I2C, &stats));
+    default_transaction.data_count = 4;
+
+    for (uint8_t i = 0; i < 2; i++) {
+        uint32_t reads  = stats->mmio_reads;
+        uint32_t writes = stats->mmio_writes;
+
+        // Setup, transaction and completion as done by the wrapper
+        LONGS_EQUAL(I2C_OK, I2C_SetupController((I2CRegisters*) &MOCK_HAL_I2C, &default_setup));
+        LaunchDefaultTransaction();
+        MOCK_HAL_I2C.Cmd    = I2C_CMD_NO_ACTION;
+        MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+        ExpectTransactionComplete(I2C_OK);
+        LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+
+        // Read-modify-writes took 29 reads and 30 writes for the same transaction.
+        // Only the first one writes Addr and IntEn, then Cmd and Status are read,
+        // Ctrl, Data, Cmd and Status written.
+        CHECK_EQUAL(2, stats->mmio_reads - reads);
+        CHECK_EQUAL((i == 0) ? 9 : 7, stats->mmio_writes - writes);
+    }
 }
 
-TEST_GROUP(I2C_Create)
+TEST_GROUP(I2C_PrepareTransaction)
 {
+    I2CPreparedTransaction prepared;
+    I2CStats*              stats;
+
     void setup(void)
     {
         mock().strictOrder();
+        InstallMockFunctions();
+        ResetControllerRegisters();
+        ResetStaticVariables();
+        LONGS_EQUAL(I2C_OK, I2C_Create((I2CRegisters*) &MOCK_HAL_I2C));
+        LONGS_EQUAL(I2C_OK, I2C_SetupController((I2CRegisters*) &MOCK_HAL_I2C, &default_setup));
+        LONGS_EQUAL(I2C_OK, I2C_GetStats((I2CRegisters*) &MOCK_HAL_I2C, &stats));
+        default_transaction.address    = 0x40;
+        default_transaction.data_count = 3;
     }
 
     void teardown(void)
@@ -860,45 +1228,2834 @@ TEST_GROUP(I2C_Create)
         mock().checkExpectations();
         mock().clear();
     }
-};
 
-TEST(I2C_Create, NullDeviceReturnsInvalidInputData)
-{
-    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_Create(NULL));
-}
+    void Prepare(void)
+    {
+        LONGS_EQUAL(I2C_OK,
+                    I2C_PrepareTransaction((I2CRegisters*) &MOCK_HAL_I2C,
+                                           &default_transaction,
+                                           &prepared));
+    }
 
-TEST_GROUP(I2C_GetConfig)
-{
-    void setup(void)
+    void LaunchPrepared(void)
     {
-        mock().strictOrder();
-        ResetStaticVariables();
-        ResetControllerRegisters();
-        LONGS_EQUAL(I2C_OK, I2C_Create((I2CRegisters*) &MOCK_HAL_I2C));
+        ExpectExternalInterruptEnabled();
+        LONGS_EQUAL(I2C_OK, I2C_LaunchPreparedTransaction(&prepared));
     }
 
-    void teardown(void)
+    void Complete(void)
     {
-        mock().checkExpectations();
-        mock().clear();
+        ExpectTransactionComplete(I2C_OK);
+        MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+        MOCK_HAL_I2C.Cmd    = I2C_CMD_NO_ACTION;
+        LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
     }
 };
 
-TEST(I2C_GetConfig, NullDeviceReturnsInvalidInputData)
+TEST(I2C_PrepareTransaction, InvalidInputReturnsError)
 {
-    I2CConfig* return_value;
-
-    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_GetConfig(NULL, &return_value));
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
+                I2C_PrepareTransaction(NULL, &default_transaction, &prepared));
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
+                I2C_PrepareTransaction((I2CRegisters*) &MOCK_HAL_I2C, NULL, &prepared));
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
+                I2C_PrepareTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction, NULL));
+#if I2C_VALIDATION_LEVEL == I2C_VALIDATION_FULL
+    default_transaction.data = NULL;
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
+                I2C_PrepareTransaction((I2CRegisters*) &MOCK_HAL_I2C,
+                                       &default_transaction,
+                                       &prepared));
+#endif
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_LaunchPreparedTransaction(NULL));
 }
 
-TEST(I2C_GetConfig, NullReturnValueReturnsInvalidInputData)
+TEST(I2C_PrepareTransaction, UnregisteredDeviceReturnsDeviceNotRegistered)
 {
-    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_GetConfig((I2CRegisters*) &MOCK_HAL_I2C, NULL));
+    LONGS_EQUAL(I2C_DEVICE_NOT_REGISTERED,
+                I2C_PrepareTransaction((I2CRegisters*) &MOCK_HAL_I2C_2,
+                                       &default_transaction,
+                                       &prepared));
+    Prepare();
+    prepared.i2c_dev = (I2CRegisters*) &MOCK_HAL_I2C_2;
+    LONGS_EQUAL(I2C_DEVICE_NOT_REGISTERED, I2C_LaunchPreparedTransaction(&prepared));
 }
 
-TEST(I2C_GetConfig, ReturnsConfig)
+TEST(I2C_PrepareTransaction, ShutdownControllerReturnsControllerNotEnabled)
 {
-    I2CConfig* i2c_config;
+    Prepare();
+    ExpectExternalInterruptDisabled();
+    LONGS_EQUAL(I2C_OK, I2C_ShutdownController((I2CRegisters*) &MOCK_HAL_I2C));
+    LONGS_EQUAL(I2C_CONTROLLER_NOT_ENABLED, I2C_LaunchPreparedTransaction(&prepared));
+}
+
+TEST(I2C_PrepareTransaction, PrepareDoesNotTouchTheController)
+{
+    uint32_t mmio_reads  = stats->mmio_reads;
+    uint32_t mmio_writes = stats->mmio_writes;
+
+    Prepare();
+    LONGS_EQUAL(mmio_reads, stats->mmio_reads);
+    LONGS_EQUAL(mmio_writes, stats->mmio_writes);
+    CHECK_EQUAL(0x40u, prepared.addr);
+    CHECK_EQUAL(I2C_CTRL_PHASE_START_MASK | I2C_CTRL_PHASE_ADDR_MASK | I2C_CTRL_PHASE_DATA_MASK |
+                I2C_CTRL_PHASE_STOP_MASK | (3 << I2C_CTRL_DATACNT_OFFSET),
+                prepared.ctrl);
+}
+
+TEST(I2C_PrepareTransaction, PreparedLaunchWritesSameRegistersAsLaunch)
+{
+    Prepare();
+    LaunchPrepared();
+    Complete();
+
+    // Same target again: the Addr and Setup images are already in the controller
+    uint32_t mmio_writes = stats->mmio_writes;
+
+    LaunchPrepared();
+    uint32_t prepared_writes = stats->mmio_writes - mmio_writes;
+    uint32_t ctrl            = MOCK_HAL_I2C.Ctrl;
+    uint32_t int_en          = MOCK_HAL_I2C.IntEn;
+
+    Complete();
+    mmio_writes = stats->mmio_writes;
+    LaunchDefaultTransaction();
+
+    LONGS_EQUAL(prepared_writes, stats->mmio_writes - mmio_writes);
+    CHECK_EQUAL(ctrl, MOCK_HAL_I2C.Ctrl);
+    CHECK_EQUAL(int_en, MOCK_HAL_I2C.IntEn);
+    CHECK_EQUAL(0x40u, (MOCK_HAL_I2C.Addr & I2C_ADDR_ADDR_MASK) >> I2C_ADDR_ADDR_OFFSET);
+    CHECK_EQUAL(I2C_CMD_ISSUE_TRANSACTION,
+                (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
+}
+
+TEST(I2C_PrepareTransaction, PreparedLaunchRegisterAccesses)
+{
+    default_transaction.data_path = I2C_USE_AUTO;
+    Prepare();
+    LaunchPrepared();
+    Complete();
+
+    // Repeated launch to the same target, as counted by I2C_COUNT_MMIO_ACCESSES: Cmd is read to
+    // check the controller is idle, then Ctrl, the three data bytes and Cmd are written
+    uint32_t mmio_reads  = stats->mmio_reads;
+    uint32_t mmio_writes = stats->mmio_writes;
+
+    LaunchPrepared();
+    LONGS_EQUAL(1, stats->mmio_reads - mmio_reads);
+    LONGS_EQUAL(5, stats->mmio_writes - mmio_writes);
+    Complete();
+
+    // The same launch without preparation costs exactly as many accesses
+    mmio_reads  = stats->mmio_reads;
+    mmio_writes = stats->mmio_writes;
+    LaunchDefaultTransaction();
+    LONGS_EQUAL(1, stats->mmio_reads - mmio_reads);
+    LONGS_EQUAL(5, stats->mmio_writes - mmio_writes);
+}
+
+TEST(I2C_PrepareTransaction, PreparedDescriptorIsLaunchedRepeatedly)
+{
+    Prepare();
+    for (uint8_t i = 0; i < 3; i++) {
+        default_data_buffer[2] = i;
+        LaunchPrepared();
+        BYTES_EQUAL(i, MOCK_HAL_I2C.Data);
+        Complete();
+        LONGS_EQUAL(I2C_OK, default_transaction.status);
+    }
+}
+
+TEST(I2C_PrepareTransaction, LargeDescriptorKeepsTheBusAfterFirstPhase)
+{
+    SetupLargeTransaction(sizeof(large_data_buffer));
+    Prepare();
+    LaunchPrepared();
+
+    CheckCtrlRegister(I2C_CTRL_PHASE_START_MASK | I2C_CTRL_PHASE_ADDR_MASK |
+                      I2C_CTRL_PHASE_DATA_MASK,
+                      I2C_TX,
+                      256);
+}
+
+TEST(I2C_PrepareTransaction, WriteReadKeepsTheBusForTheReadPhase)
+{
+    SetupWriteReadTransaction();
+    Prepare();
+    LaunchPrepared();
+
+    CheckCtrlRegister(I2C_CTRL_PHASE_START_MASK | I2C_CTRL_PHASE_ADDR_MASK |
+                      I2C_CTRL_PHASE_DATA_MASK,
+                      I2C_TX,
+                      2);
+}
+
+#define OTHER_CRC8_POLYNOMIAL 0x31u // x^8 + x^5 + x^4 + 1
+
+// Bitwise reference, independent of the HAL implementation
+static uint8_t ReferenceCrc8(const uint8_t* data,
+                             uint16_t       count,
+                             uint8_t        polynomial)
+{
+    uint8_t crc = 0;
+
+    for (uint16_t i = 0; i < count; i++) {
+        for (int8_t bit = 7; bit >= 0; bit--) {
+            bool msb = ((crc >> 7) ^ (data[i] >> bit)) & 1u;
+
+            crc = (uint8_t) (crc << 1);
+            if (msb) {
+                crc ^= polynomial;
+            }
+        }
+    }
+    return crc;
+}
+
+TEST_GROUP(I2C_Crc)
+{
+    void setup(void)
+    {
+        mock().strictOrder();
+        mock().installComparator("DMACChannelConfig*", channel_config_comparator);
+        mock().installComparator("DMACTransferConfig*", transfer_config_comparator);
+        InstallMockFunctions();
+        ResetControllerRegisters();
+        ResetStaticVariables();
+        LONGS_EQUAL(I2C_OK, I2C_Create((I2CRegisters*) &MOCK_HAL_I2C));
+        LONGS_EQUAL(I2C_OK, I2C_SetupController((I2CRegisters*) &MOCK_HAL_I2C, &default_setup));
+        default_transaction.address        = 0x40;
+        default_transaction.crc            = I2C_CRC_DATA;
+        default_transaction.crc_polynomial = I2C_CRC8_SMBUS_POLYNOMIAL;
+    }
+
+    void teardown(void)
+    {
+        mock().checkExpectations();
+        mock().clear();
+        mock().removeAllComparatorsAndCopiers();
+    }
+
+    void Complete(I2CReturnCode expected)
+    {
+        ExpectTransactionComplete(expected);
+        MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+        MOCK_HAL_I2C.Cmd    = I2C_CMD_NO_ACTION;
+        LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+        LONGS_EQUAL(expected, default_transaction.status);
+    }
+};
+
+#if I2C_VALIDATION_LEVEL == I2C_VALIDATION_FULL
+TEST(I2C_Crc, InvalidCrcDescriptorReturnsInvalidInputData)
+{
+    default_transaction.crc = I2C_CRC_UNSUPPORTED;
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
+                I2C_LaunchTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction));
+
+    // No data to cover
+    default_transaction.crc        = I2C_CRC_DATA;
+    default_transaction.data       = NULL;
+    default_transaction.data_count = 0;
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
+                I2C_LaunchTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction));
+
+    default_transaction.crc             = I2C_CRC_PEC;
+    default_transaction.data            = default_data_buffer;
+    default_transaction.data_count      = 2;
+    default_transaction.addressing_mode = I2C_ADDRESSING_MODE_10_BIT;
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
+                I2C_LaunchTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction));
+
+    // No room for the CRC byte in a data phase count
+    default_transaction.crc             = I2C_CRC_DATA;
+    default_transaction.addressing_mode = I2C_ADDRESSING_MODE_7_BIT;
+    default_transaction.data_count      = UINT16_MAX;
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
+                I2C_LaunchTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction));
+}
+#endif
+
+TEST(I2C_Crc, FifoWriteEndsWithGeneratedCrc)
+{
+    const char* check = "123456789";
+
+    memcpy(default_data_buffer, check, 9);
+    default_data_buffer[9]         = 0x5A;
+    default_transaction.data_count = 9;
+    LaunchDefaultTransaction();
+
+    // CRC-8/SMBUS check value, sent after the data without touching the buffer
+    CheckCtrlRegister(I2C_CTRL_PHASE_START_MASK | I2C_CTRL_PHASE_ADDR_MASK |
+                      I2C_CTRL_PHASE_DATA_MASK | I2C_CTRL_PHASE_STOP_MASK,
+                      I2C_TX,
+                      10);
+    BYTES_EQUAL(0xF4, MOCK_HAL_I2C.Data);
+    BYTES_EQUAL(0x5A, default_data_buffer[9]);
+    Complete(I2C_OK);
+}
+
+TEST(I2C_Crc, PecCoversTheAddressByte)
+{
+    uint8_t expected[3] = { 0x40 << 1, 0x12, 0x34 };
+
+    default_transaction.crc        = I2C_CRC_PEC;
+    default_data_buffer[0]         = 0x12;
+    default_data_buffer[1]         = 0x34;
+    default_transaction.data_count = 2;
+    LaunchDefaultTransaction();
+
+    BYTES_EQUAL(ReferenceCrc8(expected, 3, I2C_CRC8_SMBUS_POLYNOMIAL), MOCK_HAL_I2C.Data);
+}
+
+TEST(I2C_Crc, CrcIsGeneratedAcrossFifoRefills)
+{
+    for (uint8_t i = 0; i < 31; i++) {
+        default_data_buffer[i] = i;
+    }
+    default_transaction.data_count     = 31;
+    default_transaction.crc_polynomial = OTHER_CRC8_POLYNOMIAL;
+    LaunchDefaultTransaction();
+    MOCK_HAL_I2C.Status = I2C_STATUS_FIFOEMPTY_MASK;
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+
+    BYTES_EQUAL(ReferenceCrc8(default_data_buffer, 31, OTHER_CRC8_POLYNOMIAL), MOCK_HAL_I2C.Data);
+    BYTES_EQUAL(0, default_data_buffer[31]);
+}
+
+TEST(I2C_Crc, RelaunchedWriteSendsTheSameCrc)
+{
+    default_data_buffer[0]         = 0x12;
+    default_transaction.data_count = 1;
+    LaunchDefaultTransaction();
+    uint8_t crc = (uint8_t) MOCK_HAL_I2C.Data;
+    Complete(I2C_OK);
+
+    // The buffer is unchanged: a second launch sends the same bytes
+    LaunchDefaultTransaction();
+    BYTES_EQUAL(crc, MOCK_HAL_I2C.Data);
+    BYTES_EQUAL(0x12, default_data_buffer[0]);
+    BYTES_EQUAL(0, default_data_buffer[1]);
+    Complete(I2C_OK);
+}
+
+#if I2C_FEATURE_DMA
+TEST(I2C_Crc, DmaWriteSendsTheCrcAfterTheBuffer)
+{
+    for (uint8_t i = 0; i < 31; i++) {
+        default_data_buffer[i] = 0xA0 + i;
+    }
+    default_data_buffer[31]                             = 0x5A;
+    default_transaction.crc                             = I2C_CRC_PEC;
+    default_transaction.data_count                      = 31;
+    expected_dmac_transfer_config[I2C_TX].transfer_size = 31;
+    expected_dmac_channel_config[I2C_TX].src_burst_size = DMAC_BURST_SIZE_1;
+    LaunchTransaction(I2C_TX, I2C_USE_DMA);
+    CheckCtrlRegister(I2C_CTRL_PHASE_START_MASK | I2C_CTRL_PHASE_ADDR_MASK |
+                      I2C_CTRL_PHASE_DATA_MASK | I2C_CTRL_PHASE_STOP_MASK,
+                      I2C_TX,
+                      32);
+
+    // One byte transfer from the HAL storage once the buffer is sent
+    mock().expectOneCall("DMAC_SetupTransfer").ignoreOtherParameters().andReturnValue(DMAC_OK);
+    ExpectDMACChannelEnabled();
+    I2C_DMACCallback(DMAC_TERMINAL_COUNT);
+
+    BYTES_EQUAL(0x5A, default_data_buffer[31]);
+    I2C_DMACCallback(DMAC_TERMINAL_COUNT);
+    Complete(I2C_OK);
+}
+#endif
+
+TEST(I2C_Crc, FifoReadWithValidCrcCompletes)
+{
+    // 0x00 0x00 0x00: the CRC of two zero bytes is zero
+    default_transaction.data_count = 3;
+    LaunchTransaction(I2C_RX, I2C_USE_FIFO);
+    MOCK_HAL_I2C.Data = 0x00;
+    Complete(I2C_OK);
+}
+
+TEST(I2C_Crc, FifoReadWithCorruptedCrcReportsCrcError)
+{
+    default_transaction.data_count = 3;
+    LaunchTransaction(I2C_RX, I2C_USE_FIFO);
+    MOCK_HAL_I2C.Data = 0x5A;
+    Complete(I2C_CRC_ERROR);
+}
+
+#if I2C_FEATURE_DMA
+TEST(I2C_Crc, DmaReadIsCheckedOverTheFinishedBuffer)
+{
+    uint8_t pec[33];
+
+    default_transaction.crc = I2C_CRC_PEC;
+    LaunchTransaction(I2C_RX, I2C_USE_DMA);
+
+    // Bytes written by the DMA, checked on completion
+    pec[0] = (0x40 << 1) | 1;
+    for (uint8_t i = 0; i < 31; i++) {
+        default_data_buffer[i] = i * 7;
+        pec[i + 1]             = default_data_buffer[i];
+    }
+    default_data_buffer[31] = ReferenceCrc8(pec, 32, I2C_CRC8_SMBUS_POLYNOMIAL);
+    Complete(I2C_OK);
+
+    default_data_buffer[31] ^= 0x01;
+    LaunchTransaction(I2C_RX, I2C_USE_DMA);
+    Complete(I2C_CRC_ERROR);
+}
+#endif
+
+TEST(I2C_Crc, WriteReadDataCrcOnlyCoversTheReadBytes)
+{
+    SetupWriteReadTransaction();
+    default_data_buffer[0] = 0xAA;
+    default_data_buffer[1] = 0xBB;
+    LaunchDefaultTransaction();
+    BYTES_EQUAL(0xBB, default_data_buffer[1]);
+
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+    MOCK_HAL_I2C.Cmd    = I2C_CMD_NO_ACTION;
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+
+    // All zero read bytes only pass if the written bytes are excluded
+    MOCK_HAL_I2C.Data = 0x00;
+    Complete(I2C_OK);
+}
+
+static uint32_t addr_at_callback;
+static uint32_t cmd_at_callback;
+
+static void RecordingTransactionCompleteCallback(I2CReturnCode status)
+{
+    // Snapshot the bus state seen by the completion callback
+    addr_at_callback = (MOCK_HAL_I2C.Addr & I2C_ADDR_ADDR_MASK) >> I2C_ADDR_ADDR_OFFSET;
+    cmd_at_callback  = (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET;
+    MockTransactionCompleteCallback(status);
+}
+
+TEST_GROUP(I2C_QueueTransaction)
+{
+    I2CTransactionDescriptor queued_transactions[3];
+
+    void setup(void)
+    {
+        mock().strictOrder();
+        InstallMockFunctions();
+        ResetControllerRegisters();
+        ResetStaticVariables();
+        LONGS_EQUAL(I2C_OK, I2C_Create((I2CRegisters*) &MOCK_HAL_I2C));
+        LONGS_EQUAL(I2C_OK, I2C_SetupController((I2CRegisters*) &MOCK_HAL_I2C, &default_setup));
+
+        for (uint8_t i = 0; i < 3; i++) {
+            queued_transactions[i]            = default_transaction;
+            queued_transactions[i].address    = 0x10 + i;
+            queued_transactions[i].data_count = 4;
+            queued_transactions[i].status     = I2C_NB_OF_RETURN_CODES;
+        }
+        queued_transactions[0].callback = &(RecordingTransactionCompleteCallback);
+        queued_transactions[1].callback = &(MockSecondTransactionCompleteCallback);
+        queued_transactions[2].callback = NULL;
+        addr_at_callback                = 0;
+        cmd_at_callback                 = 0;
+    }
+
+    void teardown(void)
+    {
+        mock().checkExpectations();
+        mock().clear();
+    }
+
+    void Queue(I2CTransactionDescriptor* descriptor,
+               I2CReturnCode             expected)
+    {
+        ExpectExternalInterruptDisabled();
+        ExpectExternalInterruptEnabled();
+        LONGS_EQUAL(expected, I2C_QueueTransaction((I2CRegisters*) &MOCK_HAL_I2C, descriptor));
+    }
+
+    void Complete(uint32_t status)
+    {
+        MOCK_HAL_I2C.Status = status;
+        MOCK_HAL_I2C.Cmd    = I2C_CMD_NO_ACTION;
+        LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+    }
+};
+
+TEST(I2C_QueueTransaction, NullDeviceReturnsInvalidInputData)
+{
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_QueueTransaction(NULL, &default_transaction));
+}
+
+TEST(I2C_QueueTransaction, NullDescriptorReturnsInvalidInputData)
+{
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_QueueTransaction((I2CRegisters*) &MOCK_HAL_I2C, NULL));
+}
+
+TEST(I2C_QueueTransaction, UnregisteredDeviceReturnsDeviceNotRegistered)
+{
+    LONGS_EQUAL(I2C_DEVICE_NOT_REGISTERED,
+                I2C_QueueTransaction((I2CRegisters*) &MOCK_HAL_I2C_2, &default_transaction));
+}
+
+TEST(I2C_QueueTransaction, NotEnabledReturnsControllerNotEnabled)
+{
+    ExpectExternalInterruptDisabled();
+    LONGS_EQUAL(I2C_OK, I2C_ShutdownController((I2CRegisters*) &MOCK_HAL_I2C));
+    LONGS_EQUAL(I2C_CONTROLLER_NOT_ENABLED,
+                I2C_QueueTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction));
+}
+
+TEST(I2C_QueueTransaction, IdleControllerIssuesDescriptorImmediately)
+{
+    Queue(&queued_transactions[0], I2C_OK);
+
+    CHECK_EQUAL(0x10u, (MOCK_HAL_I2C.Addr & I2C_ADDR_ADDR_MASK) >> I2C_ADDR_ADDR_OFFSET);
+    CHECK_EQUAL(0x01u, (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
+}
+
+TEST(I2C_QueueTransaction, QueuedDescriptorsAreChainedFromCompletionInterrupt)
+{
+    for (uint8_t i = 0; i < 3; i++) {
+        Queue(&queued_transactions[i], I2C_OK);
+    }
+
+    // Only the first descriptor is on the bus
+    CHECK_EQUAL(0x10u, (MOCK_HAL_I2C.Addr & I2C_ADDR_ADDR_MASK) >> I2C_ADDR_ADDR_OFFSET);
+
+    // The next descriptor is already issued when the completion callback runs
+    ExpectTransactionComplete(I2C_OK);
+    Complete(I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK);
+    CHECK_EQUAL(0x11u, addr_at_callback);
+    CHECK_EQUAL(0x01u, cmd_at_callback);
+    LONGS_EQUAL(I2C_OK, queued_transactions[0].status);
+
+    ExpectSecondTransactionComplete(I2C_ADDR_HIT_ERROR);
+    Complete(I2C_STATUS_CMPL_MASK);
+    CHECK_EQUAL(0x12u, (MOCK_HAL_I2C.Addr & I2C_ADDR_ADDR_MASK) >> I2C_ADDR_ADDR_OFFSET);
+    CHECK_EQUAL(0x01u, (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
+    LONGS_EQUAL(I2C_ADDR_HIT_ERROR, queued_transactions[1].status);
+
+    // No callback: completion is reported through the descriptor status only
+    Complete(I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK);
+    CHECK_EQUAL(0x00u, (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
+    LONGS_EQUAL(I2C_OK, queued_transactions[2].status);
+
+    // The controller is idle again: the next descriptor is issued immediately
+    Queue(&queued_transactions[2], I2C_OK);
+    CHECK_EQUAL(0x01u, (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
+}
+
+TEST(I2C_QueueTransaction, FullQueueReturnsQueueFull)
+{
+    Queue(&queued_transactions[0], I2C_OK);
+    for (uint8_t i = 0; i < I2C_TRANSACTION_QUEUE_DEPTH; i++) {
+        Queue(&queued_transactions[1], I2C_OK);
+    }
+    Queue(&queued_transactions[2], I2C_QUEUE_FULL);
+}
+
+TEST(I2C_QueueTransaction, CreateFlushesTheQueue)
+{
+    Queue(&queued_transactions[0], I2C_OK);
+    Queue(&queued_transactions[1], I2C_OK);
+
+    LONGS_EQUAL(I2C_OK, I2C_Create((I2CRegisters*) &MOCK_HAL_I2C));
+    MOCK_HAL_I2C.Cmd = I2C_CMD_NO_ACTION;
+    Queue(&queued_transactions[2], I2C_OK);
+    CHECK_EQUAL(0x12u, (MOCK_HAL_I2C.Addr & I2C_ADDR_ADDR_MASK) >> I2C_ADDR_ADDR_OFFSET);
+}
+
+#define SIMULATED_FIFO_SIZE   16 // ResetControllerRegisters() Cfg
+#define SIMULATED_IRQ_LATENCY 2  // Byte times between a FIFO interrupt and its handler
+
+typedef struct {
+    uint16_t irqs;   // Handler calls, completion included
+    uint16_t stalls; // Byte times the bus waited on the FIFO
+} FifoBenchmarkResult;
+
+TEST_GROUP(I2C_FifoBenchmark)
+{
+    uint8_t data[256];
+
+    void setup(void)
+    {
+        mock().strictOrder();
+        InstallMockFunctions();
+        ResetControllerRegisters();
+        ResetStaticVariables();
+        LONGS_EQUAL(I2C_OK, I2C_Create((I2CRegisters*) &MOCK_HAL_I2C));
+        LONGS_EQUAL(I2C_OK, I2C_SetupController((I2CRegisters*) &MOCK_HAL_I2C, &default_setup));
+    }
+
+    void teardown(void)
+    {
+        mock().checkExpectations();
+        mock().clear();
+    }
+
+    // Bytes moved by the HAL between memory and the FIFO so far
+    uint16_t HalMovedData(I2CDirection dir,
+                          uint16_t     data_count,
+                          uint16_t     moved)
+    {
+        if (dir == I2C_TX) {
+            // data[i] == i: the Data register holds the last byte written
+            if (MOCK_HAL_I2C.Data != UINT32_MAX) {
+                moved             = MOCK_HAL_I2C.Data + 1;
+                MOCK_HAL_I2C.Data = UINT32_MAX;
+            }
+            return moved;
+        }
+        moved = 0;
+        for (uint16_t i = 0; i < data_count; i++) {
+            moved += (data[i] == 0xA5);
+        }
+        return moved;
+    }
+
+    uint32_t FifoStatus(I2CDirection dir,
+                        uint16_t     level)
+    {
+        if (dir == I2C_TX) {
+            return ((level == 0) ? I2C_STATUS_FIFOEMPTY_MASK : 0) |
+                   ((level <= (SIMULATED_FIFO_SIZE / 2)) ? I2C_STATUS_FIFOHALF_MASK : 0);
+        }
+        return ((level == SIMULATED_FIFO_SIZE) ? I2C_STATUS_FIFOFULL_MASK : 0) |
+               ((level >= (SIMULATED_FIFO_SIZE / 2)) ? I2C_STATUS_FIFOHALF_MASK : 0);
+    }
+
+    // Shifts one byte per byte time between the FIFO and the bus and raises the
+    // enabled FIFO interrupts, the handler runs SIMULATED_IRQ_LATENCY later
+    FifoBenchmarkResult SimulateTransfer(I2CDirection dir,
+                                         I2CDataPath  data_path,
+                                         uint16_t     data_count)
+    {
+        FifoBenchmarkResult result  = {0, 0};
+        uint16_t            moved   = 0;
+        uint16_t            on_bus  = 0;
+        int16_t             latency = -1;
+
+        for (uint16_t i = 0; i < data_count; i++) {
+            data[i] = (dir == I2C_TX) ? (uint8_t) i : 0x00;
+        }
+        MOCK_HAL_I2C.Data              = (dir == I2C_TX) ? UINT32_MAX : 0xA5;
+        MOCK_HAL_I2C.Cmd               = I2C_CMD_NO_ACTION;
+        default_transaction.data       = data;
+        default_transaction.data_count = data_count;
+        LaunchTransaction(dir, data_path);
+        moved = HalMovedData(dir, data_count, moved);
+
+        for (uint16_t tick = 0; on_bus < data_count; tick++) {
+            CHECK(tick < (4 * data_count));
+
+            uint16_t level = (dir == I2C_TX) ? (moved - on_bus) : (on_bus - moved);
+
+            if ((dir == I2C_TX) ? (level > 0) : (level < SIMULATED_FIFO_SIZE)) {
+                on_bus++;
+                level = (dir == I2C_TX) ? (level - 1) : (level + 1);
+            } else {
+                result.stalls++;
+            }
+
+            MOCK_HAL_I2C.Status = FifoStatus(dir, level);
+            if ((latency < 0) &&
+                (MOCK_HAL_I2C.IntEn & MOCK_HAL_I2C.Status &
+                 (I2C_INTEN_FIFOEMPTY_MASK | I2C_INTEN_FIFOFULL_MASK | I2C_INTEN_FIFOHALF_MASK))) {
+                latency = SIMULATED_IRQ_LATENCY;
+            }
+            if ((latency >= 0) && (latency-- == 0)) {
+                LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+                moved = HalMovedData(dir, data_count, moved);
+                result.irqs++;
+            }
+        }
+
+        MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+        ExpectTransactionComplete(I2C_OK);
+        LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+        result.irqs++;
+        LONGS_EQUAL(data_count, HalMovedData(dir, data_count, moved));
+
+        return result;
+    }
+};
+
+TEST(I2C_FifoBenchmark, InterruptCountBenchmark)
+{
+    uint16_t data_counts[] = {8, 16, 32, 64, 128, 256};
+
+    for (uint8_t i = 0; i < sizeof(data_counts) / sizeof(data_counts[0]); i++) {
+        for (I2CDirection dir = I2C_TX; dir <= I2C_RX; dir++) {
+            FifoBenchmarkResult fifo = SimulateTransfer(dir, I2C_USE_FIFO, data_counts[i]);
+
+            uint16_t fifo_loads =
+                (data_counts[i] + SIMULATED_FIFO_SIZE - 1) / SIMULATED_FIFO_SIZE;
+
+            // Empty/full: one interrupt per FIFO load, the bus waits on each of them
+            LONGS_EQUAL(fifo_loads, fifo.irqs);
+            LONGS_EQUAL((fifo_loads - 1) * SIMULATED_IRQ_LATENCY, fifo.stalls);
+        }
+    }
+}
+
+static uint8_t cmd_waits;
+static uint8_t waited_cmd;
+
+// Controller finishes its pending command after one wait
+static void MockWaitCmd(I2CRegisters* i2c_dev)
+{
+    cmd_waits++;
+    waited_cmd = (((MockI2CRegisters*) i2c_dev)->Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET;
+    ((MockI2CRegisters*) i2c_dev)->Cmd = I2C_CMD_NO_ACTION;
+}
+
+static uint32_t mock_cycle_counts[4];
+static uint8_t  mock_cycle_count_index;
+
+static uint32_t MockGetCycleCount(void)
+{
+    return mock_cycle_counts[mock_cycle_count_index++];
+}
+
+TEST_GROUP(I2C_AutoDataPath)
+{
+    I2CStats* stats;
+
+    void setup(void)
+    {
+        mock().strictOrder();
+        mock().installComparator("DMACChannelConfig*", channel_config_comparator);
+        mock().installComparator("DMACTransferConfig*", transfer_config_comparator);
+        InstallMockFunctions();
+        ResetControllerRegisters();
+        ResetStaticVariables();
+        LONGS_EQUAL(I2C_OK, I2C_Create((I2CRegisters*) &MOCK_HAL_I2C));
+        LONGS_EQUAL(I2C_OK, I2C_SetupController((I2CRegisters*) &MOCK_HAL_I2C, &default_setup));
+        LONGS_EQUAL(I2C_OK, I2C_GetStats((I2CRegisters*) &MOCK_HAL_I2C, &stats));
+        default_transaction.data_path = I2C_USE_AUTO;
+        mock_cycle_count_index        = 0;
+    }
+
+    void teardown(void)
+    {
+        mock().checkExpectations();
+        mock().clear();
+        mock().removeAllComparatorsAndCopiers();
+    }
+
+#if I2C_FEATURE_DMA
+    void Calibrate(uint32_t dma_setup_cycles,
+                   uint32_t fifo_cycles)
+    {
+        mock_cycle_counts[0] = 1000;
+        mock_cycle_counts[1] = 1000 + dma_setup_cycles;
+        mock_cycle_counts[2] = 2000;
+        mock_cycle_counts[3] = 2000 + fifo_cycles;
+        UT_PTR_SET(I2C_GetCycleCount, MockGetCycleCount);
+
+        expected_dmac_channel_config[I2C_TX].src_burst_size = DMAC_BURST_SIZE_8;
+        ExpectDMACChannelSetup(I2C_TX);
+        mock().expectOneCall("DMAC_SetupTransfer")
+        .withPointerParameter("dmac_dev", HAL_DMAC)
+        .ignoreOtherParameters()
+        .andReturnValue(DMAC_OK);
+        UT_PTR_SET(I2C_WaitCmd, MockWaitCmd);
+        waited_cmd = I2C_CMD_NO_ACTION;
+        LONGS_EQUAL(I2C_OK, I2C_Calibrate((I2CRegisters*) &MOCK_HAL_I2C));
+
+        // The FIFO filled by the measurement is cleared before returning
+        CHECK_EQUAL(I2C_CMD_CLEAR_FIFO, waited_cmd);
+        CHECK_EQUAL(I2C_CMD_NO_ACTION, (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
+    }
+#endif
+};
+
+TEST(I2C_AutoDataPath, GetStatsWithInvalidInputReturnsInvalidInputData)
+{
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_GetStats(NULL, &stats));
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_GetStats((I2CRegisters*) &MOCK_HAL_I2C, NULL));
+    LONGS_EQUAL(I2C_DEVICE_NOT_REGISTERED, I2C_GetStats((I2CRegisters*) &MOCK_HAL_I2C_2, &stats));
+}
+
+TEST(I2C_AutoDataPath, StatsAreResetOnCreate)
+{
+    LONGS_EQUAL(0, stats->fifo_transactions);
+    LONGS_EQUAL(0, stats->dma_transactions);
+    LONGS_EQUAL(0, stats->dma_setup_cycles);
+    LONGS_EQUAL(0, stats->fifo_byte_cycles);
+    LONGS_EQUAL(I2C_AUTO_DMA_THRESHOLD, stats->auto_dma_threshold);
+}
+
+#if I2C_FEATURE_DMA
+TEST(I2C_AutoDataPath, CalibrateWithInvalidInputReturnsError)
+{
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_Calibrate(NULL));
+    LONGS_EQUAL(I2C_DEVICE_NOT_REGISTERED, I2C_Calibrate((I2CRegisters*) &MOCK_HAL_I2C_2));
+    LONGS_EQUAL(I2C_CYCLE_COUNTER_NOT_AVAILABLE, I2C_Calibrate((I2CRegisters*) &MOCK_HAL_I2C));
+
+    UT_PTR_SET(I2C_GetCycleCount, MockGetCycleCount);
+    MOCK_HAL_I2C.Cmd = I2C_CMD_ISSUE_TRANSACTION;
+    LONGS_EQUAL(I2C_CMD_PENDING, I2C_Calibrate((I2CRegisters*) &MOCK_HAL_I2C));
+
+    ExpectExternalInterruptDisabled();
+    LONGS_EQUAL(I2C_OK, I2C_ShutdownController((I2CRegisters*) &MOCK_HAL_I2C));
+    LONGS_EQUAL(I2C_CONTROLLER_NOT_ENABLED, I2C_Calibrate((I2CRegisters*) &MOCK_HAL_I2C));
+}
+
+TEST(I2C_AutoDataPath, CalibrateMeasuresCrossoverThreshold)
+{
+    // 400 cycles of DMA setup, 10 cycles per byte through the 16 bytes FIFO
+    Calibrate(400, 160);
+
+    LONGS_EQUAL(400, stats->dma_setup_cycles);
+    LONGS_EQUAL(10, stats->fifo_byte_cycles);
+    LONGS_EQUAL(40, stats->auto_dma_threshold);
+}
+
+TEST(I2C_AutoDataPath, CalibrateWithFifoClearStuckReturnsCmdPending)
+{
+    mock_cycle_counts[0] = 1000;
+    mock_cycle_counts[1] = 1400;
+    mock_cycle_counts[2] = 2000;
+    mock_cycle_counts[3] = 2160;
+    UT_PTR_SET(I2C_GetCycleCount, MockGetCycleCount);
+
+    expected_dmac_channel_config[I2C_TX].src_burst_size = DMAC_BURST_SIZE_8;
+    ExpectDMACChannelSetup(I2C_TX);
+    mock().expectOneCall("DMAC_SetupTransfer")
+    .withPointerParameter("dmac_dev", HAL_DMAC)
+    .ignoreOtherParameters()
+    .andReturnValue(DMAC_OK);
+    LONGS_EQUAL(I2C_CMD_PENDING, I2C_Calibrate((I2CRegisters*) &MOCK_HAL_I2C));
+
+    // Nothing measured while the FIFO may still hold the scratch bytes
+    LONGS_EQUAL(0, stats->dma_setup_cycles);
+    LONGS_EQUAL(0, stats->fifo_byte_cycles);
+    LONGS_EQUAL(I2C_AUTO_DMA_THRESHOLD, stats->auto_dma_threshold);
+}
+
+TEST(I2C_AutoDataPath, AutoUsesFifoBelowThresholdAndDmaFromIt)
+{
+    Calibrate(400, 160);
+
+    default_transaction.data       = large_data_buffer;
+    default_transaction.data_count = 39;
+    LaunchDefaultTransaction();
+    CHECK_EQUAL(0, (MOCK_HAL_I2C.Setup & I2C_SETUP_DMAEN_MASK) >> I2C_SETUP_DMAEN_OFFSET);
+    CHECK((MOCK_HAL_I2C.IntEn & I2C_INTEN_FIFOEMPTY_MASK) >> I2C_INTEN_FIFOEMPTY_OFFSET);
+
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+    MOCK_HAL_I2C.Cmd    = I2C_CMD_NO_ACTION;
+    ExpectTransactionComplete(I2C_OK);
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+
+    SetupLargeTransaction(40);
+    expected_dmac_transfer_config[I2C_TX].transfer_size = 40;
+    ExpectDMACChannelSetup(I2C_TX);
+    ExpectDMACTransferSetup(I2C_TX);
+    ExpectDMACChannelEnabled();
+    ExpectExternalInterruptEnabled();
+    LONGS_EQUAL(I2C_OK, I2C_LaunchTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction));
+    CHECK((MOCK_HAL_I2C.Setup & I2C_SETUP_DMAEN_MASK) >> I2C_SETUP_DMAEN_OFFSET);
+
+    LONGS_EQUAL(1, stats->fifo_transactions);
+    LONGS_EQUAL(1, stats->dma_transactions);
+}
+
+TEST(I2C_AutoDataPath, WriteReadCountsBothPhases)
+{
+    SetupWriteReadTransaction();
+    default_transaction.rx_data       = large_data_buffer;
+    default_transaction.rx_data_count = I2C_AUTO_DMA_THRESHOLD - default_transaction.data_count;
+
+    expected_dmac_channel_config[I2C_TX].src_burst_size = DMAC_BURST_SIZE_2;
+    expected_dmac_transfer_config[I2C_TX].transfer_size = default_transaction.data_count;
+    ExpectDMACChannelSetup(I2C_TX);
+    ExpectDMACTransferSetup(I2C_TX);
+    ExpectDMACChannelEnabled();
+    ExpectExternalInterruptEnabled();
+    LONGS_EQUAL(I2C_OK, I2C_LaunchTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction));
+    LONGS_EQUAL(1, stats->dma_transactions);
+}
+#endif
+
+static uint8_t    segment_header[2] = { 0xC0, 0xC1 };
+static I2CSegment segments[2];
+
+TEST_GROUP(I2C_ScatterGather)
+{
+    void setup(void)
+    {
+        mock().strictOrder();
+        mock().installComparator("DMACChannelConfig*", channel_config_comparator);
+        mock().installComparator("DMACTransferConfig*", transfer_config_comparator);
+        InstallMockFunctions();
+        ResetControllerRegisters();
+        ResetStaticVariables();
+        LONGS_EQUAL(I2C_OK, I2C_Create((I2CRegisters*) &MOCK_HAL_I2C));
+        LONGS_EQUAL(I2C_OK, I2C_SetupController((I2CRegisters*) &MOCK_HAL_I2C, &default_setup));
+
+        for (uint16_t i = 0; i < sizeof(large_data_buffer); i++) {
+            large_data_buffer[i] = (uint8_t) i;
+        }
+        segments[0].data                  = segment_header;
+        segments[0].data_count            = sizeof(segment_header);
+        segments[1].data                  = large_data_buffer;
+        segments[1].data_count            = 20;
+        default_transaction.data          = NULL;
+        default_transaction.data_count    = 0;
+        default_transaction.segments      = segments;
+        default_transaction.segment_count = 2;
+    }
+
+    void teardown(void)
+    {
+        mock().checkExpectations();
+        mock().clear();
+        mock().removeAllComparatorsAndCopiers();
+    }
+
+    void CheckInvalid(void)
+    {
+        LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
+                    I2C_LaunchTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction));
+    }
+};
+
+#if I2C_VALIDATION_LEVEL == I2C_VALIDATION_FULL
+TEST(I2C_ScatterGather, InvalidSegmentsReturnError)
+{
+    default_transaction.data = default_data_buffer;
+    CheckInvalid();
+
+    default_transaction.data      = NULL;
+    default_transaction.direction = I2C_RX;
+    CheckInvalid();
+
+    default_transaction.direction     = I2C_TX;
+    default_transaction.segment_count = 0;
+    CheckInvalid();
+
+    default_transaction.segment_count = 2;
+    segments[1].data_count            = 0;
+    CheckInvalid();
+
+    segments[1].data_count = 20;
+    segments[1].data       = NULL;
+    CheckInvalid();
+}
+#endif
+
+TEST(I2C_ScatterGather, FifoSendsSegmentsInOneDataPhase)
+{
+    LaunchDefaultTransaction();
+    CheckCtrlRegister(I2C_CTRL_PHASE_START_MASK | I2C_CTRL_PHASE_ADDR_MASK |
+                      I2C_CTRL_PHASE_DATA_MASK | I2C_CTRL_PHASE_STOP_MASK,
+                      I2C_TX,
+                      22);
+
+    // Header, then the payload from its own buffer: 16 bytes FIFO
+    BYTES_EQUAL(13, MOCK_HAL_I2C.Data);
+    MOCK_HAL_I2C.Status = I2C_STATUS_FIFOEMPTY_MASK;
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+    BYTES_EQUAL(19, MOCK_HAL_I2C.Data);
+
+    ExpectTransactionComplete(I2C_OK);
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+}
+
+TEST(I2C_ScatterGather, SegmentsSpanningDataPhases)
+{
+    segments[1].data_count = 300;
+    LaunchDefaultTransaction();
+    CheckCtrlRegister(I2C_CTRL_PHASE_START_MASK | I2C_CTRL_PHASE_ADDR_MASK |
+                      I2C_CTRL_PHASE_DATA_MASK,
+                      I2C_TX,
+                      0);
+    DrainFifo(I2C_TX, 256);
+
+    // Header and 254 payload bytes in the first data phase
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+    CheckCtrlRegister(I2C_CTRL_PHASE_DATA_MASK | I2C_CTRL_PHASE_STOP_MASK, I2C_TX, 46);
+    BYTES_EQUAL((uint8_t) (254 + 15), MOCK_HAL_I2C.Data);
+    DrainFifo(I2C_TX, 46);
+    BYTES_EQUAL((uint8_t) 299, MOCK_HAL_I2C.Data);
+
+    ExpectTransactionComplete(I2C_OK);
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+}
+
+#if I2C_FEATURE_DMA
+TEST(I2C_ScatterGather, DmaTransferPerSegment)
+{
+    // Bursts dividing both the 2 bytes header and the 20 bytes payload
+    expected_dmac_channel_config[I2C_TX].src_burst_size = DMAC_BURST_SIZE_2;
+    expected_dmac_transfer_config[I2C_TX].transfer_size = sizeof(segment_header);
+    expected_dmac_transfer_config[I2C_TX].src_address   = (uint32_t) segment_header;
+    default_transaction.data_path                       = I2C_USE_DMA;
+    ExpectDMACChannelSetup(I2C_TX);
+    ExpectDMACTransferSetup(I2C_TX);
+    ExpectDMACChannelEnabled();
+    ExpectExternalInterruptEnabled();
+    LONGS_EQUAL(I2C_OK, I2C_LaunchTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction));
+    CheckCtrlRegister(I2C_CTRL_PHASE_START_MASK | I2C_CTRL_PHASE_ADDR_MASK |
+                      I2C_CTRL_PHASE_DATA_MASK | I2C_CTRL_PHASE_STOP_MASK,
+                      I2C_TX,
+                      22);
+
+    expected_dmac_transfer_config[I2C_TX].transfer_size = 20;
+    expected_dmac_transfer_config[I2C_TX].src_address   = (uint32_t) large_data_buffer;
+    ExpectDMACTransferSetup(I2C_TX);
+    ExpectDMACChannelEnabled();
+    I2C_DMACCallback(DMAC_TERMINAL_COUNT);
+
+    // Last transfer of the data phase
+    I2C_DMACCallback(DMAC_TERMINAL_COUNT);
+
+    ExpectTransactionComplete(I2C_OK);
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+}
+#endif
+
+TEST(I2C_ScatterGather, WriteReadWithSegmentsInWritePhase)
+{
+    SetupWriteReadTransaction();
+    default_transaction.data       = NULL;
+    default_transaction.data_count = 0;
+    LaunchDefaultTransaction();
+    CheckCtrlRegister(I2C_CTRL_PHASE_START_MASK | I2C_CTRL_PHASE_ADDR_MASK |
+                      I2C_CTRL_PHASE_DATA_MASK,
+                      I2C_TX,
+                      22);
+
+    MOCK_HAL_I2C.Status = I2C_STATUS_FIFOEMPTY_MASK;
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+    CheckCtrlRegister(I2C_CTRL_PHASE_START_MASK | I2C_CTRL_PHASE_ADDR_MASK |
+                      I2C_CTRL_PHASE_DATA_MASK | I2C_CTRL_PHASE_STOP_MASK,
+                      I2C_RX,
+                      sizeof(default_rx_data_buffer));
+
+    MOCK_HAL_I2C.Data = 0x5A;
+    ExpectTransactionComplete(I2C_OK);
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+    BYTES_EQUAL(0x5A, default_rx_data_buffer[3]);
+}
+
+static void MockContextCallback(void*         context,
+                                I2CReturnCode status,
+                                uint32_t      data_count,
+                                uint32_t      timestamp)
+{
+    mock().actualCall("MockContextCallback")
+    .withPointerParameter("context", context)
+    .withParameter("status", status)
+    .withParameter("data_count", data_count)
+    .withParameter("timestamp", timestamp);
+}
+
+static void ExpectContextCallback(void*         context,
+                                  I2CReturnCode status,
+                                  uint32_t      data_count,
+                                  uint32_t      timestamp)
+{
+    mock().expectOneCall("MockContextCallback")
+    .withPointerParameter("context", context)
+    .withParameter("status", status)
+    .withParameter("data_count", data_count)
+    .withParameter("timestamp", timestamp);
+}
+
+TEST_GROUP(I2C_ContextCallback)
+{
+    uint8_t request;
+
+    void setup(void)
+    {
+        mock().strictOrder();
+        mock().installComparator("DMACChannelConfig*", channel_config_comparator);
+        mock().installComparator("DMACTransferConfig*", transfer_config_comparator);
+        InstallMockFunctions();
+        ResetControllerRegisters();
+        ResetStaticVariables();
+        LONGS_EQUAL(I2C_OK, I2C_Create((I2CRegisters*) &MOCK_HAL_I2C));
+        LONGS_EQUAL(I2C_OK, I2C_SetupController((I2CRegisters*) &MOCK_HAL_I2C, &default_setup));
+        default_transaction.data_count       = 3;
+        default_transaction.context_callback = &(MockContextCallback);
+        default_transaction.context          = &request;
+        mock_cycle_counts[0]                 = 123456;
+        mock_cycle_count_index               = 0;
+        cmd_waits                            = 0;
+        waited_cmd                           = I2C_CMD_NO_ACTION;
+    }
+
+    void teardown(void)
+    {
+        mock().checkExpectations();
+        mock().clear();
+        mock().removeAllComparatorsAndCopiers();
+    }
+
+    void Complete(void)
+    {
+        MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+        MOCK_HAL_I2C.Cmd    = I2C_CMD_NO_ACTION;
+        LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+    }
+};
+
+TEST(I2C_ContextCallback, CalledInsteadOfCallbackWithContextCountAndTimestamp)
+{
+    UT_PTR_SET(I2C_GetCycleCount, MockGetCycleCount);
+    LaunchDefaultTransaction();
+
+    ExpectContextCallback(&request, I2C_OK, 3, 123456);
+    Complete();
+    LONGS_EQUAL(I2C_OK, default_transaction.status);
+}
+
+TEST(I2C_ContextCallback, TimestampIsZeroWithoutCycleCounter)
+{
+    LaunchDefaultTransaction();
+
+    ExpectContextCallback(&request, I2C_OK, 3, 0);
+    Complete();
+}
+
+TEST(I2C_ContextCallback, WriteReadCountsBothPhases)
+{
+    SetupWriteReadTransaction();
+    LaunchDefaultTransaction();
+    Complete();
+
+    ExpectContextCallback(&request, I2C_OK, 2 + sizeof(default_rx_data_buffer), 0);
+    Complete();
+}
+
+TEST(I2C_ContextCallback, AddressNackReportsNoData)
+{
+    default_transaction.direction = I2C_RX;
+    LaunchDefaultTransaction();
+
+    ExpectContextCallback(&request, I2C_ADDR_HIT_ERROR, 0, 0);
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK;
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+}
+
+#if I2C_FEATURE_DMA
+TEST(I2C_ContextCallback, DmaErrorIsReportedWithContext)
+{
+    expected_dmac_transfer_config[I2C_TX].transfer_size = 3;
+    expected_dmac_channel_config[I2C_TX].src_burst_size = DMAC_BURST_SIZE_1;
+    LaunchTransaction(I2C_TX, I2C_USE_DMA);
+
+    ExpectExternalInterruptDisabled();
+    ExpectContextCallback(&request, I2C_DMAC_ERROR, 0, 0);
+    ExpectExternalInterruptEnabled();
+    I2C_DMACCallback(DMAC_ERROR);
+    LONGS_EQUAL(I2C_DMAC_ERROR, default_transaction.status);
+    CHECK_EQUAL(I2C_CMD_RESET, (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
+}
+
+TEST(I2C_ContextCallback, DmaErrorAfterShutdownLeavesTheInterruptOff)
+{
+    expected_dmac_transfer_config[I2C_TX].transfer_size = 3;
+    expected_dmac_channel_config[I2C_TX].src_burst_size = DMAC_BURST_SIZE_1;
+    LaunchTransaction(I2C_TX, I2C_USE_DMA);
+    ExpectExternalInterruptDisabled();
+    LONGS_EQUAL(I2C_OK, I2C_ShutdownController((I2CRegisters*) &MOCK_HAL_I2C));
+
+    ExpectExternalInterruptDisabled();
+    ExpectContextCallback(&request, I2C_DMAC_ERROR, 0, 0);
+    I2C_DMACCallback(DMAC_ERROR);
+}
+
+TEST(I2C_ContextCallback, DmaErrorIssuesNextQueuedDescriptor)
+{
+    I2CTransactionDescriptor second = default_transaction;
+    uint8_t                  second_request;
+
+    UT_PTR_SET(I2C_WaitCmd, MockWaitCmd);
+    expected_dmac_transfer_config[I2C_TX].transfer_size = 3;
+    expected_dmac_channel_config[I2C_TX].src_burst_size = DMAC_BURST_SIZE_1;
+    LaunchTransaction(I2C_TX, I2C_USE_DMA);
+
+    second.address = 0x33;
+    second.context = &second_request;
+    ExpectExternalInterruptDisabled();
+    ExpectExternalInterruptEnabled();
+    LONGS_EQUAL(I2C_OK, I2C_QueueTransaction((I2CRegisters*) &MOCK_HAL_I2C, &second));
+
+    // The failed descriptor frees the controller and the DMA channel
+    ExpectExternalInterruptDisabled();
+    ExpectContextCallback(&request, I2C_DMAC_ERROR, 0, 0);
+    ExpectExternalInterruptEnabled();
+    I2C_DMACCallback(DMAC_ERROR);
+    LONGS_EQUAL(I2C_DMAC_ERROR, default_transaction.status);
+    LONGS_EQUAL(1, cmd_waits);
+    CHECK_EQUAL(I2C_CMD_RESET, waited_cmd);
+    CHECK_EQUAL(0x33u, (MOCK_HAL_I2C.Addr & I2C_ADDR_ADDR_MASK) >> I2C_ADDR_ADDR_OFFSET);
+    CHECK_EQUAL(I2C_CMD_ISSUE_TRANSACTION,
+                (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
+
+    ExpectContextCallback(&second_request, I2C_OK, 3, 0);
+    Complete();
+    LONGS_EQUAL(I2C_OK, second.status);
+
+    // Late DMA events of the aborted transfer are ignored
+    I2C_DMACCallback(DMAC_ERROR);
+}
+#endif
+
+TEST(I2C_ContextCallback, IndependentContextsForQueuedDescriptors)
+{
+    I2CTransactionDescriptor second = default_transaction;
+    uint8_t                  second_request;
+
+    second.context = &second_request;
+    ExpectExternalInterruptDisabled();
+    ExpectExternalInterruptEnabled();
+    LONGS_EQUAL(I2C_OK, I2C_QueueTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction));
+    ExpectExternalInterruptDisabled();
+    ExpectExternalInterruptEnabled();
+    LONGS_EQUAL(I2C_OK, I2C_QueueTransaction((I2CRegisters*) &MOCK_HAL_I2C, &second));
+
+    ExpectContextCallback(&request, I2C_OK, 3, 0);
+    Complete();
+    ExpectContextCallback(&second_request, I2C_OK, 3, 0);
+    Complete();
+}
+
+TEST_GROUP(I2C_ScanBus)
+{
+    I2CScanDescriptor scan;
+    uint8_t           request;
+
+    void setup(void)
+    {
+        mock().strictOrder();
+        InstallMockFunctions();
+        ResetControllerRegisters();
+        ResetStaticVariables();
+        LONGS_EQUAL(I2C_OK, I2C_Create((I2CRegisters*) &MOCK_HAL_I2C));
+        LONGS_EQUAL(I2C_OK, I2C_SetupController((I2CRegisters*) &MOCK_HAL_I2C, &default_setup));
+        scan.first_address    = 0x08;
+        scan.last_address     = 0x0b;
+        scan.found            = 0xff;
+        scan.probe_timeout    = 0;
+        scan.context_callback = &(MockContextCallback);
+        scan.context          = &request;
+        scan.status           = I2C_NB_OF_RETURN_CODES;
+        for (uint8_t i = 0; i < I2C_SCAN_MAP_SIZE; i++) {
+            scan.presence[i] = 0xff;
+        }
+    }
+
+    void teardown(void)
+    {
+        mock().checkExpectations();
+        mock().clear();
+    }
+
+    void Scan(I2CReturnCode expected)
+    {
+        ExpectExternalInterruptDisabled();
+        ExpectExternalInterruptEnabled();
+        LONGS_EQUAL(expected, I2C_ScanBus((I2CRegisters*) &MOCK_HAL_I2C, &scan));
+    }
+
+    void CheckProbe(uint16_t address)
+    {
+        CHECK_EQUAL(address, (MOCK_HAL_I2C.Addr & I2C_ADDR_ADDR_MASK) >> I2C_ADDR_ADDR_OFFSET);
+        CheckCtrlRegister(I2C_CTRL_PHASE_START_MASK | I2C_CTRL_PHASE_ADDR_MASK |
+                          I2C_CTRL_PHASE_STOP_MASK,
+                          I2C_TX,
+                          0);
+        CHECK_EQUAL(I2C_CMD_ISSUE_TRANSACTION,
+                    (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
+    }
+
+    void Answer(bool ack)
+    {
+        MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | (ack ? I2C_STATUS_ADDRHIT_MASK : 0);
+        MOCK_HAL_I2C.Cmd    = I2C_CMD_NO_ACTION;
+        LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+    }
+};
+
+TEST(I2C_ScanBus, InvalidInputReturnsError)
+{
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_ScanBus(NULL, &scan));
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_ScanBus((I2CRegisters*) &MOCK_HAL_I2C, NULL));
+    scan.first_address = 0x0c;
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_ScanBus((I2CRegisters*) &MOCK_HAL_I2C, &scan));
+    scan.first_address = 0x08;
+    scan.last_address  = I2C_ADDR_MAX_7BIT + 1;
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_ScanBus((I2CRegisters*) &MOCK_HAL_I2C, &scan));
+}
+
+TEST(I2C_ScanBus, UnregisteredDeviceReturnsDeviceNotRegistered)
+{
+    LONGS_EQUAL(I2C_DEVICE_NOT_REGISTERED, I2C_ScanBus((I2CRegisters*) &MOCK_HAL_I2C_2, &scan));
+}
+
+#if I2C_FEATURE_SLAVE
+TEST(I2C_ScanBus, SlaveControllerReturnsWrongRole)
+{
+    SetupController(I2C_SLAVE, I2C_STANDARD_MODE);
+    LONGS_EQUAL(I2C_WRONG_ROLE, I2C_ScanBus((I2CRegisters*) &MOCK_HAL_I2C, &scan));
+}
+#endif
+
+TEST(I2C_ScanBus, ProbesEachAddressAndReportsPresence)
+{
+    Scan(I2C_OK);
+    CheckProbe(0x08);
+    LONGS_EQUAL(0, scan.found);
+    LONGS_EQUAL(0, scan.presence[0x08 / 8]);
+
+    // The next address is probed from the completion interrupt
+    Answer(false);
+    CheckProbe(0x09);
+    Answer(true);
+    CheckProbe(0x0a);
+    Answer(false);
+    CheckProbe(0x0b);
+
+    ExpectContextCallback(&request, I2C_OK, 2, 0);
+    Answer(true);
+    LONGS_EQUAL(I2C_OK, scan.status);
+    LONGS_EQUAL(2, scan.found);
+    CHECK_FALSE(I2C_SCAN_PRESENT(scan.presence, 0x08));
+    CHECK_TRUE(I2C_SCAN_PRESENT(scan.presence, 0x09));
+    CHECK_FALSE(I2C_SCAN_PRESENT(scan.presence, 0x0a));
+    CHECK_TRUE(I2C_SCAN_PRESENT(scan.presence, 0x0b));
+    for (uint8_t i = 0; i < I2C_SCAN_MAP_SIZE; i++) {
+        if (i != 0x08 / 8) {
+            LONGS_EQUAL(0, scan.presence[i]);
+        }
+    }
+}
+
+TEST(I2C_ScanBus, ProbesAreNotCountedAsDataTransactions)
+{
+    I2CStats* stats;
+
+    scan.last_address = scan.first_address;
+    Scan(I2C_OK);
+    ExpectContextCallback(&request, I2C_OK, 0, 0);
+    Answer(false);
+
+    LONGS_EQUAL(I2C_OK, I2C_GetStats((I2CRegisters*) &MOCK_HAL_I2C, &stats));
+    LONGS_EQUAL(0, stats->fifo_transactions);
+    LONGS_EQUAL(0, stats->dma_transactions);
+}
+
+TEST(I2C_ScanBus, ScanInProgressReturnsCmdPending)
+{
+    I2CScanDescriptor second = scan;
+
+    Scan(I2C_OK);
+    LONGS_EQUAL(I2C_CMD_PENDING, I2C_ScanBus((I2CRegisters*) &MOCK_HAL_I2C, &second));
+}
+
+TEST(I2C_ScanBus, QueuedDescriptorsKeepTheirTurn)
+{
+    default_transaction.address    = 0x40;
+    default_transaction.data_count = 3;
+    Scan(I2C_OK);
+    ExpectExternalInterruptDisabled();
+    ExpectExternalInterruptEnabled();
+    LONGS_EQUAL(I2C_OK, I2C_QueueTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction));
+
+    Answer(false);
+    CHECK_EQUAL(0x40u, (MOCK_HAL_I2C.Addr & I2C_ADDR_ADDR_MASK) >> I2C_ADDR_ADDR_OFFSET);
+
+    ExpectTransactionComplete(I2C_OK);
+    Answer(true);
+    CheckProbe(0x09);
+}
+
+TEST(I2C_ScanBus, BusyControllerProbesAfterTheTransaction)
+{
+    LaunchDefaultTransaction();
+    Scan(I2C_OK);
+
+    ExpectTransactionComplete(I2C_OK);
+    Answer(true);
+    CheckProbe(0x08);
+}
+
+TEST(I2C_ScanBus, ProbeOnHeldBusTimesOut)
+{
+    scan.probe_timeout = 2;
+    Scan(I2C_OK);
+    Answer(true);
+    CheckProbe(0x09);
+
+    // Each probe gets the whole deadline
+    I2C_TimeoutTick();
+    Answer(false);
+    I2C_TimeoutTick();
+    CheckProbe(0x0a);
+
+    ExpectExternalInterruptDisabled();
+    ExpectContextCallback(&request, I2C_TRANSACTION_TIMEOUT, 1, 0);
+    ExpectExternalInterruptEnabled();
+    I2C_TimeoutTick();
+    LONGS_EQUAL(I2C_TRANSACTION_TIMEOUT, scan.status);
+    CHECK_TRUE(I2C_SCAN_PRESENT(scan.presence, 0x08));
+}
+
+TEST(I2C_ScanBus, ProbeWithoutDeadlineIsNotAborted)
+{
+    Scan(I2C_OK);
+    for (uint8_t i = 0; i < 10; i++) {
+        I2C_TimeoutTick();
+    }
+    CheckProbe(0x08);
+}
+
+TEST(I2C_ScanBus, BusHangEndsTheScan)
+{
+    Scan(I2C_OK);
+    Answer(true);
+    MOCK_HAL_I2C.Status = I2C_STATUS_LINESDA_MASK | I2C_STATUS_LINESCL_MASK;
+
+    ExpectExternalInterruptDisabled();
+    ExpectContextCallback(&request, I2C_BUS_HANG, 1, 0);
+    ExpectExternalInterruptEnabled();
+    LONGS_EQUAL(I2C_OK, I2C_RecoverBus((I2CRegisters*) &MOCK_HAL_I2C));
+    LONGS_EQUAL(I2C_BUS_HANG, scan.status);
+
+    // A new scan can start
+    MOCK_HAL_I2C.Cmd = I2C_CMD_NO_ACTION;
+    Scan(I2C_OK);
+    CheckProbe(0x08);
+}
+
+static uint32_t inten_at_callback;
+
+static void MockDeferIrq(I2CRegisters* i2c_dev)
+{
+    mock().actualCall("MockDeferIrq")
+    .withPointerParameter("i2c_dev", i2c_dev);
+}
+
+static void IntEnRecordingCallback(I2CReturnCode status)
+{
+    inten_at_callback = MOCK_HAL_I2C.IntEn;
+    MockTransactionCompleteCallback(status);
+}
+
+TEST_GROUP(I2C_DeferredIrq)
+{
+    I2CStats* stats;
+
+    void setup(void)
+    {
+        mock().strictOrder();
+        mock().installComparator("DMACChannelConfig*", channel_config_comparator);
+        mock().installComparator("DMACTransferConfig*", transfer_config_comparator);
+        InstallMockFunctions();
+        ResetControllerRegisters();
+        ResetStaticVariables();
+        LONGS_EQUAL(I2C_OK, I2C_Create((I2CRegisters*) &MOCK_HAL_I2C));
+        LONGS_EQUAL(I2C_OK, I2C_SetupController((I2CRegisters*) &MOCK_HAL_I2C, &default_setup));
+        LONGS_EQUAL(I2C_OK, I2C_GetStats((I2CRegisters*) &MOCK_HAL_I2C, &stats));
+        UT_PTR_SET(I2C_DeferIrq, MockDeferIrq);
+        default_transaction.data_count = 3;
+        inten_at_callback              = 0xffffffff;
+    }
+
+    void teardown(void)
+    {
+        mock().checkExpectations();
+        mock().clear();
+        mock().removeAllComparatorsAndCopiers();
+    }
+
+    void TopHalf(uint32_t status)
+    {
+        MOCK_HAL_I2C.Status = status;
+        MOCK_HAL_I2C.Cmd    = I2C_CMD_NO_ACTION;
+        LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+    }
+
+    void ExpectDeferred(void)
+    {
+        mock().expectOneCall("MockDeferIrq")
+        .withPointerParameter("i2c_dev", (I2CRegisters*) &MOCK_HAL_I2C);
+    }
+
+    void BottomHalf(void)
+    {
+        LONGS_EQUAL(I2C_OK, I2C_ProcessDeferredIrq((I2CRegisters*) &MOCK_HAL_I2C));
+    }
+};
+
+TEST(I2C_DeferredIrq, InvalidInputReturnsError)
+{
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_ProcessDeferredIrq(NULL));
+    LONGS_EQUAL(I2C_DEVICE_NOT_REGISTERED,
+                I2C_ProcessDeferredIrq((I2CRegisters*) &MOCK_HAL_I2C_2));
+}
+
+TEST(I2C_DeferredIrq, NothingDeferredIsNoOperation)
+{
+    uint32_t mmio_writes = stats->mmio_writes;
+
+    BottomHalf();
+    LONGS_EQUAL(mmio_writes, stats->mmio_writes);
+}
+
+TEST(I2C_DeferredIrq, TopHalfAcksMasksAndDefers)
+{
+    default_transaction.status = I2C_NB_OF_RETURN_CODES;
+    LaunchDefaultTransaction();
+    uint32_t int_en     = MOCK_HAL_I2C.IntEn;
+    uint32_t mmio_reads = stats->mmio_reads;
+
+    ExpectDeferred();
+    TopHalf(I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK);
+
+    // Single Status read, no callback from the interrupt
+    LONGS_EQUAL(mmio_reads + 1, stats->mmio_reads);
+    LONGS_EQUAL(0, MOCK_HAL_I2C.IntEn);
+    LONGS_EQUAL(I2C_NB_OF_RETURN_CODES, default_transaction.status);
+
+    // Acked by the top half: the bottom half does not read nor write Status
+    MOCK_HAL_I2C.Status = 0;
+    ExpectTransactionComplete(I2C_OK);
+    ExpectExternalInterruptDisabled();
+    ExpectExternalInterruptEnabled();
+    BottomHalf();
+    LONGS_EQUAL(I2C_OK, default_transaction.status);
+    LONGS_EQUAL(0, MOCK_HAL_I2C.Status);
+    LONGS_EQUAL(int_en, MOCK_HAL_I2C.IntEn);
+}
+
+TEST(I2C_DeferredIrq, EventsNotEnabledAreIgnored)
+{
+    LaunchDefaultTransaction();
+    uint32_t int_en = MOCK_HAL_I2C.IntEn;
+
+    TopHalf(I2C_STATUS_FIFOEMPTY_MASK & ~int_en);
+    LONGS_EQUAL(int_en, MOCK_HAL_I2C.IntEn);
+}
+
+TEST(I2C_DeferredIrq, MaskedControllerIsNotDeferredTwice)
+{
+    LaunchDefaultTransaction();
+    ExpectDeferred();
+    TopHalf(I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK);
+
+    // Another controller on the shared line
+    uint32_t mmio_reads = stats->mmio_reads;
+
+    TopHalf(I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK);
+    LONGS_EQUAL(mmio_reads, stats->mmio_reads);
+}
+
+TEST(I2C_DeferredIrq, InterruptsEnabledByBottomHalfStayMaskedUntilDone)
+{
+    I2CTransactionDescriptor second = default_transaction;
+
+    default_transaction.callback = &(IntEnRecordingCallback);
+    ExpectExternalInterruptDisabled();
+    ExpectExternalInterruptEnabled();
+    LONGS_EQUAL(I2C_OK, I2C_QueueTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction));
+    ExpectExternalInterruptDisabled();
+    ExpectExternalInterruptEnabled();
+    LONGS_EQUAL(I2C_OK, I2C_QueueTransaction((I2CRegisters*) &MOCK_HAL_I2C, &second));
+
+    ExpectDeferred();
+    TopHalf(I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK);
+
+    // The next descriptor is issued before the callback, with the controller still masked
+    ExpectTransactionComplete(I2C_OK);
+    ExpectExternalInterruptDisabled();
+    ExpectExternalInterruptEnabled();
+    BottomHalf();
+    LONGS_EQUAL(0, inten_at_callback);
+    CHECK(MOCK_HAL_I2C.IntEn & I2C_INTEN_CMPL_MASK);
+}
+
+TEST(I2C_DeferredIrq, FifoRefillIsDeferred)
+{
+    SetupLargeTransaction(4 * SIMULATED_FIFO_SIZE);
+    default_transaction.data_path = I2C_USE_FIFO;
+    LaunchDefaultTransaction();
+    uint32_t int_en = MOCK_HAL_I2C.IntEn;
+
+    CHECK(int_en & I2C_INTEN_FIFOEMPTY_MASK);
+    ExpectDeferred();
+    TopHalf(I2C_STATUS_FIFOEMPTY_MASK);
+
+    ExpectExternalInterruptDisabled();
+    ExpectExternalInterruptEnabled();
+    BottomHalf();
+    LONGS_EQUAL(int_en, MOCK_HAL_I2C.IntEn);
+}
+
+TEST(I2C_DeferredIrq, DeadlineWaitsForTheBottomHalf)
+{
+    default_transaction.timeout = 2;
+    LaunchDefaultTransaction();
+    ExpectDeferred();
+    TopHalf(I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK);
+
+    // Expired while the completion is pending: not aborted under the bottom half
+    for (uint8_t i = 0; i < 3; i++) {
+        I2C_TimeoutTick();
+    }
+    CHECK_EQUAL(I2C_CMD_NO_ACTION, (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
+
+    // Completed once, by the bottom half
+    ExpectTransactionComplete(I2C_OK);
+    ExpectExternalInterruptDisabled();
+    ExpectExternalInterruptEnabled();
+    BottomHalf();
+    I2C_TimeoutTick();
+    LONGS_EQUAL(I2C_OK, default_transaction.status);
+}
+
+TEST(I2C_DeferredIrq, DeadlineIsAgedAgainOnceTheBottomHalfIsDone)
+{
+    SetupLargeTransaction(4 * SIMULATED_FIFO_SIZE);
+    default_transaction.data_path = I2C_USE_FIFO;
+    default_transaction.timeout   = 2;
+    LaunchDefaultTransaction();
+    ExpectDeferred();
+    TopHalf(I2C_STATUS_FIFOEMPTY_MASK);
+    I2C_TimeoutTick();
+    I2C_TimeoutTick();
+
+    ExpectExternalInterruptDisabled();
+    ExpectExternalInterruptEnabled();
+    BottomHalf();
+
+    I2C_TimeoutTick();
+    ExpectExternalInterruptDisabled();
+    ExpectTransactionComplete(I2C_TRANSACTION_TIMEOUT);
+    ExpectExternalInterruptEnabled();
+    I2C_TimeoutTick();
+}
+
+TEST(I2C_DeferredIrq, RecoveryDropsTheDeferredStatus)
+{
+    I2CTransactionDescriptor second = default_transaction;
+
+    UT_PTR_SET(I2C_WaitCmd, MockWaitCmd);
+    ExpectExternalInterruptDisabled();
+    ExpectExternalInterruptEnabled();
+    LONGS_EQUAL(I2C_OK, I2C_QueueTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction));
+    ExpectExternalInterruptDisabled();
+    ExpectExternalInterruptEnabled();
+    LONGS_EQUAL(I2C_OK, I2C_QueueTransaction((I2CRegisters*) &MOCK_HAL_I2C, &second));
+    ExpectDeferred();
+    TopHalf(I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK);
+
+    // The first descriptor is aborted, the second one is issued
+    MOCK_HAL_I2C.Status = I2C_STATUS_LINESCL_MASK | I2C_STATUS_LINESDA_MASK;
+    ExpectExternalInterruptDisabled();
+    ExpectTransactionComplete(I2C_BUS_HANG);
+    ExpectExternalInterruptEnabled();
+    LONGS_EQUAL(I2C_OK, I2C_RecoverBus((I2CRegisters*) &MOCK_HAL_I2C));
+
+    // The completion of the first one is not applied to the second one
+    BottomHalf();
+    CHECK_EQUAL(I2C_CMD_ISSUE_TRANSACTION,
+                (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
+    CHECK(MOCK_HAL_I2C.IntEn & I2C_INTEN_CMPL_MASK);
+}
+
+#if I2C_FEATURE_DMA
+TEST(I2C_DeferredIrq, DmaEventIsLeftToTheBottomHalf)
+{
+    expected_dmac_transfer_config[I2C_TX].transfer_size = 3;
+    expected_dmac_channel_config[I2C_TX].src_burst_size = DMAC_BURST_SIZE_1;
+    LaunchTransaction(I2C_TX, I2C_USE_DMA);
+    ExpectDeferred();
+    TopHalf(I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK);
+
+    // Raised while the completion is pending: the transaction is not aborted under it
+    I2C_DMACCallback(DMAC_ERROR);
+    CHECK_EQUAL(I2C_CMD_NO_ACTION, (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
+
+    ExpectTransactionComplete(I2C_OK);
+    ExpectExternalInterruptDisabled();
+    ExpectExternalInterruptEnabled();
+    BottomHalf();
+    LONGS_EQUAL(I2C_OK, default_transaction.status);
+}
+#endif
+
+TEST_GROUP(I2C_PollTransaction)
+{
+    void setup(void)
+    {
+        mock().strictOrder();
+        InstallMockFunctions();
+        ResetControllerRegisters();
+        ResetStaticVariables();
+        LONGS_EQUAL(I2C_OK, I2C_Create((I2CRegisters*) &MOCK_HAL_I2C));
+        LONGS_EQUAL(I2C_OK, I2C_SetupController((I2CRegisters*) &MOCK_HAL_I2C, &default_setup));
+        default_transaction.data_count = 3;
+        default_transaction.callback   = NULL;
+    }
+
+    void teardown(void)
+    {
+        mock().checkExpectations();
+        mock().clear();
+    }
+};
+
+TEST(I2C_PollTransaction, InvalidInputReturnsError)
+{
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_PollTransaction(NULL, &default_transaction, 10));
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
+                I2C_PollTransaction((I2CRegisters*) &MOCK_HAL_I2C, NULL, 10));
+    LONGS_EQUAL(I2C_DEVICE_NOT_REGISTERED,
+                I2C_PollTransaction((I2CRegisters*) &MOCK_HAL_I2C_2, &default_transaction, 10));
+
+    ExpectExternalInterruptDisabled();
+    LONGS_EQUAL(I2C_OK, I2C_ShutdownController((I2CRegisters*) &MOCK_HAL_I2C));
+    LONGS_EQUAL(I2C_CONTROLLER_NOT_ENABLED,
+                I2C_PollTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction, 10));
+}
+
+TEST(I2C_PollTransaction, BusyControllerReturnsCommandPending)
+{
+    LaunchDefaultTransaction();
+    MOCK_HAL_I2C.Cmd = I2C_CMD_NO_ACTION;
+
+    LONGS_EQUAL(I2C_CMD_PENDING,
+                I2C_PollTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction, 10));
+}
+
+TEST(I2C_PollTransaction, TxCompletesWithoutInterrupts)
+{
+    MOCK_HAL_I2C.Status |= I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+
+    // No external interrupt nor DMA, even when DMA is requested
+    default_transaction.data_path = I2C_USE_DMA;
+    LONGS_EQUAL(I2C_OK, I2C_PollTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction, 1));
+    LONGS_EQUAL(I2C_OK, default_transaction.status);
+
+    CheckCtrlRegister(I2C_CTRL_PHASE_START_MASK | I2C_CTRL_PHASE_ADDR_MASK |
+                      I2C_CTRL_PHASE_DATA_MASK | I2C_CTRL_PHASE_STOP_MASK,
+                      I2C_TX,
+                      3);
+    CHECK_EQUAL(0, MOCK_HAL_I2C.IntEn);
+    CHECK_EQUAL(0, (MOCK_HAL_I2C.Setup & I2C_SETUP_DMAEN_MASK) >> I2C_SETUP_DMAEN_OFFSET);
+}
+
+TEST(I2C_PollTransaction, RxReadsDataAndCallsCallback)
+{
+    MOCK_HAL_I2C.Status           = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+    MOCK_HAL_I2C.Data             = 0x5A;
+    default_transaction.direction = I2C_RX;
+    default_transaction.callback  = &(MockTransactionCompleteCallback);
+
+    ExpectTransactionComplete(I2C_OK);
+    LONGS_EQUAL(I2C_OK, I2C_PollTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction, 1));
+    for (uint16_t i = 0; i < 3; i++) {
+        BYTES_EQUAL(0x5A, default_data_buffer[i]);
+    }
+    BYTES_EQUAL(0x00, default_data_buffer[3]);
+}
+
+TEST(I2C_PollTransaction, NackReturnsAddrHitError)
+{
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK;
+
+    LONGS_EQUAL(I2C_ADDR_HIT_ERROR,
+                I2C_PollTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction, 1));
+    LONGS_EQUAL(I2C_ADDR_HIT_ERROR, default_transaction.status);
+}
+
+TEST(I2C_PollTransaction, WriteReadPollsBothPhases)
+{
+    SetupWriteReadTransaction();
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+
+    LONGS_EQUAL(I2C_OK, I2C_PollTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction, 2));
+    CheckCtrlRegister(I2C_CTRL_PHASE_START_MASK | I2C_CTRL_PHASE_ADDR_MASK |
+                      I2C_CTRL_PHASE_DATA_MASK | I2C_CTRL_PHASE_STOP_MASK,
+                      I2C_RX,
+                      sizeof(default_rx_data_buffer));
+    CHECK_EQUAL(0, MOCK_HAL_I2C.IntEn);
+}
+
+TEST(I2C_PollTransaction, ExhaustedBudgetResetsControllerAndReturnsTimeout)
+{
+    MOCK_HAL_I2C.Status = 0;
+
+    LONGS_EQUAL(I2C_POLL_TIMEOUT,
+                I2C_PollTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction, 10));
+    LONGS_EQUAL(I2C_POLL_TIMEOUT, default_transaction.status);
+    CHECK_EQUAL(I2C_CMD_RESET, (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
+
+    // The controller is free again once the reset is done
+    MOCK_HAL_I2C.Cmd    = I2C_CMD_NO_ACTION;
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+    LONGS_EQUAL(I2C_OK, I2C_PollTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction, 1));
+}
+
+// The other master's STOP comes during the FIFO clear, the reissued transfer then completes
+static void MockWaitCmdThenComplete(I2CRegisters* i2c_dev)
+{
+    MockWaitCmd(i2c_dev);
+    ((MockI2CRegisters*) i2c_dev)->Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+}
+
+TEST(I2C_PollTransaction, LostArbitrationIsRetriedWithoutTicks)
+{
+    I2CStats* stats;
+
+    UT_PTR_SET(I2C_WaitCmd, MockWaitCmdThenComplete);
+    MOCK_HAL_I2C.Status = I2C_STATUS_ARBLOSE_MASK;
+
+    LONGS_EQUAL(I2C_OK, I2C_PollTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction, 2));
+    LONGS_EQUAL(I2C_OK, default_transaction.status);
+    CHECK_EQUAL(I2C_CMD_CLEAR_FIFO, waited_cmd);
+    // Reissued after the FIFO clear
+    CHECK_EQUAL(I2C_CMD_ISSUE_TRANSACTION,
+                (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
+    CheckCtrlRegister(I2C_CTRL_PHASE_START_MASK | I2C_CTRL_PHASE_ADDR_MASK |
+                      I2C_CTRL_PHASE_DATA_MASK | I2C_CTRL_PHASE_STOP_MASK,
+                      I2C_TX,
+                      3);
+    LONGS_EQUAL(I2C_OK, I2C_GetStats((I2CRegisters*) &MOCK_HAL_I2C, &stats));
+    LONGS_EQUAL(1, stats->arbitration_losses);
+}
+
+TEST(I2C_PollTransaction, IrqHandlerLeavesPolledTransactionAlone)
+{
+    MOCK_HAL_I2C.Status = 0;
+    LONGS_EQUAL(I2C_POLL_TIMEOUT,
+                I2C_PollTransaction((I2CRegisters*) &MOCK_HAL_I2C, &default_transaction, 0));
+
+    // A late completion on the shared interrupt line is not reported again
+    default_transaction.callback = &(MockTransactionCompleteCallback);
+    MOCK_HAL_I2C.Status          = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+    LONGS_EQUAL(I2C_POLL_TIMEOUT, default_transaction.status);
+}
+
+static uint8_t            slave_rx_data[4];
+static uint8_t            slave_tx_data[3] = { 0xA1, 0xA2, 0xA3 };
+static uint8_t            slave_register_file[8];
+#if I2C_FEATURE_SLAVE
+static I2CSlaveDescriptor slave_descriptor;
+
+static void MockSlaveCallback(I2CSlaveEvent event,
+                              uint16_t      data_count)
+{
+    mock().actualCall("MockSlaveCallback")
+    .withParameter("event", event)
+    .withParameter("data_count", data_count);
+}
+
+static void ExpectSlaveEvent(I2CSlaveEvent event,
+                             uint16_t      data_count)
+{
+    mock().expectOneCall("MockSlaveCallback")
+    .withParameter("event", event)
+    .withParameter("data_count", data_count);
+}
+
+static void StartSlave(void)
+{
+    ExpectExternalInterruptDisabled();
+    ExpectExternalInterruptEnabled();
+    LONGS_EQUAL(I2C_OK, I2C_StartSlave((I2CRegisters*) &MOCK_HAL_I2C, &slave_descriptor));
+}
+
+// Simulated controller: the events of one interrupt, with the byte at the head of the RX FIFO
+static void SlaveInterrupt(uint32_t status,
+                           uint8_t  data)
+{
+    MOCK_HAL_I2C.Status = status;
+    MOCK_HAL_I2C.Data   = data;
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+}
+
+static void SlaveAddressed(I2CDirection dir)
+{
+    // The controller sets DIR for the slave: transmit when the master reads
+    MOCK_HAL_I2C.Ctrl = (dir == I2C_TX) ? (I2C_CTRL_DIR_SLAVE_TX << I2C_CTRL_DIR_OFFSET) : 0;
+    SlaveInterrupt(I2C_STATUS_ADDRHIT_MASK, 0);
+}
+
+static void SlaveStopped(uint16_t transferred,
+                         uint8_t  data)
+{
+    MOCK_HAL_I2C.Ctrl = (MOCK_HAL_I2C.Ctrl & ~I2C_CTRL_DATACNT_MASK) |
+                        ((transferred << I2C_CTRL_DATACNT_OFFSET) & I2C_CTRL_DATACNT_MASK);
+    SlaveInterrupt(I2C_STATUS_CMPL_MASK, data);
+}
+
+TEST_GROUP(I2C_SlaveMode)
+{
+    void setup(void)
+    {
+        mock().strictOrder();
+        InstallMockFunctions();
+        ResetControllerRegisters();
+        ResetStaticVariables();
+        MOCK_HAL_I2C.Cfg = 0x00000000; // 2 bytes FIFO: one byte per half FIFO interrupt
+        LONGS_EQUAL(I2C_OK, I2C_Create((I2CRegisters*) &MOCK_HAL_I2C));
+        SetupController(I2C_SLAVE, I2C_STANDARD_MODE);
+
+        for (uint16_t i = 0; i < sizeof(slave_rx_data); i++) {
+            slave_rx_data[i] = 0;
+        }
+        for (uint16_t i = 0; i < sizeof(slave_register_file); i++) {
+            slave_register_file[i] = 0x10 + i;
+        }
+        slave_descriptor.mode            = I2C_SLAVE_BUFFERS;
+        slave_descriptor.addressing_mode = I2C_ADDRESSING_MODE_7_BIT;
+        slave_descriptor.address         = 0x42;
+        slave_descriptor.rx_data         = slave_rx_data;
+        slave_descriptor.rx_data_count   = sizeof(slave_rx_data);
+        slave_descriptor.tx_data         = slave_tx_data;
+        slave_descriptor.tx_data_count   = sizeof(slave_tx_data);
+        slave_descriptor.callback        = &(MockSlaveCallback);
+    }
+
+    void teardown(void)
+    {
+        I2C_StopSlave((I2CRegisters*) &MOCK_HAL_I2C);
+        mock().checkExpectations();
+        mock().clear();
+    }
+};
+
+TEST(I2C_SlaveMode, InvalidInputReturnsError)
+{
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_StartSlave(NULL, &slave_descriptor));
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_StartSlave((I2CRegisters*) &MOCK_HAL_I2C, NULL));
+    LONGS_EQUAL(I2C_DEVICE_NOT_REGISTERED,
+                I2C_StartSlave((I2CRegisters*) &MOCK_HAL_I2C_2, &slave_descriptor));
+
+    slave_descriptor.mode = I2C_SLAVE_UNSUPPORTED_MODE;
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
+                I2C_StartSlave((I2CRegisters*) &MOCK_HAL_I2C, &slave_descriptor));
+
+    slave_descriptor.mode    = I2C_SLAVE_BUFFERS;
+    slave_descriptor.address = I2C_ADDR_MAX_7BIT + 1;
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
+                I2C_StartSlave((I2CRegisters*) &MOCK_HAL_I2C, &slave_descriptor));
+
+    slave_descriptor.address = 0x42;
+    slave_descriptor.rx_data = NULL;
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
+                I2C_StartSlave((I2CRegisters*) &MOCK_HAL_I2C, &slave_descriptor));
+
+    // The register file is rx_data
+    slave_descriptor.mode          = I2C_SLAVE_REGISTER_FILE;
+    slave_descriptor.rx_data_count = 0;
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
+                I2C_StartSlave((I2CRegisters*) &MOCK_HAL_I2C, &slave_descriptor));
+
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_StopSlave(NULL));
+    LONGS_EQUAL(I2C_DEVICE_NOT_REGISTERED, I2C_StopSlave((I2CRegisters*) &MOCK_HAL_I2C_2));
+}
+
+TEST(I2C_SlaveMode, MasterOrDisabledControllerCannotStartSlave)
+{
+    SetupController(I2C_MASTER, I2C_STANDARD_MODE);
+    LONGS_EQUAL(I2C_WRONG_ROLE, I2C_StartSlave((I2CRegisters*) &MOCK_HAL_I2C, &slave_descriptor));
+
+    ExpectExternalInterruptDisabled();
+    LONGS_EQUAL(I2C_OK, I2C_ShutdownController((I2CRegisters*) &MOCK_HAL_I2C));
+    LONGS_EQUAL(I2C_CONTROLLER_NOT_ENABLED,
+                I2C_StartSlave((I2CRegisters*) &MOCK_HAL_I2C, &slave_descriptor));
+}
+
+TEST(I2C_SlaveMode, StartSetsOwnAddressAndAddressInterrupts)
+{
+    StartSlave();
+
+    CHECK_EQUAL(0x42, (MOCK_HAL_I2C.Addr & I2C_ADDR_ADDR_MASK) >> I2C_ADDR_ADDR_OFFSET);
+    CHECK_EQUAL(I2C_INTEN_ADDRHIT_MASK | I2C_INTEN_CMPL_MASK, MOCK_HAL_I2C.IntEn);
+    CHECK_EQUAL(I2C_CMD_CLEAR_FIFO, (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
+
+    LONGS_EQUAL(I2C_OK, I2C_StopSlave((I2CRegisters*) &MOCK_HAL_I2C));
+    CHECK_EQUAL(0, MOCK_HAL_I2C.IntEn);
+}
+
+TEST(I2C_SlaveMode, WriteFillsRxDataInPlace)
+{
+    StartSlave();
+    SlaveAddressed(I2C_RX);
+    CHECK(MOCK_HAL_I2C.IntEn & I2C_INTEN_FIFOHALF_MASK);
+
+    SlaveInterrupt(I2C_STATUS_FIFOHALF_MASK, 0x11);
+    SlaveInterrupt(I2C_STATUS_FIFOHALF_MASK, 0x22);
+
+    // Last byte still in the FIFO at the STOP
+    ExpectSlaveEvent(I2C_SLAVE_RX_DONE, 3);
+    SlaveStopped(3, 0x33);
+
+    BYTES_EQUAL(0x11, slave_rx_data[0]);
+    BYTES_EQUAL(0x22, slave_rx_data[1]);
+    BYTES_EQUAL(0x33, slave_rx_data[2]);
+    BYTES_EQUAL(0x00, slave_rx_data[3]);
+    CHECK_EQUAL(I2C_INTEN_ADDRHIT_MASK | I2C_INTEN_CMPL_MASK, MOCK_HAL_I2C.IntEn);
+
+    // Each write fills rx_data from the start
+    SlaveAddressed(I2C_RX);
+    ExpectSlaveEvent(I2C_SLAVE_RX_DONE, 1);
+    SlaveStopped(1, 0x44);
+    BYTES_EQUAL(0x44, slave_rx_data[0]);
+    BYTES_EQUAL(0x22, slave_rx_data[1]);
+}
+
+TEST(I2C_SlaveMode, WritePastRxDataReportsOverflow)
+{
+    slave_descriptor.rx_data_count = 2;
+    StartSlave();
+    SlaveAddressed(I2C_RX);
+
+    for (uint8_t i = 0; i < 4; i++) {
+        SlaveInterrupt(I2C_STATUS_FIFOHALF_MASK, 0x50 + i);
+    }
+    ExpectSlaveEvent(I2C_SLAVE_RX_OVERFLOW, 2);
+    SlaveStopped(4, 0);
+
+    BYTES_EQUAL(0x50, slave_rx_data[0]);
+    BYTES_EQUAL(0x51, slave_rx_data[1]);
+    BYTES_EQUAL(0x00, slave_rx_data[2]);
+}
+
+TEST(I2C_SlaveMode, ReadDrainsTxDataInPlace)
+{
+    StartSlave();
+
+    // The FIFO is filled when addressed, before the first byte is clocked out
+    SlaveAddressed(I2C_TX);
+    BYTES_EQUAL(0xA2, MOCK_HAL_I2C.Data);
+    SlaveInterrupt(I2C_STATUS_FIFOHALF_MASK, 0);
+    BYTES_EQUAL(0xA3, MOCK_HAL_I2C.Data);
+    SlaveInterrupt(I2C_STATUS_FIFOHALF_MASK, 0);
+
+    // The byte written ahead of the NACK from the master is dropped
+    ExpectSlaveEvent(I2C_SLAVE_TX_DONE, 3);
+    SlaveStopped(3, 0);
+    CHECK_EQUAL(I2C_CMD_CLEAR_FIFO, (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
+}
+
+TEST(I2C_SlaveMode, ReadPastTxDataSendsPaddingAndReportsUnderflow)
+{
+    StartSlave();
+    SlaveAddressed(I2C_TX);
+    SlaveInterrupt(I2C_STATUS_FIFOHALF_MASK, 0);
+    SlaveInterrupt(I2C_STATUS_FIFOHALF_MASK, 0);
+    BYTES_EQUAL(0xFF, MOCK_HAL_I2C.Data);
+
+    ExpectSlaveEvent(I2C_SLAVE_TX_UNDERFLOW, 4);
+    SlaveStopped(4, 0);
+}
+
+TEST(I2C_SlaveMode, RegisterFileWriteSetsPointerThenStoresData)
+{
+    slave_descriptor.mode          = I2C_SLAVE_REGISTER_FILE;
+    slave_descriptor.rx_data       = slave_register_file;
+    slave_descriptor.rx_data_count = sizeof(slave_register_file);
+    slave_descriptor.tx_data       = NULL;
+    slave_descriptor.tx_data_count = 0;
+    StartSlave();
+
+    SlaveAddressed(I2C_RX);
+    SlaveInterrupt(I2C_STATUS_FIFOHALF_MASK, 5);
+    SlaveInterrupt(I2C_STATUS_FIFOHALF_MASK, 0xAA);
+    ExpectSlaveEvent(I2C_SLAVE_RX_DONE, 2);
+    SlaveStopped(3, 0xBB);
+    BYTES_EQUAL(0x14, slave_register_file[4]);
+    BYTES_EQUAL(0xAA, slave_register_file[5]);
+    BYTES_EQUAL(0xBB, slave_register_file[6]);
+    BYTES_EQUAL(0x17, slave_register_file[7]);
+
+    // Pointer write, then read from the pointer
+    SlaveAddressed(I2C_RX);
+    ExpectSlaveEvent(I2C_SLAVE_RX_DONE, 0);
+    SlaveStopped(1, 6);
+
+    SlaveAddressed(I2C_TX);
+    BYTES_EQUAL(0x17, MOCK_HAL_I2C.Data);
+    ExpectSlaveEvent(I2C_SLAVE_TX_DONE, 1);
+    SlaveStopped(1, 0);
+
+    // The next read continues after the bytes read, wrapping around the register file
+    SlaveAddressed(I2C_TX);
+    BYTES_EQUAL(0x10, MOCK_HAL_I2C.Data);
+    ExpectSlaveEvent(I2C_SLAVE_TX_DONE, 2);
+    SlaveStopped(2, 0);
+}
+
+TEST(I2C_SlaveMode, GeneralCallIsReported)
+{
+    StartSlave();
+    MOCK_HAL_I2C.Ctrl = 0;
+    SlaveInterrupt(I2C_STATUS_ADDRHIT_MASK | I2C_STATUS_GENCALL_MASK, 0);
+
+    ExpectSlaveEvent(I2C_SLAVE_GENERAL_CALL, 1);
+    SlaveStopped(1, 0x06);
+    BYTES_EQUAL(0x06, slave_rx_data[0]);
+}
+
+TEST(I2C_SlaveMode, AddressHitAfterStopInSameInterruptStartsNewTransfer)
+{
+    StartSlave();
+    SlaveAddressed(I2C_RX);
+    MOCK_HAL_I2C.Ctrl = (1 << I2C_CTRL_DATACNT_OFFSET) & I2C_CTRL_DATACNT_MASK;
+
+    // Repeated START to the same slave: the write ends and the next transfer begins
+    ExpectSlaveEvent(I2C_SLAVE_RX_DONE, 1);
+    SlaveInterrupt(I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK, 0x77);
+    BYTES_EQUAL(0x77, slave_rx_data[0]);
+    CHECK(MOCK_HAL_I2C.IntEn & I2C_INTEN_FIFOHALF_MASK);
+
+    ExpectSlaveEvent(I2C_SLAVE_RX_DONE, 0);
+    SlaveStopped(0, 0);
+}
+#endif
+
+static uint8_t scl_pulses;
+static uint8_t scl_pulses_to_release_sda;
+
+// Slave releases SDA once it has clocked out the rest of its byte
+static void MockPulseSCL(I2CRegisters* i2c_dev)
+{
+    scl_pulses++;
+    if (scl_pulses == scl_pulses_to_release_sda) {
+        ((MockI2CRegisters*) i2c_dev)->Status |= I2C_STATUS_LINESDA_MASK;
+    }
+}
+
+TEST_GROUP(I2C_BusRecovery)
+{
+    void setup(void)
+    {
+        mock().strictOrder();
+        InstallMockFunctions();
+        ResetControllerRegisters();
+        ResetStaticVariables();
+        LONGS_EQUAL(I2C_OK, I2C_Create((I2CRegisters*) &MOCK_HAL_I2C));
+        SetupController(I2C_MASTER, I2C_STANDARD_MODE);
+        UT_PTR_SET(I2C_WaitCmd, MockWaitCmd);
+        scl_pulses                = 0;
+        scl_pulses_to_release_sda = 0;
+        cmd_waits                 = 0;
+        waited_cmd                = I2C_CMD_NO_ACTION;
+    }
+
+    void teardown(void)
+    {
+        mock().checkExpectations();
+        mock().clear();
+    }
+
+    void LoseArbitration(void)
+    {
+        MOCK_HAL_I2C.Cmd    = I2C_CMD_NO_ACTION;
+        MOCK_HAL_I2C.Status = I2C_STATUS_ARBLOSE_MASK;
+        LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+        CHECK_EQUAL(I2C_CMD_CLEAR_FIFO, waited_cmd);
+    }
+
+    // The descriptor is reissued by the last tick of the backoff only
+    void WaitBackoff(uint32_t ticks)
+    {
+        for (uint32_t i = 1; i < ticks; i++) {
+            I2C_TimeoutTick();
+            CHECK_EQUAL(I2C_CMD_NO_ACTION,
+                        (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
+        }
+        ExpectExternalInterruptDisabled();
+        ExpectExternalInterruptEnabled();
+        I2C_TimeoutTick();
+        CHECK_EQUAL(I2C_CMD_ISSUE_TRANSACTION,
+                    (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
+    }
+
+    void RecoverBus(I2CReturnCode expected)
+    {
+        ExpectExternalInterruptDisabled();
+        ExpectExternalInterruptEnabled();
+        LONGS_EQUAL(expected, I2C_RecoverBus((I2CRegisters*) &MOCK_HAL_I2C));
+        CHECK_EQUAL(I2C_CMD_RESET, waited_cmd);
+    }
+};
+
+TEST(I2C_BusRecovery, RecoveryAfterShutdownLeavesTheInterruptOff)
+{
+    LaunchDefaultTransaction();
+    ExpectExternalInterruptDisabled();
+    LONGS_EQUAL(I2C_OK, I2C_ShutdownController((I2CRegisters*) &MOCK_HAL_I2C));
+
+    MOCK_HAL_I2C.Status = I2C_STATUS_LINESCL_MASK | I2C_STATUS_LINESDA_MASK;
+    ExpectExternalInterruptDisabled();
+    ExpectTransactionComplete(I2C_BUS_HANG);
+    LONGS_EQUAL(I2C_OK, I2C_RecoverBus((I2CRegisters*) &MOCK_HAL_I2C));
+}
+
+TEST(I2C_BusRecovery, TransactionEnablesArbitrationLossInterrupt)
+{
+    LaunchDefaultTransaction();
+    CHECK(MOCK_HAL_I2C.IntEn & I2C_INTEN_ARBLOSE_MASK);
+}
+
+TEST(I2C_BusRecovery, ArbitrationLossStartsDescriptorOver)
+{
+    I2CStats* stats;
+
+    default_transaction.data_count = 3;
+    LaunchDefaultTransaction();
+    LoseArbitration();
+    WaitBackoff(I2C_ARBITRATION_BACKOFF_TICKS);
+
+    CheckCtrlRegister(I2C_CTRL_PHASE_START_MASK | I2C_CTRL_PHASE_ADDR_MASK |
+                      I2C_CTRL_PHASE_DATA_MASK | I2C_CTRL_PHASE_STOP_MASK,
+                      I2C_TX,
+                      3);
+    LONGS_EQUAL(I2C_OK, I2C_GetStats((I2CRegisters*) &MOCK_HAL_I2C, &stats));
+    LONGS_EQUAL(1, stats->arbitration_losses);
+    LONGS_EQUAL(1, stats->fifo_transactions);
+
+    ExpectTransactionComplete(I2C_OK);
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+}
+
+TEST(I2C_BusRecovery, WriteReadLosingArbitrationInReadPhaseStartsWithWritePhase)
+{
+    SetupWriteReadTransaction();
+    LaunchDefaultTransaction();
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+    LoseArbitration();
+    WaitBackoff(I2C_ARBITRATION_BACKOFF_TICKS);
+
+    CheckCtrlRegister(I2C_CTRL_PHASE_START_MASK | I2C_CTRL_PHASE_ADDR_MASK |
+                      I2C_CTRL_PHASE_DATA_MASK,
+                      I2C_TX,
+                      2);
+}
+
+TEST(I2C_BusRecovery, RepeatedArbitrationLossReportsError)
+{
+    LaunchDefaultTransaction();
+    for (uint8_t i = 0; i < I2C_ARBITRATION_RETRIES; i++) {
+        LoseArbitration();
+        WaitBackoff(I2C_ARBITRATION_BACKOFF_TICKS << i);
+    }
+
+    ExpectTransactionComplete(I2C_ARBITRATION_LOST);
+    MOCK_HAL_I2C.Cmd    = I2C_CMD_NO_ACTION;
+    MOCK_HAL_I2C.Status = I2C_STATUS_ARBLOSE_MASK;
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+    LONGS_EQUAL(I2C_ARBITRATION_LOST, default_transaction.status);
+}
+
+TEST(I2C_BusRecovery, FifoClearNotFinishingReportsCmdPending)
+{
+    LaunchDefaultTransaction();
+
+    // The Cmd field keeps reading CLEAR_FIFO
+    UT_PTR_SET(I2C_WaitCmd, NULL);
+    ExpectTransactionComplete(I2C_CMD_PENDING);
+    MOCK_HAL_I2C.Cmd    = I2C_CMD_NO_ACTION;
+    MOCK_HAL_I2C.Status = I2C_STATUS_ARBLOSE_MASK;
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+    LONGS_EQUAL(I2C_CMD_PENDING, default_transaction.status);
+
+    // Nothing left to reissue
+    I2C_TimeoutTick();
+    CHECK_EQUAL(I2C_CMD_CLEAR_FIFO, (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
+}
+
+TEST(I2C_BusRecovery, RecoverBusWithInvalidInputReturnsError)
+{
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_RecoverBus(NULL));
+    LONGS_EQUAL(I2C_DEVICE_NOT_REGISTERED, I2C_RecoverBus((I2CRegisters*) &MOCK_HAL_I2C_2));
+}
+
+TEST(I2C_BusRecovery, ReleasedBusOnlyResetsController)
+{
+    I2CStats* stats;
+
+    MOCK_HAL_I2C.Status = I2C_STATUS_LINESDA_MASK | I2C_STATUS_LINESCL_MASK;
+    UT_PTR_SET(I2C_PulseSCL, MockPulseSCL);
+    RecoverBus(I2C_OK);
+
+    LONGS_EQUAL(0, scl_pulses);
+    LONGS_EQUAL(I2C_OK, I2C_GetStats((I2CRegisters*) &MOCK_HAL_I2C, &stats));
+    LONGS_EQUAL(0, stats->bus_recoveries);
+}
+
+TEST(I2C_BusRecovery, EveryRecoveryIsTimed)
+{
+    I2CStats* stats;
+
+    MOCK_HAL_I2C.Status    = I2C_STATUS_LINESDA_MASK | I2C_STATUS_LINESCL_MASK;
+    mock_cycle_counts[0]   = 100;
+    mock_cycle_counts[1]   = 340;
+    mock_cycle_count_index = 0;
+    UT_PTR_SET(I2C_GetCycleCount, MockGetCycleCount);
+    RecoverBus(I2C_OK);
+
+    LONGS_EQUAL(I2C_OK, I2C_GetStats((I2CRegisters*) &MOCK_HAL_I2C, &stats));
+    LONGS_EQUAL(240, stats->recovery_cycles);
+}
+
+TEST(I2C_BusRecovery, SclHeldLowReportsBusHangWithoutPulses)
+{
+    I2CStats* stats;
+
+    MOCK_HAL_I2C.Status    = I2C_STATUS_LINESDA_MASK;
+    mock_cycle_counts[0]   = 100;
+    mock_cycle_counts[1]   = 160;
+    mock_cycle_count_index = 0;
+    UT_PTR_SET(I2C_PulseSCL, MockPulseSCL);
+    UT_PTR_SET(I2C_GetCycleCount, MockGetCycleCount);
+    RecoverBus(I2C_BUS_HANG);
+
+    LONGS_EQUAL(0, scl_pulses);
+    LONGS_EQUAL(I2C_OK, I2C_GetStats((I2CRegisters*) &MOCK_HAL_I2C, &stats));
+    LONGS_EQUAL(1, stats->bus_recoveries);
+    LONGS_EQUAL(60, stats->recovery_cycles);
+
+    // Also with SDA low, no pulse is driven on a held clock
+    MOCK_HAL_I2C.Status = 0;
+    RecoverBus(I2C_BUS_HANG);
+    LONGS_EQUAL(0, scl_pulses);
+}
+
+TEST(I2C_BusRecovery, SdaHeldLowIsClockedOut)
+{
+    I2CStats* stats;
+
+    MOCK_HAL_I2C.Status       = I2C_STATUS_LINESCL_MASK;
+    scl_pulses_to_release_sda = 3;
+    mock_cycle_counts[0]      = 500;
+    mock_cycle_counts[1]      = 2300;
+    mock_cycle_count_index    = 0;
+    UT_PTR_SET(I2C_PulseSCL, MockPulseSCL);
+    UT_PTR_SET(I2C_GetCycleCount, MockGetCycleCount);
+    RecoverBus(I2C_OK);
+
+    LONGS_EQUAL(3, scl_pulses);
+    LONGS_EQUAL(I2C_OK, I2C_GetStats((I2CRegisters*) &MOCK_HAL_I2C, &stats));
+    LONGS_EQUAL(1, stats->bus_recoveries);
+    LONGS_EQUAL(1800, stats->recovery_cycles);
+}
+
+TEST(I2C_BusRecovery, SdaStillLowAfterPulsesReportsBusHang)
+{
+    MOCK_HAL_I2C.Status = I2C_STATUS_LINESCL_MASK;
+    UT_PTR_SET(I2C_PulseSCL, MockPulseSCL);
+    RecoverBus(I2C_BUS_HANG);
+    LONGS_EQUAL(I2C_BUS_RECOVERY_PULSES, scl_pulses);
+
+    // Without board support for the pulses
+    UT_PTR_SET(I2C_PulseSCL, NULL);
+    RecoverBus(I2C_BUS_HANG);
+}
+
+TEST(I2C_BusRecovery, RecoverBusAbortsTransactionInProgress)
+{
+    LaunchDefaultTransaction();
+    MOCK_HAL_I2C.Status = I2C_STATUS_LINESDA_MASK | I2C_STATUS_LINESCL_MASK;
+
+    ExpectExternalInterruptDisabled();
+    ExpectTransactionComplete(I2C_BUS_HANG);
+    ExpectExternalInterruptEnabled();
+    LONGS_EQUAL(I2C_OK, I2C_RecoverBus((I2CRegisters*) &MOCK_HAL_I2C));
+    LONGS_EQUAL(I2C_BUS_HANG, default_transaction.status);
+
+    // The controller is free for the next transaction
+    MOCK_HAL_I2C.Cmd = I2C_CMD_NO_ACTION;
+    LaunchDefaultTransaction();
+}
+
+TEST_GROUP(I2C_Timeout)
+{
+    void setup(void)
+    {
+        mock().strictOrder();
+        InstallMockFunctions();
+        ResetControllerRegisters();
+        ResetStaticVariables();
+        LONGS_EQUAL(I2C_OK, I2C_Create((I2CRegisters*) &MOCK_HAL_I2C));
+        SetupController(I2C_MASTER, I2C_STANDARD_MODE);
+        default_transaction.timeout = 3;
+    }
+
+    void teardown(void)
+    {
+        mock().checkExpectations();
+        mock().clear();
+    }
+
+    void Tick(uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; i++) {
+            I2C_TimeoutTick();
+        }
+    }
+
+    void ExpectExpiry(void)
+    {
+        ExpectExternalInterruptDisabled();
+        ExpectTransactionComplete(I2C_TRANSACTION_TIMEOUT);
+        ExpectExternalInterruptEnabled();
+    }
+};
+
+TEST(I2C_Timeout, TransactionCompletedBeforeDeadlineIsNotAborted)
+{
+    LaunchDefaultTransaction();
+    Tick(2);
+
+    ExpectTransactionComplete(I2C_OK);
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+    Tick(5);
+}
+
+TEST(I2C_Timeout, ExpiredTransactionIsAbortedWithControllerReset)
+{
+    LaunchDefaultTransaction();
+    Tick(2);
+    CHECK_EQUAL(I2C_CMD_ISSUE_TRANSACTION,
+                (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
+
+    ExpectExpiry();
+    Tick(1);
+
+    CHECK_EQUAL(I2C_CMD_RESET, (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
+    LONGS_EQUAL(I2C_TRANSACTION_TIMEOUT, default_transaction.status);
+    Tick(5);
+}
+
+TEST(I2C_Timeout, NoTimeoutNeverExpires)
+{
+    default_transaction.timeout = 0;
+    LaunchDefaultTransaction();
+    Tick(1000);
+
+    CHECK_EQUAL(I2C_CMD_ISSUE_TRANSACTION,
+                (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
+}
+
+TEST(I2C_Timeout, LateEventsOfExpiredTransactionAreIgnored)
+{
+    LaunchDefaultTransaction();
+    ExpectExpiry();
+    Tick(3);
+
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+}
+
+TEST(I2C_Timeout, ArbitrationRetryKeepsDeadline)
+{
+    UT_PTR_SET(I2C_WaitCmd, MockWaitCmd);
+    LaunchDefaultTransaction();
+    Tick(1);
+
+    MOCK_HAL_I2C.Cmd    = I2C_CMD_NO_ACTION;
+    MOCK_HAL_I2C.Status = I2C_STATUS_ARBLOSE_MASK;
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+
+    // The backoff tick also counts towards the deadline
+    ExpectExternalInterruptDisabled();
+    ExpectExternalInterruptEnabled();
+    Tick(I2C_ARBITRATION_BACKOFF_TICKS);
+    CHECK_EQUAL(I2C_CMD_ISSUE_TRANSACTION,
+                (MOCK_HAL_I2C.Cmd & I2C_CMD_CMD_MASK) >> I2C_CMD_CMD_OFFSET);
+
+    ExpectExpiry();
+    Tick(1);
+}
+
+TEST(I2C_Timeout, ExpiryAfterShutdownLeavesTheInterruptOff)
+{
+    LaunchDefaultTransaction();
+    ExpectExternalInterruptDisabled();
+    LONGS_EQUAL(I2C_OK, I2C_ShutdownController((I2CRegisters*) &MOCK_HAL_I2C));
+
+    ExpectExternalInterruptDisabled();
+    ExpectTransactionComplete(I2C_TRANSACTION_TIMEOUT);
+    Tick(3);
+}
+
+TEST(I2C_Timeout, RelaunchedTransactionGetsNewDeadline)
+{
+    LaunchDefaultTransaction();
+    ExpectExpiry();
+    Tick(3);
+
+    MOCK_HAL_I2C.Cmd            = I2C_CMD_NO_ACTION;
+    default_transaction.timeout = 5;
+    LaunchDefaultTransaction();
+    Tick(4);
+
+    ExpectExpiry();
+    Tick(1);
+}
+
+TEST_GROUP(I2C_ShutdownController)
+{
+    void setup(void)
+    {
+        mock().strictOrder();
+        ResetControllerRegisters();
+        LONGS_EQUAL(I2C_OK, I2C_Create((I2CRegisters*) &MOCK_HAL_I2C));
+    }
+
+    void teardown(void)
+    {
+        mock().checkExpectations();
+        mock().clear();
+    }
+};
+
+TEST(I2C_ShutdownController, NullDeviceReturnsInvalidInputData)
+{
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_ShutdownController(NULL));
+}
+
+TEST_GROUP(I2C_SetupController)
+{
+    void setup(void)
+    {
+        mock().strictOrder();
+        ResetControllerRegisters();
+        LONGS_EQUAL(I2C_OK, I2C_Create((I2CRegisters*) &MOCK_HAL_I2C));
+    }
+
+    void teardown(void)
+    {
+        mock().checkExpectations();
+        mock().clear();
+    }
+};
+
+TEST(I2C_SetupController, NullDeviceReturnsInvalidInputData)
+{
+    I2CSetupInfo setup_info = {I2C_MASTER, I2C_STANDARD_MODE};
+
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_SetupController(NULL, &setup_info));
+}
+
+TEST(I2C_SetupController, NullSetupInfoReturnsInvalidInputData)
+{
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
+                I2C_SetupController((I2CRegisters*) &MOCK_HAL_I2C, NULL));
+}
+
+TEST(I2C_SetupController, UnsupportedModeReturnsInvalidInputData)
+{
+    I2CSetupInfo setup_info = {I2C_MASTER, I2C_UNSUPPORTED_MODE};
+
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
+                I2C_SetupController((I2CRegisters*) &MOCK_HAL_I2C, &setup_info));
+}
+
+TEST(I2C_SetupController, UnchangedSettingsAreNotWrittenAgain)
+{
+    I2CStats* stats = NULL;
+
+    LONGS_EQUAL(I2C_OK, I2C_GetStats((I2CRegisters*) &MOCK_HAL_I2C, &stats));
+    uint32_t reads  = stats->mmio_reads;
+    uint32_t writes = stats->mmio_writes;
+
+    // Complete Setup value written once, TPM already holds its value
+    SetupController(I2C_MASTER, I2C_STANDARD_MODE);
+    CHECK_EQUAL(1, stats->mmio_writes - writes);
+    SetupController(I2C_MASTER, I2C_STANDARD_MODE);
+    CHECK_EQUAL(1, stats->mmio_writes - writes);
+#if I2C_FEATURE_FAST_MODES
+    SetupController(I2C_MASTER, I2C_FAST_MODE);
+    CHECK_EQUAL(2, stats->mmio_writes - writes);
+    CheckTimingParams(I2C_FAST_MODE);
+#endif
+
+    // Settings are taken from the shadow registers
+    CHECK_EQUAL(0, stats->mmio_reads - reads);
+}
+
+TEST(I2C_SetupController, SetupShutdownWorksAsExpected)
+{
+    CheckSetupShutdownController(I2C_MASTER, I2C_STANDARD_MODE);
+#if I2C_FEATURE_FAST_MODES
+    CheckSetupShutdownController(I2C_MASTER, I2C_FAST_MODE);
+    CheckSetupShutdownController(I2C_MASTER, I2C_FAST_MODE_PLUS);
+#endif
+#if I2C_FEATURE_SLAVE
+    CheckSetupShutdownController(I2C_SLAVE, I2C_STANDARD_MODE);
+#endif
+#if I2C_FEATURE_SLAVE && I2C_FEATURE_FAST_MODES
+    CheckSetupShutdownController(I2C_SLAVE, I2C_FAST_MODE);
+    CheckSetupShutdownController(I2C_SLAVE, I2C_FAST_MODE_PLUS);
+#endif
+}
+
+// Achieved with the SCL frequency class limits, see CheckTimingParams
+static void CheckComputedTiming(uint32_t         scl_frequency,
+                                uint32_t         apb_clock,
+                                const I2CTiming* timing)
+{
+    // value, Standard Mode, Fast-mode, Fast-Mode+
+    double  min_sudat[] = {250, 100, 50};
+    double  min_hddat[] = {300, 300, 0};
+    double  min_sclhi[] = {4000, 600, 260};
+    double  min_scllo[] = {4700, 1300, 500};
+    double  max_sp      = 50;
+    uint8_t bus_class   = (scl_frequency <= 100000) ? 0 : (scl_frequency <= 400000) ? 1 : 2;
+
+    double t_pclk  = 1e9 / apb_clock;
+    double t_cycle = t_pclk * (timing->tpm + 1);
+
+    double pg_spike_suppression_width = timing->t_sp * t_cycle;
+    double pg_setup_time              = (2 * t_pclk) + ((2 + timing->t_sp + timing->t_sudat) * t_cycle);
+    double pg_hold_time               = (2 * t_pclk) + ((2 + timing->t_sp + timing->t_hddat) * t_cycle);
+    double pg_sclhi_period            = (2 * t_pclk) + ((2 + timing->t_sp + timing->t_sclhi) * t_cycle);
+    double pg_scllo_period            = (2 * t_pclk) +
+                                        ((2 + timing->t_sp +
+                                          (timing->t_sclhi * (1 + timing->t_sclratio))) * t_cycle);
+
+    CHECK(timing->tpm <= I2C_TIMING_TPM_MAX);
+    CHECK(timing->t_sp <= I2C_TIMING_SP_MAX);
+    CHECK(timing->t_sudat <= I2C_TIMING_SUDAT_MAX);
+    CHECK(timing->t_hddat <= I2C_TIMING_HDDAT_MAX);
+    CHECK(timing->t_sclhi <= I2C_TIMING_SCLHI_MAX);
+
+    CHECK(pg_spike_suppression_width <= max_sp);
+    CHECK(pg_setup_time >= min_sudat[bus_class]);
+    CHECK(pg_hold_time >= min_hddat[bus_class]);
+    CHECK(pg_sclhi_period >= min_sclhi[bus_class]);
+    CHECK(pg_scllo_period >= min_scllo[bus_class]);
+
+    // Reported frequency: never above the requested one, within 10% with 50 APB cycles per SCL
+    uint32_t period = 4 + ((4 + (2 * timing->t_sp) + (timing->t_sclhi * (2 + timing->t_sclratio))) *
+                           (timing->tpm + 1));
+
+    CHECK_EQUAL(apb_clock / period, timing->scl_frequency);
+    CHECK(timing->scl_frequency <= scl_frequency);
+    CHECK((apb_clock < (50 * scl_frequency)) ||
+          ((10 * timing->scl_frequency) >= (9 * scl_frequency)));
+}
+
+TEST_GROUP(I2C_ComputeTiming)
+{
+    void setup(void)
+    {
+        mock().strictOrder();
+        ResetControllerRegisters();
+        LONGS_EQUAL(I2C_OK, I2C_Create((I2CRegisters*) &MOCK_HAL_I2C));
+    }
+
+    void teardown(void)
+    {
+        mock().checkExpectations();
+        mock().clear();
+    }
+};
+
+TEST(I2C_ComputeTiming, InvalidInputsReturnInvalidInputData)
+{
+    I2CTiming timing;
+
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_ComputeTiming(100000, 50000000, NULL));
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_ComputeTiming(0, 50000000, &timing));
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_ComputeTiming(1000001, 50000000, &timing));
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_ComputeTiming(400000, 300000, &timing));
+}
+
+TEST(I2C_ComputeTiming, FieldsOutOfRangeReturnTimingOutOfRange)
+{
+    I2CTiming timing;
+
+    // Multiplier above 31 to stretch T_SCLHI over a 1 kHz period
+    LONGS_EQUAL(I2C_TIMING_OUT_OF_RANGE, I2C_ComputeTiming(1000, 200000000, &timing));
+    CHECK_FALSE(I2C_TIMING_VALID(1000, 200000000));
+}
+
+TEST(I2C_ComputeTiming, TimingMeetsSpecForAnyFrequency)
+{
+    uint32_t scl_frequencies[] = {10000, 50000, 100000, 250000, 400000, 600000, 1000000};
+    uint32_t apb_clocks[]      = {8000000, 16000000, 50000000, 100000000, 200000000};
+
+    for (uint8_t i = 0; i < sizeof(scl_frequencies) / sizeof(scl_frequencies[0]); i++) {
+        for (uint8_t j = 0; j < sizeof(apb_clocks) / sizeof(apb_clocks[0]); j++) {
+            I2CTiming timing;
+
+            LONGS_EQUAL(I2C_OK, I2C_ComputeTiming(scl_frequencies[i], apb_clocks[j], &timing));
+            CheckComputedTiming(scl_frequencies[i], apb_clocks[j], &timing);
+        }
+    }
+}
+
+TEST(I2C_ComputeTiming, StandardModeMatchesTunedDataTimes)
+{
+    I2CTiming timing;
+
+    // Same data setup and hold times as I2C_STANDARD_MODE at 50 MHz, exactly 100 kHz
+    LONGS_EQUAL(I2C_OK, I2C_ComputeTiming(100000, 50000000, &timing));
+    CHECK_EQUAL(0, timing.tpm);
+    CHECK_EQUAL(2, timing.t_sp);
+    CHECK_EQUAL(7, timing.t_sudat);
+    CHECK_EQUAL(9, timing.t_hddat);
+    CHECK_EQUAL(100000u, timing.scl_frequency);
+}
+
+TEST(I2C_ComputeTiming, CompileTimeTimingMatchesRuntimeTiming)
+{
+    static const I2CTiming fast_mode_timing      = I2C_TIMING(400000, 200000000);
+    static const I2CTiming intermediate_timing   = I2C_TIMING(250000, 16000000);
+    static const I2CTiming fast_mode_plus_timing = I2C_TIMING(1000000, 50000000);
+    const I2CTiming*       expected[]            = {
+        &fast_mode_timing, &intermediate_timing, &fast_mode_plus_timing
+    };
+    uint32_t               scl_frequencies[]     = {400000, 250000, 1000000};
+    uint32_t               apb_clocks[]          = {200000000, 16000000, 50000000};
+
+    CHECK(I2C_TIMING_VALID(400000, 200000000));
+    for (uint8_t i = 0; i < 3; i++) {
+        I2CTiming timing;
+
+        LONGS_EQUAL(I2C_OK, I2C_ComputeTiming(scl_frequencies[i], apb_clocks[i], &timing));
+        CHECK_EQUAL(expected[i]->tpm, timing.tpm);
+        CHECK_EQUAL(expected[i]->t_sp, timing.t_sp);
+        CHECK_EQUAL(expected[i]->t_sudat, timing.t_sudat);
+        CHECK_EQUAL(expected[i]->t_hddat, timing.t_hddat);
+        CHECK_EQUAL(expected[i]->t_sclhi, timing.t_sclhi);
+        CHECK_EQUAL(expected[i]->t_sclratio, timing.t_sclratio);
+        CHECK_EQUAL(expected[i]->scl_frequency, timing.scl_frequency);
+    }
+}
+
+TEST(I2C_ComputeTiming, SetupControllerProgramsComputedTiming)
+{
+    I2CTiming    timing;
+    I2CSetupInfo setup_info = {I2C_MASTER, I2C_STANDARD_MODE, &timing};
+
+    LONGS_EQUAL(I2C_OK, I2C_ComputeTiming(400000, 200000000, &timing));
+    LONGS_EQUAL(I2C_OK, I2C_SetupController((I2CRegisters*) &MOCK_HAL_I2C, &setup_info));
+    CHECK_EQUAL(timing.tpm, HAL_TPM);
+    CHECK_EQUAL(timing.t_sp, HAL_T_SP);
+    CHECK_EQUAL(timing.t_sudat, HAL_T_SUDAT);
+    CHECK_EQUAL(timing.t_hddat, HAL_T_HDDAT);
+    CHECK_EQUAL(timing.t_sclhi, HAL_T_SCLHI);
+    CHECK_EQUAL(timing.t_sclratio, HAL_T_SCLRATIO);
+
+    timing.t_sudat = I2C_TIMING_SUDAT_MAX + 1;
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA,
+                I2C_SetupController((I2CRegisters*) &MOCK_HAL_I2C, &setup_info));
+}
+
+TEST_GROUP(I2C_Create)
+{
+    void setup(void)
+    {
+        mock().strictOrder();
+    }
+
+    void teardown(void)
+    {
+        mock().checkExpectations();
+        mock().clear();
+    }
+};
+
+TEST(I2C_Create, NullDeviceReturnsInvalidInputData)
+{
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_Create(NULL));
+}
+
+TEST(I2C_Create, NullDeviceDestroyReturnsInvalidInputData)
+{
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_Destroy(NULL));
+}
+
+TEST(I2C_Create, UnregisteredDeviceDestroyReturnsDeviceNotRegistered)
+{
+    LONGS_EQUAL(I2C_DEVICE_NOT_REGISTERED, I2C_Destroy((I2CRegisters*) &MOCK_HAL_I2C_2));
+}
+
+TEST(I2C_Create, NoDeviceContextAvailableWhenAllContextsAreRegistered)
+{
+    MockI2CRegisters i2c_devs[I2C_MAX_DEVICES + 1];
+
+    I2C_Destroy((I2CRegisters*) &MOCK_HAL_I2C);
+    for (uint8_t i = 0; i < I2C_MAX_DEVICES; i++) {
+        LONGS_EQUAL(I2C_OK, I2C_Create((I2CRegisters*) &i2c_devs[i]));
+    }
+    LONGS_EQUAL(I2C_NO_DEVICE_CONTEXT_AVAILABLE,
+                I2C_Create((I2CRegisters*) &i2c_devs[I2C_MAX_DEVICES]));
+
+    // Creating an already registered device reuses its context
+    LONGS_EQUAL(I2C_OK, I2C_Create((I2CRegisters*) &i2c_devs[0]));
+
+    for (uint8_t i = 0; i < I2C_MAX_DEVICES; i++) {
+        LONGS_EQUAL(I2C_OK, I2C_Destroy((I2CRegisters*) &i2c_devs[i]));
+    }
+}
+
+TEST_GROUP(I2C_GetConfig)
+{
+    void setup(void)
+    {
+        mock().strictOrder();
+        ResetStaticVariables();
+        ResetControllerRegisters();
+        LONGS_EQUAL(I2C_OK, I2C_Create((I2CRegisters*) &MOCK_HAL_I2C));
+    }
+
+    void teardown(void)
+    {
+        mock().checkExpectations();
+        mock().clear();
+    }
+};
+
+TEST(I2C_GetConfig, NullDeviceReturnsInvalidInputData)
+{
+    I2CConfig* return_value;
+
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_GetConfig(NULL, &return_value));
+}
+
+TEST(I2C_GetConfig, UnregisteredDeviceReturnsDeviceNotRegistered)
+{
+    I2CConfig* return_value;
+
+    LONGS_EQUAL(I2C_DEVICE_NOT_REGISTERED,
+                I2C_GetConfig((I2CRegisters*) &MOCK_HAL_I2C_2, &return_value));
+}
+
+TEST(I2C_GetConfig, NullReturnValueReturnsInvalidInputData)
+{
+    LONGS_EQUAL(I2C_INVALID_INPUT_DATA, I2C_GetConfig((I2CRegisters*) &MOCK_HAL_I2C, NULL));
+}
+
+TEST(I2C_GetConfig, ReturnsConfig)
+{
+    I2CConfig* i2c_config;
 
     LONGS_EQUAL(I2C_OK, I2C_GetConfig((I2CRegisters*) &MOCK_HAL_I2C, &i2c_config));
 
@@ -906,3 +4063,185 @@ TEST(I2C_GetConfig, ReturnsConfig)
     LONGS_EQUAL(0x0A, i2c_config->id_rev.major);
     LONGS_EQUAL(0x0B, i2c_config->id_rev.minor);
 }
+
+#if I2C_MAX_DEVICES > 1
+TEST_GROUP(I2C_MultiInstance)
+{
+    uint8_t second_data_buffer[8];
+    I2CTransactionDescriptor second_transaction;
+
+    void setup(void)
+    {
+        mock().strictOrder();
+        mock().installComparator("DMACChannelConfig*", channel_config_comparator);
+        mock().installComparator("DMACTransferConfig*", transfer_config_comparator);
+        InstallMockFunctions();
+        ResetControllerRegisters();
+        ResetSecondControllerRegisters();
+        ResetStaticVariables();
+        LONGS_EQUAL(I2C_OK, I2C_Create((I2CRegisters*) &MOCK_HAL_I2C));
+        LONGS_EQUAL(I2C_OK, I2C_Create((I2CRegisters*) &MOCK_HAL_I2C_2));
+        SetupController(I2C_MASTER, I2C_STANDARD_MODE);
+        LONGS_EQUAL(I2C_OK,
+                    I2C_SetupController((I2CRegisters*) &MOCK_HAL_I2C_2, &default_setup));
+
+        for (uint16_t i = 0; i < sizeof(second_data_buffer); i++) {
+            second_data_buffer[i] = 0;
+        }
+        second_transaction.type            = I2C_SIMPLE_TRANSACTION;
+        second_transaction.addressing_mode = I2C_ADDRESSING_MODE_7_BIT;
+        second_transaction.direction       = I2C_RX;
+        second_transaction.data_path       = I2C_USE_FIFO;
+        second_transaction.address         = 0x40;
+        second_transaction.data            = second_data_buffer;
+        second_transaction.data_count      = sizeof(second_data_buffer);
+        second_transaction.rx_data         = NULL;
+        second_transaction.rx_data_count   = 0;
+        second_transaction.callback        = &(MockSecondTransactionCompleteCallback);
+        second_transaction.dma_priority    = I2C_DMA_PRIORITY_DEFAULT;
+        second_transaction.dma_burst_size  = I2C_DMA_BURST_SIZE_AUTO;
+    }
+
+    void teardown(void)
+    {
+        mock().checkExpectations();
+        mock().clear();
+        mock().removeAllComparatorsAndCopiers();
+        I2C_Destroy((I2CRegisters*) &MOCK_HAL_I2C_2);
+        I2C_Destroy((I2CRegisters*) &MOCK_HAL_I2C);
+    }
+
+    void LaunchSecondTransaction(I2CReturnCode expected_return_code)
+    {
+        if (expected_return_code == I2C_OK) {
+            ExpectExternalInterruptEnabled();
+        }
+        LONGS_EQUAL(expected_return_code,
+                    I2C_LaunchTransaction((I2CRegisters*) &MOCK_HAL_I2C_2, &second_transaction));
+    }
+};
+
+TEST(I2C_MultiInstance, GetConfigReturnsPerDeviceConfig)
+{
+    I2CConfig* first_config;
+    I2CConfig* second_config;
+
+    LONGS_EQUAL(I2C_OK, I2C_GetConfig((I2CRegisters*) &MOCK_HAL_I2C, &first_config));
+    LONGS_EQUAL(I2C_OK, I2C_GetConfig((I2CRegisters*) &MOCK_HAL_I2C_2, &second_config));
+
+    CHECK(first_config != second_config);
+    LONGS_EQUAL(16, first_config->fifo_size);
+    LONGS_EQUAL(0x0A, first_config->id_rev.major);
+    LONGS_EQUAL(4, second_config->fifo_size);
+    LONGS_EQUAL(0x0C, second_config->id_rev.major);
+    LONGS_EQUAL(0x0D, second_config->id_rev.minor);
+}
+
+TEST(I2C_MultiInstance, OverlappingTransfersCompleteIndependently)
+{
+    LaunchTransaction(I2C_TX, I2C_USE_FIFO);
+    LaunchSecondTransaction(I2C_OK);
+
+    // Second controller drains its 4 bytes FIFO once, then completes first
+    MOCK_HAL_I2C_2.Status = I2C_STATUS_FIFOFULL_MASK;
+    MOCK_HAL_I2C_2.Data   = 0x5A;
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C_2));
+    BYTES_EQUAL(0x5A, second_data_buffer[3]);
+    BYTES_EQUAL(0x00, second_data_buffer[4]);
+
+    MOCK_HAL_I2C_2.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+    ExpectSecondTransactionComplete(I2C_OK);
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C_2));
+    for (uint16_t i = 0; i < sizeof(second_data_buffer); i++) {
+        BYTES_EQUAL(0x5A, second_data_buffer[i]);
+    }
+
+    // First controller transfer is still in flight
+    CHECK((MOCK_HAL_I2C.IntEn & I2C_INTEN_CMPL_MASK) >> I2C_INTEN_CMPL_OFFSET);
+    CHECK_EQUAL(default_transaction.address,
+                (MOCK_HAL_I2C.Addr & I2C_ADDR_ADDR_MASK) >> I2C_ADDR_ADDR_OFFSET);
+    CHECK_EQUAL(second_transaction.address,
+                (MOCK_HAL_I2C_2.Addr & I2C_ADDR_ADDR_MASK) >> I2C_ADDR_ADDR_OFFSET);
+
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK;
+    ExpectTransactionComplete(I2C_ADDR_HIT_ERROR);
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+}
+
+TEST(I2C_MultiInstance, SharedIrqDispatchesToEachDevice)
+{
+    LaunchTransaction(I2C_TX, I2C_USE_FIFO);
+    LaunchSecondTransaction(I2C_OK);
+
+    MOCK_HAL_I2C.Status   = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+    MOCK_HAL_I2C_2.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+    ExpectTransactionComplete(I2C_OK);
+    ExpectSecondTransactionComplete(I2C_OK);
+    ExternalInterrupts_I2cIrqHandler();
+}
+
+#if I2C_FEATURE_DMA
+TEST(I2C_MultiInstance, DmaChannelIsSharedBetweenDevices)
+{
+    LaunchTransaction(I2C_TX, I2C_USE_DMA);
+
+    second_transaction.data_path = I2C_USE_DMA;
+    LaunchSecondTransaction(I2C_DMAC_CHANNEL_BUSY);
+
+    // Completion on the first controller releases the DMA channel
+    MOCK_HAL_I2C.Status = I2C_STATUS_CMPL_MASK | I2C_STATUS_ADDRHIT_MASK;
+    ExpectTransactionComplete(I2C_OK);
+    LONGS_EQUAL(I2C_OK, I2C_DeviceIrqHandler((I2CRegisters*) &MOCK_HAL_I2C));
+
+    // Half of the 4 bytes FIFO of the second controller
+    expected_dmac_channel_config[I2C_RX].src_burst_size = DMAC_BURST_SIZE_2;
+    expected_dmac_transfer_config[I2C_RX].transfer_size = sizeof(second_data_buffer);
+    expected_dmac_transfer_config[I2C_RX].src_address   = (uint32_t) &(MOCK_HAL_I2C_2.Data);
+    expected_dmac_transfer_config[I2C_RX].dst_address   = (uint32_t) second_data_buffer;
+    ExpectDMACChannelSetup(I2C_RX);
+    ExpectDMACTransferSetup(I2C_RX);
+    ExpectDMACChannelEnabled();
+    LaunchSecondTransaction(I2C_OK);
+
+    // DMA errors are reported to the device owning the channel
+    ExpectExternalInterruptDisabled();
+    ExpectSecondTransactionComplete(I2C_DMAC_ERROR);
+    ExpectExternalInterruptEnabled();
+    I2C_DMACCallback(DMAC_ERROR);
+}
+
+TEST(I2C_MultiInstance, AutoDataPathUsesFifoWhileDmaChannelIsBusy)
+{
+    LaunchTransaction(I2C_TX, I2C_USE_DMA);
+
+    second_transaction.data_path  = I2C_USE_AUTO;
+    second_transaction.data       = large_data_buffer;
+    second_transaction.data_count = sizeof(large_data_buffer);
+    LaunchSecondTransaction(I2C_OK);
+    CHECK_EQUAL(0, (MOCK_HAL_I2C_2.Setup & I2C_SETUP_DMAEN_MASK) >> I2C_SETUP_DMAEN_OFFSET);
+    CHECK((MOCK_HAL_I2C_2.IntEn & I2C_INTEN_FIFOFULL_MASK) >> I2C_INTEN_FIFOFULL_OFFSET);
+}
+#endif
+
+TEST(I2C_MultiInstance, SharedInterruptStaysEnabledWhileAnotherDeviceIsEnabled)
+{
+    LONGS_EQUAL(I2C_OK, I2C_ShutdownController((I2CRegisters*) &MOCK_HAL_I2C_2));
+    CHECK_FALSE((MOCK_HAL_I2C_2.Setup & I2C_SETUP_IICEN_MASK) >> I2C_SETUP_IICEN_OFFSET);
+
+    ExpectExternalInterruptDisabled();
+    LONGS_EQUAL(I2C_OK, I2C_ShutdownController((I2CRegisters*) &MOCK_HAL_I2C));
+}
+
+TEST(I2C_MultiInstance, ExpiryAfterShutdownKeepsTheInterruptOfAnotherDevice)
+{
+    default_transaction.timeout = 1;
+    LaunchDefaultTransaction();
+    LONGS_EQUAL(I2C_OK, I2C_ShutdownController((I2CRegisters*) &MOCK_HAL_I2C));
+
+    // The second controller still uses the shared line
+    ExpectExternalInterruptDisabled();
+    ExpectTransactionComplete(I2C_TRANSACTION_TIMEOUT);
+    ExpectExternalInterruptEnabled();
+    I2C_TimeoutTick();
+}
+#endif
@@ -15,6 +15,7 @@
 
 #include "CommonDefs.h"
 #include "DMAC.h"
+#include "I2CConfig.h"
 
 #define HAL_I2C_BASE 0xF0A00000
 #define HAL_I2C      ((I2CRegisters*) HAL_I2C_BASE)
@@ -92,6 +93,12 @@
 #define I2C_ADDR_MAX_7BIT  0x7fu
 #define I2C_ADDR_MAX_10BIT 0x3ffu
 
+#define I2C_CRC8_SMBUS_POLYNOMIAL 0x07u // x^8 + x^2 + x + 1, SMBus PEC
+
+#define I2C_SCAN_MAP_SIZE ((I2C_ADDR_MAX_7BIT + 1) / 8) // Bytes of I2CScanDescriptor.presence
+#define I2C_SCAN_PRESENT(presence, address) \
+    ((((presence)[(address) / 8] >> ((address) % 8)) & 1u) != 0)
+
 #define I2C_DATA_DATA_MASK   0x000000ff
 #define I2C_DATA_DATA_OFFSET 0
 
@@ -105,6 +112,7 @@
 #define I2C_CTRL_PHASE_STOP_OFFSET  9
 #define I2C_CTRL_DIR_MASK           0x00000100
 #define I2C_CTRL_DIR_OFFSET         8
+#define I2C_CTRL_DIR_SLAVE_TX       0x1u // Slave: set by the controller when the master reads
 #define I2C_CTRL_DATACNT_MASK       0x000000ff
 #define I2C_CTRL_DATACNT_OFFSET     0
 
@@ -142,6 +150,133 @@
 #define I2C_TPM_TPM_MASK   0x0000001f
 #define I2C_TPM_TPM_OFFSET 0
 
+//
+// SCL timing for any SCL frequency and APB clock (both in Hz), see I2C_ComputeTiming.
+// I2C_TIMING() gives the same result for compile-time constants, e.g.
+// static const I2CTiming timing = I2C_TIMING(250000, 50000000);
+// The SCL frequency selects the bus class (Standard-mode, Fast-mode, Fast-mode Plus) whose
+// minimum SCL high/low, data setup and data hold times are met. The achieved SCL frequency is
+// never above the requested one, SCL rise and fall times are not included.
+//
+#define I2C_STANDARD_MODE_MAX_FREQUENCY  100000u
+#define I2C_FAST_MODE_MAX_FREQUENCY      400000u
+#define I2C_FAST_MODE_PLUS_MAX_FREQUENCY 1000000u
+
+#define I2C_SPEC(scl, std, fm, fm_plus) \
+    (((scl) <= I2C_STANDARD_MODE_MAX_FREQUENCY) ? (std) : \
+     ((scl) <= I2C_FAST_MODE_MAX_FREQUENCY) ? (fm) : (fm_plus))
+
+// Bus timing limits in ns
+#define I2C_SPEC_MIN_SCLHI(scl) I2C_SPEC(scl, 4000u, 600u, 260u)
+#define I2C_SPEC_MIN_SCLLO(scl) I2C_SPEC(scl, 4700u, 1300u, 500u)
+#define I2C_SPEC_MIN_SUDAT(scl) I2C_SPEC(scl, 250u, 100u, 50u)
+#define I2C_SPEC_MIN_HDDAT(scl) I2C_SPEC(scl, 300u, 300u, 0u)
+#define I2C_SPEC_MAX_SP         50u
+
+#define I2C_TIMING_TPM_MAX   (I2C_TPM_TPM_MASK >> I2C_TPM_TPM_OFFSET)
+#define I2C_TIMING_SP_MAX    (I2C_SETUP_T_SP_MASK >> I2C_SETUP_T_SP_OFFSET)
+#define I2C_TIMING_SUDAT_MAX (I2C_SETUP_T_SUDAT_MASK >> I2C_SETUP_T_SUDAT_OFFSET)
+#define I2C_TIMING_HDDAT_MAX (I2C_SETUP_T_HDDAT_MASK >> I2C_SETUP_T_HDDAT_OFFSET)
+#define I2C_TIMING_SCLHI_MAX (I2C_SETUP_T_SCLHI_MASK >> I2C_SETUP_T_SCLHI_OFFSET)
+
+#define I2C_TIMING_CEIL_DIV(a, b)  (((a) + (b) - 1) / (b))
+#define I2C_TIMING_MAX(a, b)       (((a) > (b)) ? (a) : (b))
+#define I2C_TIMING_MIN(a, b)       (((a) < (b)) ? (a) : (b))
+#define I2C_TIMING_CYCLES(ns, apb) \
+    ((uint32_t) I2C_TIMING_CEIL_DIV((uint64_t) (ns) * (apb), 1000000000ull))
+
+// Smallest field value with 2 + (2 + sp + field) * (tpm + 1) APB cycles covering cycles
+#define I2C_TIMING_FIELD(cycles, tpm, sp) \
+    (((cycles) > (2 + ((2 + (sp)) * ((tpm) + 1)))) ? \
+     (I2C_TIMING_CEIL_DIV((cycles) - 2, (tpm) + 1) - 2 - (sp)) : 0)
+
+// SCL period in APB cycles: SCL high plus SCL low time
+#define I2C_TIMING_SCL_PERIOD(tpm, sp, sclhi, ratio) \
+    (4 + ((4 + (2 * (sp)) + ((sclhi) * (2 + (ratio)))) * ((tpm) + 1)))
+
+// Smallest T_SCLHI whose SCL period covers period APB cycles
+#define I2C_TIMING_SCLHI_FOR_PERIOD(period, tpm, sp, ratio) \
+    (((period) > (4 + ((4 + (2 * (sp))) * ((tpm) + 1)))) ? \
+     I2C_TIMING_CEIL_DIV(I2C_TIMING_CEIL_DIV((period) - 4, (tpm) + 1) - 4 - (2 * (sp)), \
+                         2 + (ratio)) : 0)
+
+// Smallest T_SCLHI meeting the SCL period and the minimum SCL high and low times
+#define I2C_TIMING_SCLHI_FOR_LIMITS(scl, apb, period, tpm, sp, ratio) \
+    I2C_TIMING_MAX(I2C_TIMING_SCLHI_FOR_PERIOD(period, tpm, sp, ratio), \
+                   I2C_TIMING_MAX(I2C_TIMING_FIELD(I2C_TIMING_CYCLES(I2C_SPEC_MIN_SCLHI(scl), \
+                                                                     apb), tpm, sp), \
+                                  I2C_TIMING_CEIL_DIV( \
+                                      I2C_TIMING_FIELD(I2C_TIMING_CYCLES( \
+                                                           I2C_SPEC_MIN_SCLLO(scl), apb), \
+                                                       tpm, sp), \
+                                      1 + (ratio))))
+
+// Smallest multiplier fitting a field covering cycles APB cycles in field_max
+#define I2C_TIMING_TPM_FOR_FIELD(cycles, field_max) \
+    (((cycles) > ((field_max) + 4)) ? (I2C_TIMING_CEIL_DIV((cycles) - 2, (field_max) + 2) - 1) : 0)
+
+// Smallest multiplier fitting T_SCLHI, T_SUDAT and T_HDDAT
+#define I2C_TIMING_TPM_FOR_LIMITS(scl, apb, period, ratio) \
+    I2C_TIMING_MAX(((period) > 4) ? \
+                   (I2C_TIMING_CEIL_DIV((period) - 4, \
+                                        4 + (I2C_TIMING_SCLHI_MAX * (2 + (ratio)))) - 1) : 0, \
+                   I2C_TIMING_MAX(I2C_TIMING_TPM_FOR_FIELD( \
+                                      I2C_TIMING_CYCLES(I2C_SPEC_MIN_SUDAT(scl), apb), \
+                                      I2C_TIMING_SUDAT_MAX), \
+                                  I2C_TIMING_TPM_FOR_FIELD( \
+                                      I2C_TIMING_CYCLES(I2C_SPEC_MIN_HDDAT(scl), apb), \
+                                      I2C_TIMING_HDDAT_MAX)))
+
+// Intermediate values: requested SCL period, SCL low twice the high time above Standard-mode,
+// widest spike filter under the limit
+#define I2C_TIMING_PERIOD(scl, apb) \
+    ((uint32_t) I2C_TIMING_CEIL_DIV((uint64_t) (apb), (scl)))
+#define I2C_TIMING_RATIO(scl) (((scl) > I2C_STANDARD_MODE_MAX_FREQUENCY) ? 1u : 0u)
+#define I2C_TIMING_SP_FOR_TPM(apb, tpm) \
+    I2C_TIMING_MIN(I2C_TIMING_SP_MAX, \
+                   ((uint32_t) (((uint64_t) I2C_SPEC_MAX_SP * (apb)) / 1000000000ull)) / ((tpm) + 1))
+
+#define I2C_TIMING_TPM(scl, apb) \
+    I2C_TIMING_TPM_FOR_LIMITS(scl, apb, I2C_TIMING_PERIOD(scl, apb), I2C_TIMING_RATIO(scl))
+#define I2C_TIMING_SP(scl, apb) \
+    I2C_TIMING_SP_FOR_TPM(apb, I2C_TIMING_TPM(scl, apb))
+#define I2C_TIMING_SUDAT(scl, apb) \
+    I2C_TIMING_FIELD(I2C_TIMING_CYCLES(I2C_SPEC_MIN_SUDAT(scl), apb), \
+                     I2C_TIMING_TPM(scl, apb), I2C_TIMING_SP(scl, apb))
+#define I2C_TIMING_HDDAT(scl, apb) \
+    I2C_TIMING_FIELD(I2C_TIMING_CYCLES(I2C_SPEC_MIN_HDDAT(scl), apb), \
+                     I2C_TIMING_TPM(scl, apb), I2C_TIMING_SP(scl, apb))
+#define I2C_TIMING_SCLHI(scl, apb) \
+    I2C_TIMING_SCLHI_FOR_LIMITS(scl, apb, I2C_TIMING_PERIOD(scl, apb), \
+                                I2C_TIMING_TPM(scl, apb), \
+                                I2C_TIMING_SP(scl, apb), \
+                                I2C_TIMING_RATIO(scl))
+#define I2C_TIMING_FREQUENCY(scl, apb) \
+    ((uint32_t) ((apb) / I2C_TIMING_SCL_PERIOD(I2C_TIMING_TPM(scl, apb), \
+                                               I2C_TIMING_SP(scl, apb), \
+                                               I2C_TIMING_SCLHI(scl, apb), \
+                                               I2C_TIMING_RATIO(scl))))
+
+// The macros do not check the field ranges, I2C_TIMING_VALID() does (e.g. in a static assert)
+#define I2C_TIMING_VALID(scl, apb) \
+    (((scl) != 0) && ((scl) <= I2C_FAST_MODE_PLUS_MAX_FREQUENCY) && \
+     ((apb) >= (scl)) && \
+     (I2C_TIMING_TPM(scl, apb) <= I2C_TIMING_TPM_MAX) && \
+     (I2C_TIMING_SUDAT(scl, apb) <= I2C_TIMING_SUDAT_MAX) && \
+     (I2C_TIMING_HDDAT(scl, apb) <= I2C_TIMING_HDDAT_MAX) && \
+     (I2C_TIMING_SCLHI(scl, apb) <= I2C_TIMING_SCLHI_MAX))
+
+#define I2C_TIMING(scl, apb) \
+    { \
+        I2C_TIMING_TPM(scl, apb), \
+        I2C_TIMING_SP(scl, apb), \
+        I2C_TIMING_SUDAT(scl, apb), \
+        I2C_TIMING_HDDAT(scl, apb), \
+        I2C_TIMING_SCLHI(scl, apb), \
+        I2C_TIMING_RATIO(scl), \
+        I2C_TIMING_FREQUENCY(scl, apb) \
+    }
+
 typedef struct {
     __I uint32_t  IdRev;
     __I uint32_t  Reserved0[3];
@@ -167,6 +302,19 @@ typedef struct {
     uint8_t          fifo_size;
 } I2CConfig;
 
+typedef struct {
+    uint32_t fifo_transactions;  // Transactions with data moved by the CPU
+    uint32_t dma_transactions;   // Transactions with data moved by the DMA
+    uint32_t dma_setup_cycles;   // Measured by I2C_Calibrate, 0 until then
+    uint32_t fifo_byte_cycles;   // Measured by I2C_Calibrate, 0 until then
+    uint32_t mmio_reads;         // Controller register reads, 0 without I2C_COUNT_MMIO_ACCESSES
+    uint32_t mmio_writes;        // Controller register writes, 0 without I2C_COUNT_MMIO_ACCESSES
+    uint16_t auto_dma_threshold; // I2C_USE_AUTO data count from which DMA is used
+    uint32_t arbitration_losses; // Descriptors reissued after lost arbitration
+    uint32_t bus_recoveries;     // I2C_RecoverBus calls that found SDA or SCL held low
+    uint32_t recovery_cycles;    // Duration of the last I2C_RecoverBus, 0 without I2C_GetCycleCount
+} I2CStats;
+
 typedef enum {
     I2C_OK,
     I2C_INVALID_INPUT_DATA,
@@ -174,6 +322,18 @@ typedef enum {
     I2C_CMD_PENDING,
     I2C_ADDR_HIT_ERROR,
     I2C_DMAC_ERROR,
+    I2C_DEVICE_NOT_REGISTERED,
+    I2C_NO_DEVICE_CONTEXT_AVAILABLE,
+    I2C_DMAC_CHANNEL_BUSY,
+    I2C_QUEUE_FULL,
+    I2C_CYCLE_COUNTER_NOT_AVAILABLE,
+    I2C_POLL_TIMEOUT,
+    I2C_TIMING_OUT_OF_RANGE,
+    I2C_WRONG_ROLE,
+    I2C_ARBITRATION_LOST,
+    I2C_BUS_HANG,
+    I2C_CRC_ERROR,
+    I2C_TRANSACTION_TIMEOUT,
     I2C_NB_OF_RETURN_CODES
 } I2CReturnCode;
 
@@ -205,41 +365,218 @@ typedef enum {
 
 typedef void (* I2CCallback)(I2CReturnCode);
 
+// Completion with the descriptor context, the bytes moved between memory and the controller
+// and I2C_GetCycleCount at completion (0 without it)
+typedef void (* I2CContextCallback)(void*         context,
+                                    I2CReturnCode status,
+                                    uint32_t      data_count,
+                                    uint32_t      timestamp);
+
+// Controller timing fields, see I2C_ComputeTiming and I2C_TIMING
+typedef struct {
+    uint8_t  tpm;
+    uint8_t  t_sp;
+    uint8_t  t_sudat;
+    uint8_t  t_hddat;
+    uint16_t t_sclhi;
+    uint8_t  t_sclratio;
+    uint32_t scl_frequency; // Achieved SCL frequency in Hz
+} I2CTiming;
+
 typedef struct {
-    I2CRole role;
-    I2CMode mode;
+    I2CRole          role;
+    I2CMode          mode;
+    const I2CTiming* timing; // Used instead of the mode timing when not NULL
 } I2CSetupInfo;
 
 typedef uint8_t I2CDataPath;
 typedef enum {
     I2C_USE_FIFO,
-    I2C_USE_DMA
+    I2C_USE_DMA,
+    I2C_USE_AUTO // FIFO or DMA depending on the data count, see I2C_Calibrate
 } _I2CDataPath;
 
+typedef uint8_t I2CDMAPriority;
+typedef enum {
+    I2C_DMA_PRIORITY_DEFAULT, // High
+    I2C_DMA_PRIORITY_LOW,
+    I2C_DMA_PRIORITY_HIGH,
+    I2C_DMA_PRIORITY_UNSUPPORTED
+} _I2CDMAPriority;
+
+typedef uint8_t I2CDMABurstSize;
+typedef enum {
+    I2C_DMA_BURST_SIZE_AUTO, // Half the controller FIFO
+    I2C_DMA_BURST_SIZE_1,
+    I2C_DMA_BURST_SIZE_2,
+    I2C_DMA_BURST_SIZE_4,
+    I2C_DMA_BURST_SIZE_8,
+    I2C_DMA_BURST_SIZE_16,
+    I2C_DMA_BURST_SIZE_UNSUPPORTED
+} _I2CDMABurstSize;
+
+typedef uint8_t I2CTransactionType;
+typedef enum {
+    I2C_SIMPLE_TRANSACTION,     // START, ADDR, DATA (direction), STOP
+    I2C_WRITE_READ_TRANSACTION, // START, ADDR, DATA (TX), repeated START, ADDR, DATA (RX), STOP
+    I2C_UNSUPPORTED_TRANSACTION
+} _I2CTransactionType;
+
+typedef uint8_t I2CCrcMode;
+typedef enum {
+    I2C_CRC_NONE,
+    I2C_CRC_DATA, // CRC-8 of the data bytes, only the read ones for a write-read
+    I2C_CRC_PEC,  // SMBus PEC: CRC-8 of the address bytes (7-bit only) and data bytes
+    I2C_CRC_UNSUPPORTED
+} _I2CCrcMode;
+
 typedef struct {
-    I2CDirection      direction;
-    I2CAddressingMode addressing_mode;
-    uint16_t          address;
-    I2CDataPath       data_path;
-    uint8_t*          data;
-    uint16_t          data_count;
-    I2CCallback       callback;
+    uint8_t* data;
+    uint16_t data_count;
+} I2CSegment;
+
+typedef struct {
+    I2CTransactionType type;
+    I2CDirection       direction;
+    I2CAddressingMode  addressing_mode;
+    uint16_t           address;
+    I2CDataPath        data_path;
+    uint8_t*           data;
+    uint16_t           data_count;
+    I2CSegment*        segments;       // TX only: buffers sent back to back, data must be NULL
+    uint8_t            segment_count;
+    uint8_t*           rx_data;        // I2C_WRITE_READ_TRANSACTION only
+    uint16_t           rx_data_count;  // I2C_WRITE_READ_TRANSACTION only
+    I2CCallback        callback;
+    I2CContextCallback context_callback; // Called instead of callback when set
+    void*              context;
+    I2CReturnCode      status;         // Set by the HAL when the transaction completes
+    I2CDMAPriority     dma_priority;   // I2C_USE_DMA only
+    I2CDMABurstSize    dma_burst_size; // I2C_USE_DMA only, limited to the FIFO size and data phase
+    I2CCrcMode         crc;            // TX: CRC byte sent after the data, RX: last byte checked
+    uint8_t            crc_polynomial; // Without the x^8 term, e.g. I2C_CRC8_SMBUS_POLYNOMIAL
+    uint32_t           timeout;        // I2C_TimeoutTick calls before the abort, 0 for none
 } I2CTransactionDescriptor;
 
+// Validated descriptor with the register images of its first phase, see I2C_PrepareTransaction
+typedef struct {
+    I2CRegisters*             i2c_dev;
+    I2CTransactionDescriptor* descriptor;       // Prepare again after changing it
+    uint32_t                  addr;             // Addr register image
+    uint32_t                  addressing;       // Setup addressing field
+    uint32_t                  phases;           // Ctrl phases of the first data phase
+    uint32_t                  ctrl;             // Ctrl register image
+    uint16_t                  phase_data_count; // Data bytes of the first data phase
+    I2CDataPath               data_path;        // I2C_USE_AUTO resolved until I2C_Calibrate
+} I2CPreparedTransaction;
+
+typedef uint8_t I2CSlaveMode;
+typedef enum {
+    I2C_SLAVE_BUFFERS,       // Writes fill rx_data, reads drain tx_data, from the start each time
+    I2C_SLAVE_REGISTER_FILE, // rx_data is a register file: the first byte written sets the pointer
+    I2C_SLAVE_UNSUPPORTED_MODE
+} _I2CSlaveMode;
+
+typedef uint8_t I2CSlaveEvent;
+typedef enum {
+    I2C_SLAVE_RX_DONE,      // The master wrote data_count bytes
+    I2C_SLAVE_RX_OVERFLOW,  // The master wrote past rx_data_count, data_count bytes were kept
+    I2C_SLAVE_TX_DONE,      // The master read data_count bytes
+    I2C_SLAVE_TX_UNDERFLOW, // The master read data_count bytes, 0xff sent after tx_data_count
+    I2C_SLAVE_GENERAL_CALL  // The master wrote data_count bytes to the general call address
+} _I2CSlaveEvent;
+
+typedef void (* I2CSlaveCallback)(I2CSlaveEvent event, uint16_t data_count);
+
+typedef struct {
+    I2CSlaveMode      mode;
+    I2CAddressingMode addressing_mode;
+    uint16_t          address;       // Address the controller answers to
+    uint8_t*          rx_data;       // Filled from the FIFO by the IRQ handler, no copy
+    uint16_t          rx_data_count;
+    uint8_t*          tx_data;       // I2C_SLAVE_BUFFERS only
+    uint16_t          tx_data_count; // I2C_SLAVE_BUFFERS only
+    I2CSlaveCallback  callback;      // Called from the IRQ handler at the end of each transfer
+} I2CSlaveDescriptor;
+
+// Address-only write to each 7-bit address of the range, chained from the IRQ handler
+typedef struct {
+    uint8_t            first_address;
+    uint8_t            last_address;
+    uint8_t            presence[I2C_SCAN_MAP_SIZE]; // Addresses that answered, see I2C_SCAN_PRESENT
+    uint8_t            found;            // Number of addresses that answered
+    uint32_t           probe_timeout;    // I2C_TimeoutTick calls per address, 0 for none
+    I2CContextCallback context_callback; // Called once the range is probed, data_count is found
+    void*              context;
+    I2CReturnCode      status;           // Set by the HAL when the scan completes
+} I2CScanDescriptor;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 I2CReturnCode I2C_Create(I2CRegisters* i2c_dev);
+I2CReturnCode I2C_Destroy(I2CRegisters* i2c_dev);
 I2CReturnCode I2C_GetConfig(I2CRegisters* i2c_dev,
                             I2CConfig**   return_value);
+I2CReturnCode I2C_GetStats(I2CRegisters* i2c_dev,
+                           I2CStats**    return_value);
+#if I2C_FEATURE_DMA
+I2CReturnCode I2C_Calibrate(I2CRegisters* i2c_dev);
+#endif
+I2CReturnCode I2C_ComputeTiming(uint32_t   scl_frequency,
+                                uint32_t   apb_clock,
+                                I2CTiming* timing);
 I2CReturnCode I2C_SetupController(I2CRegisters* i2c_dev,
                                   I2CSetupInfo* setup_info);
 I2CReturnCode I2C_ShutdownController(I2CRegisters* i2c_dev);
 I2CReturnCode I2C_LaunchTransaction(I2CRegisters*             i2c_dev,
                                     I2CTransactionDescriptor* descriptor);
+I2CReturnCode I2C_PrepareTransaction(I2CRegisters*             i2c_dev,
+                                     I2CTransactionDescriptor* descriptor,
+                                     I2CPreparedTransaction*   prepared);
+I2CReturnCode I2C_LaunchPreparedTransaction(const I2CPreparedTransaction* prepared);
+I2CReturnCode I2C_QueueTransaction(I2CRegisters*             i2c_dev,
+                                   I2CTransactionDescriptor* descriptor);
+I2CReturnCode I2C_PollTransaction(I2CRegisters*             i2c_dev,
+                                  I2CTransactionDescriptor* descriptor,
+                                  uint32_t                  poll_budget);
+#if I2C_FEATURE_SLAVE
+I2CReturnCode I2C_StartSlave(I2CRegisters*       i2c_dev,
+                             I2CSlaveDescriptor* descriptor);
+I2CReturnCode I2C_StopSlave(I2CRegisters* i2c_dev);
+#endif
+I2CReturnCode I2C_RecoverBus(I2CRegisters* i2c_dev);
+I2CReturnCode I2C_ScanBus(I2CRegisters*      i2c_dev,
+                          I2CScanDescriptor* descriptor);
 I2CReturnCode I2C_DeviceIrqHandler(I2CRegisters* i2c_dev);
+I2CReturnCode I2C_ProcessDeferredIrq(I2CRegisters* i2c_dev);
+#if I2C_FEATURE_DMA
 void I2C_DMACCallback(DMACReturnCode return_code);
+#endif
+
+// Free-running CPU cycle counter used by I2C_Calibrate, provided by the platform
+extern uint32_t (* I2C_GetCycleCount)(void);
+
+// One SCL pulse with the pins muxed as GPIO, then back to the controller, provided by the board
+extern void (* I2C_PulseSCL)(I2CRegisters* i2c_dev);
+
+// Called between the Cmd reads of I2C_CMD_IDLE_POLLS, e.g. a short delay provided by the board.
+// Cmd is read back to back when NULL.
+extern void (* I2C_WaitCmd)(I2CRegisters* i2c_dev);
+
+// Called periodically by the platform (e.g. from vApplicationTickHook) to age the descriptor
+// timeouts: an expired transaction is aborted with a controller reset, completed with
+// I2C_TRANSACTION_TIMEOUT and the next queued descriptor is issued. The first tick can follow the
+// launch immediately, a timeout of n ticks lasts at least n - 1 tick periods. Also reissues the
+// descriptors after their arbitration backoff, doubled at each retry: without it, an
+// interrupt-driven descriptor losing arbitration is never retried unless
+// I2C_ARBITRATION_BACKOFF_TICKS is 0. Polled transactions are left to I2C_PollTransaction.
+void I2C_TimeoutTick(void);
+
+// When set, I2C_DeviceIrqHandler only acks and masks the controller events and calls it to
+// schedule I2C_ProcessDeferredIrq outside the interrupt (e.g. xTimerPendFunctionCallFromISR)
+extern void (* I2C_DeferIrq)(I2CRegisters* i2c_dev);
 
 #ifdef __cplusplus
 }
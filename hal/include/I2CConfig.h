@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) THEDEVHUTS, 2020.
+ * All rights reserved. Permission to use, copy, modify, distribute in any
+ * form or by any means or store in any database or retrieval system any
+ * parts of this copyrighted work is forbidden.
+ * Contact THEDEVHUTS (contact@thedevhuts.com) for licensing agreement
+ * opportunities.
+ *
+ * Contributor: Julien Gros
+ *
+ */
+
+#ifndef __I2C_CONFIG_H
+#define __I2C_CONFIG_H
+
+// Build configuration of the I2C HAL, each value can be overridden on the command line
+
+#define I2C_VALIDATION_BASIC 0 // NULL pointers and unregistered controllers only
+#define I2C_VALIDATION_FULL  1 // Every descriptor field
+
+// Single master, 7-bit targets moved through the FIFO in Standard-mode, e.g. one Si7021
+#ifdef I2C_PROFILE_SENSOR_NODE
+#ifndef I2C_MAX_DEVICES
+#define I2C_MAX_DEVICES 1
+#endif
+#ifndef I2C_FEATURE_DMA
+#define I2C_FEATURE_DMA 0
+#endif
+#ifndef I2C_FEATURE_10_BIT_ADDRESSING
+#define I2C_FEATURE_10_BIT_ADDRESSING 0
+#endif
+#ifndef I2C_FEATURE_SLAVE
+#define I2C_FEATURE_SLAVE 0
+#endif
+#ifndef I2C_FEATURE_FAST_MODES
+#define I2C_FEATURE_FAST_MODES 0
+#endif
+#ifndef I2C_VALIDATION_LEVEL
+#define I2C_VALIDATION_LEVEL I2C_VALIDATION_BASIC
+#endif
+#endif
+
+#ifndef I2C_MAX_DEVICES
+#define I2C_MAX_DEVICES 4 // Number of controllers that can be registered with I2C_Create
+#endif
+
+#ifndef I2C_AUTO_DMA_THRESHOLD
+#define I2C_AUTO_DMA_THRESHOLD 16 // I2C_USE_AUTO data count from which DMA is used until calibrated
+#endif
+
+#ifndef I2C_TRANSACTION_QUEUE_DEPTH
+#define I2C_TRANSACTION_QUEUE_DEPTH 8 // Descriptors waiting per controller (I2C_QueueTransaction)
+#endif
+
+#ifndef I2C_COUNT_MMIO_ACCESSES
+#define I2C_COUNT_MMIO_ACCESSES 0 // Count the controller register accesses in I2CStats, 1 for tests
+#endif
+
+#ifndef I2C_ARBITRATION_RETRIES
+#define I2C_ARBITRATION_RETRIES 3 // Reissues of a descriptor after lost arbitration
+#endif
+
+// Above 0, the retries of the interrupt-driven transactions need I2C_TimeoutTick to be called
+#ifndef I2C_ARBITRATION_BACKOFF_TICKS
+#define I2C_ARBITRATION_BACKOFF_TICKS 1 // I2C_TimeoutTick calls before the first retry, 0: at once
+#endif
+
+#ifndef I2C_BUS_RECOVERY_PULSES
+#define I2C_BUS_RECOVERY_PULSES 9 // SCL pulses to clock out a slave holding SDA low
+#endif
+
+#ifndef I2C_CMD_IDLE_POLLS
+#define I2C_CMD_IDLE_POLLS 32 // Cmd reads waiting for a controller reset or FIFO clear to finish
+#endif
+
+// Features compiled in. With I2C_VALIDATION_FULL, descriptors using a disabled one are invalid
+#ifndef I2C_FEATURE_DMA
+#define I2C_FEATURE_DMA 1 // I2C_USE_DMA, I2C_USE_AUTO above the threshold and I2C_Calibrate
+#endif
+
+#ifndef I2C_FEATURE_10_BIT_ADDRESSING
+#define I2C_FEATURE_10_BIT_ADDRESSING 1
+#endif
+
+#ifndef I2C_FEATURE_SLAVE
+#define I2C_FEATURE_SLAVE 1 // I2C_SLAVE role, I2C_StartSlave and I2C_StopSlave
+#endif
+
+#ifndef I2C_FEATURE_FAST_MODES
+#define I2C_FEATURE_FAST_MODES 1 // I2C_FAST_MODE and I2C_FAST_MODE_PLUS timing tables
+#endif
+
+#ifndef I2C_VALIDATION_LEVEL
+#define I2C_VALIDATION_LEVEL I2C_VALIDATION_FULL
+#endif
+
+#endif // __I2C_CONFIG_H
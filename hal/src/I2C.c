@@ -17,6 +17,12 @@
 #define I2C_CLK                50 // APB clock in MHz
 #define I2C_INTERRUPT_PRIORITY 1
 
+#define I2C_MAX_DATA_PHASE_LENGTH (I2C_CTRL_DATACNT_MASK + 1) // Data bytes per Ctrl data phase
+
+#if I2C_FEATURE_SLAVE
+#define I2C_SLAVE_TX_PADDING 0xffu // Sent when the master reads past the slave tx_data
+#endif
+
 #define I2C_TPM 0 // Timing Parameter Multiplier
 #define T_SP    2 // Spike Suppression Width
 
@@ -40,6 +46,7 @@
 #define T_SCLRATIO_FM      1u
 #define T_SCLRATIO_FM_PLUS 1u
 
+#if I2C_FEATURE_FAST_MODES
 #define T_SUDAT(mode) \
     (((mode) == I2C_STANDARD_MODE) ? T_SUDAT_STD : \
      ((mode) == I2C_FAST_MODE) ? T_SUDAT_FM : T_SUDAT_FM_PLUS)
@@ -55,6 +62,13 @@
 #define T_SCLRATIO(mode) \
     (((mode) == I2C_STANDARD_MODE) ? T_SCLRATIO_STD : \
      ((mode) == I2C_FAST_MODE) ? T_SCLRATIO_FM : T_SCLRATIO_FM_PLUS)
+#else
+// I2C_SetupController only accepts I2C_STANDARD_MODE
+#define T_SUDAT(mode)    T_SUDAT_STD
+#define T_HDDAT(mode)    T_HDDAT_STD
+#define T_SCLHI(mode)    T_SCLHI_STD
+#define T_SCLRATIO(mode) T_SCLRATIO_STD
+#endif
 
 typedef struct {
     I2CRole           role;
@@ -63,66 +77,379 @@ typedef struct {
     I2CAddressingMode addr_mode;
     uint16_t          addr;   // Target Address if Master, Controller Address if Slave
     I2CDataPath       data_path;
+    I2CDMAPriority    dma_priority;
+    I2CDMABurstSize   dma_burst_size;
     uint8_t*          data;
-    uint16_t          remaining_data;
+    uint16_t          remaining_data; // Bytes left in the data phase on the bus
+    uint16_t          pending_data;   // Bytes left after the data phase on the bus
+    uint16_t          segment_data;   // Bytes left at data before the next segment
+    I2CSegment*       segment;        // Next segment of a scatter-gather descriptor
+    uint8_t           segments_left;
+    uint16_t          dma_data;       // Bytes of the DMA transfer in progress
+    uint8_t*          rx_data;        // Read phase pending after a repeated START
+    uint16_t          rx_data_count;
+    uint32_t          phases;         // Ctrl phases of the transfer on the bus
+    I2CReturnCode     status;
     I2CCallback       callback;
+    I2CContextCallback context_callback;
+    void*             context;
+    uint32_t          transferred;    // Bytes moved between memory and the controller
+    I2CCrcMode        crc_mode;
+    uint8_t           crc_polynomial;
+    uint8_t           crc;            // CRC-8 of the bytes moved so far
+    bool              crc_trailer;    // The CRC byte follows the last segment of the write
+    uint8_t           tx_crc;         // CRC byte sent after the data of a write
+    bool              polled;         // Completed by I2C_PollTransaction, interrupts left disabled
+    uint32_t          ticks_left;     // I2C_TimeoutTick calls before the abort, 0 without deadline
+    uint8_t           arbitration_retries;
+    uint32_t          backoff_ticks;  // I2C_TimeoutTick calls before the reissue, lost arbitration
+    I2CTransactionDescriptor* descriptor;
 } I2CTransaction;
 
-static I2CConfig i2c_config;
-static volatile I2CTransaction current_transaction;
+#if I2C_FEATURE_SLAVE
+typedef struct {
+    I2CSlaveDescriptor* descriptor;       // NULL when the controller is not a started slave
+    bool                in_transfer;      // Addressed, until the STOP or repeated START
+    bool                general_call;
+    bool                pointer_received; // Register file: first byte of the write received
+    I2CDirection        dir;              // Controller side of the transfer
+    uint16_t            count;            // Bytes moved through the FIFO in the transfer
+    uint16_t            stored;           // Bytes written to memory in the transfer
+    uint16_t            offset;           // Register file pointer
+} I2CSlaveState;
+#endif
+
+typedef struct {
+    I2CTransactionDescriptor* descriptors[I2C_TRANSACTION_QUEUE_DEPTH];
+    uint8_t                   head;
+    uint8_t                   count;
+} I2CTransactionQueue;
+
+typedef struct {
+    I2CScanDescriptor*       descriptor; // NULL when no scan is in progress
+    I2CTransactionDescriptor probe;      // Address-only write reissued for each address
+} I2CScanState;
+
+// Last values written to the registers only the HAL modifies
+typedef struct {
+    uint32_t IntEn;
+    uint32_t Addr;
+    uint32_t Setup;
+    uint32_t TPM;
+} I2CShadowRegisters;
 
-static void ReadHWConfig(I2CRegisters* i2c_dev);
-static bool I2CCmdPending(I2CRegisters* i2c_dev);
-static void I2CEnable(I2CRegisters* i2c_dev);
-static void I2CDisable(I2CRegisters* i2c_dev);
-static bool I2CEnabled(I2CRegisters* i2c_dev);
+typedef struct {
+    I2CRegisters*           i2c_dev;  // NULL when the context is free
+    I2CConfig               config;
+    I2CShadowRegisters      shadow;
+    volatile I2CTransaction transaction;
+    volatile bool           busy;   // A descriptor is in progress on the bus
+    I2CTransactionQueue     queue;  // Descriptors issued from the IRQ handler once idle
+#if I2C_FEATURE_SLAVE
+    volatile I2CSlaveState  slave;
+#endif
+    // Status acked by the top half, not processed yet. Until then the transaction belongs to the
+    // bottom half: the tick and the DMAC leave it alone.
+    volatile uint32_t       deferred_status;
+    I2CScanState            scan;
+    I2CStats                stats;
+} I2CDeviceContext;
+
+static I2CDeviceContext i2c_devices[I2C_MAX_DEVICES];
+#if I2C_FEATURE_DMA
+static I2CDeviceContext* volatile dmac_owner; // Device currently using DMAC_CHANNEL_I2C
+#endif
+
+uint32_t (* I2C_GetCycleCount)(void) = NULL;
+void (* I2C_PulseSCL)(I2CRegisters* i2c_dev) = NULL;
+void (* I2C_WaitCmd)(I2CRegisters* i2c_dev) = NULL;
+void (* I2C_DeferIrq)(I2CRegisters* i2c_dev) = NULL;
+
+static I2CDeviceContext* FindDeviceContext(I2CRegisters* i2c_dev);
+static I2CDeviceContext* AllocateDeviceContext(I2CRegisters* i2c_dev);
+static bool OtherDeviceEnabled(I2CDeviceContext* device);
+static uint32_t ReadRegister(I2CDeviceContext*       device,
+                             const volatile uint32_t* reg);
+static void WriteRegister(I2CDeviceContext* device,
+                          volatile uint32_t* reg,
+                          uint32_t           value);
+static void CommitRegister(I2CDeviceContext* device,
+                           volatile uint32_t* reg,
+                           uint32_t*          shadow,
+                           uint32_t           value);
+static void ReadShadowRegisters(I2CDeviceContext* device);
+static void ReadHWConfig(I2CDeviceContext* device);
+static bool I2CCmdPending(I2CDeviceContext* device);
+static bool WaitCmdIdle(I2CDeviceContext* device);
+static void I2CDisable(I2CDeviceContext* device);
+static bool I2CEnabled(I2CDeviceContext* device);
 static void EnableInterrupt(I2CRegisters* i2c_dev,
                             uint32_t      priority);
 static void DisableInterrupt(I2CRegisters* i2c_dev);
-static void WriteAvailableData(I2CRegisters* i2c_dev);
-static void ReadAvailableData(I2CRegisters* i2c_dev);
-static I2CReturnCode SetupDataPath(I2CRegisters* i2c_dev);
+static void RestoreInterrupt(I2CDeviceContext* device);
+static uint16_t FifoSpace(I2CDeviceContext* device,
+                          I2CDirection      dir,
+                          uint32_t          status);
+static uint32_t FifoInterrupt(I2CDeviceContext* device);
+static void LoadData(I2CDeviceContext* device,
+                     uint8_t*          data,
+                     uint16_t          data_count);
+static void LoadSegments(I2CDeviceContext* device,
+                         I2CSegment*       segments,
+                         uint8_t           segment_count);
+static uint16_t ContiguousData(I2CDeviceContext* device);
+static void SkipData(I2CDeviceContext* device,
+                     uint16_t          count);
+static uint8_t Crc8(uint8_t        crc,
+                    const uint8_t* data,
+                    uint16_t       count,
+                    uint8_t        polynomial);
+static void AccumulateAddressCrc(I2CDeviceContext* device,
+                                 I2CDirection      dir);
+static void AccumulateTxCrc(I2CDeviceContext* device,
+                            uint8_t*          data,
+                            uint16_t          length);
+static bool RxCrcFailed(I2CDeviceContext* device);
+static void WriteAvailableData(I2CDeviceContext* device,
+                               uint16_t          count);
+static void ReadAvailableData(I2CDeviceContext* device,
+                              uint16_t          count);
+static bool DMADataPath(I2CDeviceContext* device);
+static void ReleaseDMAC(I2CDeviceContext* device);
+#if I2C_FEATURE_DMA
+static uint8_t DMAPriority(I2CDeviceContext* device);
+static uint16_t DMATransferSizes(I2CDeviceContext* device);
+static uint8_t DMABurstSize(I2CDeviceContext* device);
+static I2CReturnCode SetupDMAChunk(I2CDeviceContext* device);
+static I2CReturnCode SetupDMATransfer(I2CDeviceContext* device);
+#endif
+static I2CReturnCode SetupDataPath(I2CDeviceContext* device);
+static uint32_t CtrlImage(uint32_t     phases,
+                          I2CDirection dir,
+                          uint16_t     data_count);
+static I2CReturnCode StartTransfer(I2CDeviceContext* device,
+                                   uint32_t          phases,
+                                   uint32_t          ctrl);
+static I2CReturnCode StartDataPhase(I2CDeviceContext* device,
+                                    uint32_t          phases,
+                                    bool              stop);
+static bool StartNextPhase(I2CDeviceContext* device,
+                           I2CReturnCode     status);
+static uint32_t SegmentsDataCount(I2CSegment* segments,
+                                  uint8_t     segment_count);
+static uint32_t DescriptorDataCount(I2CTransactionDescriptor* descriptor);
+static bool TxCrcByte(I2CTransactionDescriptor* descriptor);
+static uint32_t BusDataCount(I2CTransactionDescriptor* descriptor);
+#if I2C_VALIDATION_LEVEL == I2C_VALIDATION_FULL
+static bool ValidSegments(I2CTransactionDescriptor* descriptor);
+#endif
+static bool ValidDescriptor(I2CTransactionDescriptor* descriptor);
+static bool ValidTiming(const I2CTiming* timing);
+static void GetModeTiming(I2CMode    mode,
+                          I2CTiming* timing);
+static I2CDataPath SelectDataPath(I2CDeviceContext*         device,
+                                  I2CTransactionDescriptor* descriptor);
+static void LoadDescriptor(I2CDeviceContext*         device,
+                           I2CTransactionDescriptor* descriptor);
+static I2CReturnCode StartDescriptor(I2CDeviceContext*         device,
+                                     I2CTransactionDescriptor* descriptor);
+static void PrepareDescriptor(I2CDeviceContext*         device,
+                              I2CTransactionDescriptor* descriptor,
+                              I2CPreparedTransaction*   prepared);
+static I2CReturnCode IssuePrepared(I2CDeviceContext*             device,
+                                   const I2CPreparedTransaction* prepared,
+                                   bool                          polled);
+static I2CReturnCode IssueDescriptor(I2CDeviceContext*         device,
+                                     I2CTransactionDescriptor* descriptor,
+                                     bool                      polled);
+static I2CReturnCode EnqueueDescriptor(I2CDeviceContext*         device,
+                                       I2CTransactionDescriptor* descriptor);
+static I2CTransactionDescriptor* PopQueuedDescriptor(I2CDeviceContext* device);
+static void ReportCompletion(I2CTransactionDescriptor* descriptor,
+                             I2CCallback               callback,
+                             I2CContextCallback        context_callback,
+                             void*                     context,
+                             I2CReturnCode             status,
+                             uint32_t                  data_count);
+static void CompleteTransaction(I2CDeviceContext* device);
+static void RestartDescriptor(I2CDeviceContext* device);
+static void RetryAfterArbitrationLoss(I2CDeviceContext* device);
+static void AbortTransaction(I2CDeviceContext* device,
+                             I2CReturnCode     status);
+static void HandleStatus(I2CDeviceContext* device,
+                         uint32_t          status,
+                         bool              ack);
+static I2CReturnCode IssueScanProbe(I2CDeviceContext* device);
+static void ScanProbeComplete(void*         context,
+                              I2CReturnCode status,
+                              uint32_t      data_count,
+                              uint32_t      timestamp);
+#if I2C_FEATURE_SLAVE
+static bool ValidSlaveDescriptor(I2CSlaveDescriptor* descriptor);
+static void SlaveReceive(I2CDeviceContext* device,
+                         uint16_t          count);
+static void SlaveTransmit(I2CDeviceContext* device,
+                          uint16_t          count);
+static void StartSlaveTransfer(I2CDeviceContext* device,
+                               uint32_t          status);
+static void FinishSlaveTransfer(I2CDeviceContext* device);
+static void HandleSlaveStatus(I2CDeviceContext* device,
+                              uint32_t          status,
+                              bool              ack);
+#endif
+static void DeferStatus(I2CDeviceContext* device);
+
+static I2CDeviceContext* FindDeviceContext(I2CRegisters* i2c_dev)
+{
+    for (uint8_t i = 0; i < I2C_MAX_DEVICES; i++) {
+        if (i2c_devices[i].i2c_dev == i2c_dev) {
+            return &i2c_devices[i];
+        }
+    }
+    return NULL;
+}
+
+static I2CDeviceContext* AllocateDeviceContext(I2CRegisters* i2c_dev)
+{
+    I2CDeviceContext* device = FindDeviceContext(i2c_dev);
+
+    if (device == NULL) {
+        device = FindDeviceContext(NULL);
+    }
+    return device;
+}
+
+static bool OtherDeviceEnabled(I2CDeviceContext* device)
+{
+    for (uint8_t i = 0; i < I2C_MAX_DEVICES; i++) {
+        if ((&i2c_devices[i] != device) &&
+            (i2c_devices[i].i2c_dev != NULL) &&
+            I2CEnabled(&i2c_devices[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint32_t ReadRegister(I2CDeviceContext*       device,
+                             const volatile uint32_t* reg)
+{
+#if I2C_COUNT_MMIO_ACCESSES
+    device->stats.mmio_reads++;
+#else
+    UNUSED(device);
+#endif
+    return *reg;
+}
+
+static void WriteRegister(I2CDeviceContext* device,
+                          volatile uint32_t* reg,
+                          uint32_t           value)
+{
+#if I2C_COUNT_MMIO_ACCESSES
+    device->stats.mmio_writes++;
+#else
+    UNUSED(device);
+#endif
+    *reg = value;
+}
+
+// One write with the complete value, none when the register already holds it
+static void CommitRegister(I2CDeviceContext* device,
+                           volatile uint32_t* reg,
+                           uint32_t*          shadow,
+                           uint32_t           value)
+{
+    if (*shadow != value) {
+        *shadow = value;
+        // IntEn is masked until I2C_ProcessDeferredIrq is done with the deferred events
+        if ((reg == &device->i2c_dev->IntEn) && (device->deferred_status != 0)) {
+            return;
+        }
+        WriteRegister(device, reg, value);
+    }
+}
+
+static void ReadShadowRegisters(I2CDeviceContext* device)
+{
+    I2CRegisters* i2c_dev = device->i2c_dev;
+
+    device->shadow.IntEn = ReadRegister(device, &i2c_dev->IntEn);
+    device->shadow.Addr  = ReadRegister(device, &i2c_dev->Addr);
+    device->shadow.Setup = ReadRegister(device, &i2c_dev->Setup);
+    device->shadow.TPM   = ReadRegister(device, &i2c_dev->TPM);
+}
 
-static void ReadHWConfig(I2CRegisters* i2c_dev)
+static void ReadHWConfig(I2CDeviceContext* device)
 {
-    i2c_config.id_rev.id =
-        (uint32_t) ((i2c_dev->IdRev & I2C_IDREV_ID_MASK) >> I2C_IDREV_ID_OFFSET);
-    i2c_config.id_rev.major =
-        (uint8_t) ((i2c_dev->IdRev & I2C_IDREV_MAJOR_MASK) >> I2C_IDREV_MAJOR_OFFSET);
-    i2c_config.id_rev.minor =
-        (uint8_t) ((i2c_dev->IdRev & I2C_IDREV_MINOR_MASK) >> I2C_IDREV_MINOR_OFFSET);
-    i2c_config.fifo_size =
-        (uint8_t) (0x02 << ((i2c_dev->Cfg & I2C_CFG_FIFOSIZE_MASK) >> I2C_CFG_FIFOSIZE_OFFSET));
+    I2CRegisters* i2c_dev = device->i2c_dev;
+    uint32_t      id_rev  = ReadRegister(device, &i2c_dev->IdRev);
+    uint32_t      cfg     = ReadRegister(device, &i2c_dev->Cfg);
+
+    device->config.id_rev.id =
+        (uint32_t) ((id_rev & I2C_IDREV_ID_MASK) >> I2C_IDREV_ID_OFFSET);
+    device->config.id_rev.major =
+        (uint8_t) ((id_rev & I2C_IDREV_MAJOR_MASK) >> I2C_IDREV_MAJOR_OFFSET);
+    device->config.id_rev.minor =
+        (uint8_t) ((id_rev & I2C_IDREV_MINOR_MASK) >> I2C_IDREV_MINOR_OFFSET);
+    device->config.fifo_size =
+        (uint8_t) (0x02 << ((cfg & I2C_CFG_FIFOSIZE_MASK) >> I2C_CFG_FIFOSIZE_OFFSET));
 }
 
-static bool I2CCmdPending(I2CRegisters* i2c_dev)
+static bool I2CCmdPending(I2CDeviceContext* device)
 {
-    return (i2c_dev->Cmd & I2C_CMD_CMD_MASK) != 0;
+    return (ReadRegister(device, &device->i2c_dev->Cmd) & I2C_CMD_CMD_MASK) != 0;
 }
 
-static void I2CEnable(I2CRegisters* i2c_dev)
+// A reset or FIFO clear takes a few controller cycles, the next command is ignored until then
+static bool WaitCmdIdle(I2CDeviceContext* device)
 {
-    i2c_dev->Setup |= (0x01 << I2C_SETUP_IICEN_OFFSET) & I2C_SETUP_IICEN_MASK;
+    for (uint16_t polls = 0; polls < I2C_CMD_IDLE_POLLS; polls++) {
+        if (!I2CCmdPending(device)) {
+            return true;
+        }
+        if (I2C_WaitCmd != NULL) {
+            I2C_WaitCmd(device->i2c_dev);
+        }
+    }
+    return !I2CCmdPending(device);
 }
 
-static void I2CDisable(I2CRegisters* i2c_dev)
+static void I2CDisable(I2CDeviceContext* device)
 {
-    i2c_dev->Setup &= ~I2C_SETUP_IICEN_MASK;
+    CommitRegister(device, &device->i2c_dev->Setup, &device->shadow.Setup,
+                   device->shadow.Setup & ~I2C_SETUP_IICEN_MASK);
 }
 
-static bool I2CEnabled(I2CRegisters* i2c_dev)
+static bool I2CEnabled(I2CDeviceContext* device)
 {
-    return i2c_dev->Setup & I2C_SETUP_IICEN_MASK;
+    return device->shadow.Setup & I2C_SETUP_IICEN_MASK;
 }
 
-static bool FifoEmpty(I2CRegisters* i2c_dev)
+// Bytes that can be moved without polling the FIFO status:
+// all of it when empty (TX) or full (RX), half of it at the slave half-full watermark
+static uint16_t FifoSpace(I2CDeviceContext* device,
+                          I2CDirection      dir,
+                          uint32_t          status)
 {
-    return i2c_dev->Status & I2C_STATUS_FIFOEMPTY_MASK;
+    bool tx = (dir == I2C_TX);
+
+    if ((tx && (status & I2C_STATUS_FIFOEMPTY_MASK)) ||
+        ((!tx) && (status & I2C_STATUS_FIFOFULL_MASK))) {
+        return device->config.fifo_size;
+    }
+    if (status & I2C_STATUS_FIFOHALF_MASK) {
+        return device->config.fifo_size / 2;
+    }
+    return 0;
 }
 
-static bool FifoFull(I2CRegisters* i2c_dev)
+// Interrupt when empty/full, a whole FIFO per interrupt. The half-full watermark is only used by
+// the slave: it moves half the FIFO per interrupt, about twice the interrupts for the same data.
+static uint32_t FifoInterrupt(I2CDeviceContext* device)
 {
-    return i2c_dev->Status & I2C_STATUS_FIFOFULL_MASK;
+    return (device->transaction.dir == I2C_TX) ?
+           I2C_INTEN_FIFOEMPTY_MASK : I2C_INTEN_FIFOFULL_MASK;
 }
 
 static void EnableInterrupt(I2CRegisters* i2c_dev,
@@ -138,305 +465,1992 @@ static void DisableInterrupt(I2CRegisters* i2c_dev)
     ExternalInterrupts_DisableInterrupt(EXTERNAL_IRQ_I2C_SOURCE);
 }
 
-static void WriteAvailableData(I2CRegisters* i2c_dev)
+// End of a section entered outside of a call of the application: the tick, the DMAC or a late
+// bottom half. The line stays off once I2C_ShutdownController turned it off.
+static void RestoreInterrupt(I2CDeviceContext* device)
 {
-    while ((!FifoFull(i2c_dev)) &&
-           (current_transaction.remaining_data > 0)) {
-        i2c_dev->Data = (*current_transaction.data);
-        current_transaction.remaining_data--;
-        current_transaction.data++;
+    if (I2CEnabled(device) || OtherDeviceEnabled(device)) {
+        EnableInterrupt(device->i2c_dev, I2C_INTERRUPT_PRIORITY);
     }
+}
+
+// Data of the next data phases, from a single buffer
+static void LoadData(I2CDeviceContext* device,
+                     uint8_t*          data,
+                     uint16_t          data_count)
+{
+    device->transaction.data          = data;
+    device->transaction.segment_data  = data_count;
+    device->transaction.segment       = NULL;
+    device->transaction.segments_left = 0;
+    device->transaction.pending_data  = data_count;
+    device->transaction.crc_trailer   = false;
+}
+
+// Data of the next data phases, from the buffers of the segments in order
+static void LoadSegments(I2CDeviceContext* device,
+                         I2CSegment*       segments,
+                         uint8_t           segment_count)
+{
+    LoadData(device, segments[0].data, segments[0].data_count);
+    device->transaction.segment       = &(segments[1]);
+    device->transaction.segments_left = segment_count - 1;
+    device->transaction.pending_data  = (uint16_t) SegmentsDataCount(segments, segment_count);
+}
 
-    if (current_transaction.remaining_data == 0) {
-        i2c_dev->IntEn &= ~I2C_INTEN_FIFOEMPTY_MASK;
+// Bytes of the data phase stored from the data pointer on, up to the end of the segment
+static uint16_t ContiguousData(I2CDeviceContext* device)
+{
+    return (device->transaction.segment_data < device->transaction.remaining_data) ?
+           device->transaction.segment_data : device->transaction.remaining_data;
+}
+
+// Move the data pointer count bytes forward in the data phase, across segments
+static void SkipData(I2CDeviceContext* device,
+                     uint16_t          count)
+{
+    volatile I2CTransaction* transaction = &(device->transaction);
+
+    while (count > 0) {
+        uint16_t length = (transaction->segment_data < count) ? transaction->segment_data : count;
+
+        transaction->data           += length;
+        transaction->segment_data   -= length;
+        transaction->remaining_data -= length;
+        transaction->transferred    += length;
+        count                       -= length;
+        if ((transaction->segment_data == 0) && (transaction->segments_left != 0)) {
+            transaction->data         = transaction->segment->data;
+            transaction->segment_data = transaction->segment->data_count;
+            transaction->segment++;
+            transaction->segments_left--;
+        } else if ((transaction->segment_data == 0) && transaction->crc_trailer) {
+            // All the data bytes are accumulated: their CRC is the last byte
+            transaction->tx_crc       = transaction->crc;
+            transaction->data         = (uint8_t*) &(transaction->tx_crc);
+            transaction->segment_data = 1;
+            transaction->crc_trailer  = false;
+        } else if (length == 0) {
+            break;
+        }
     }
 }
 
-static void ReadAvailableData(I2CRegisters* i2c_dev)
+// MSB first, no final XOR: the CRC of the data followed by its CRC is 0
+static uint8_t Crc8(uint8_t        crc,
+                    const uint8_t* data,
+                    uint16_t       count,
+                    uint8_t        polynomial)
 {
-    while ((!FifoEmpty(i2c_dev)) &&
-           (current_transaction.remaining_data > 0)) {
-        (*current_transaction.data) = i2c_dev->Data;
-        current_transaction.remaining_data--;
-        current_transaction.data++;
+    while (count-- > 0) {
+        crc ^= *data++;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80u) ? (uint8_t) ((crc << 1) ^ polynomial) : (uint8_t) (crc << 1);
+        }
     }
+    return crc;
+}
+
+// SMBus PEC covers the address byte of each addressed phase, with the R/W bit
+static void AccumulateAddressCrc(I2CDeviceContext* device,
+                                 I2CDirection      dir)
+{
+    uint8_t address = (uint8_t) ((device->transaction.addr << 1) | (dir == I2C_RX));
 
-    if (current_transaction.remaining_data == 0) {
-        i2c_dev->IntEn &= ~I2C_INTEN_FIFOFULL_MASK;
+    if (device->transaction.crc_mode == I2C_CRC_PEC) {
+        device->transaction.crc = Crc8(device->transaction.crc,
+                                       &address,
+                                       1,
+                                       device->transaction.crc_polynomial);
     }
 }
 
-static I2CReturnCode SetupDataPath(I2CRegisters* i2c_dev)
+// Called before the bytes reach the controller, the CRC byte itself is sent from tx_crc
+static void AccumulateTxCrc(I2CDeviceContext* device,
+                            uint8_t*          data,
+                            uint16_t          length)
 {
-    if (current_transaction.remaining_data == 0) {
-        // Disable DMA
-        i2c_dev->Setup &= ~I2C_SETUP_DMAEN_MASK;
+    volatile I2CTransaction* transaction = &(device->transaction);
 
-        // Disable fifo interrupts
-        i2c_dev->IntEn &= ~I2C_INTEN_FIFOEMPTY_MASK;
-        i2c_dev->IntEn &= ~I2C_INTEN_FIFOFULL_MASK;
-        return I2C_OK;
+    if ((transaction->crc_mode == I2C_CRC_NONE) || (data == &(transaction->tx_crc))) {
+        return;
     }
+    transaction->crc = Crc8(transaction->crc, data, length, transaction->crc_polynomial);
+}
 
-    if (current_transaction.data_path == I2C_USE_FIFO) {
-        // Disable DMA
-        i2c_dev->Setup &= ~I2C_SETUP_DMAEN_MASK;
+// The last byte read is the CRC of the bytes before it
+static bool RxCrcFailed(I2CDeviceContext* device)
+{
+    return (device->transaction.crc_mode != I2C_CRC_NONE) &&
+           (device->transaction.dir == I2C_RX) &&
+           (device->transaction.pending_data == 0) &&
+           (device->transaction.crc != 0);
+}
 
-        // Setup FIFO
-        if (current_transaction.dir == I2C_TX) {
-            i2c_dev->IntEn |= I2C_INTEN_FIFOEMPTY_MASK;
-            WriteAvailableData(i2c_dev);
-        } else {
-            i2c_dev->IntEn |= I2C_INTEN_FIFOFULL_MASK;
+static void WriteAvailableData(I2CDeviceContext* device,
+                               uint16_t          count)
+{
+    I2CRegisters* i2c_dev = device->i2c_dev;
+
+    while ((count > 0) &&
+           (device->transaction.remaining_data > 0)) {
+        uint16_t length = ContiguousData(device);
+        uint8_t* data   = device->transaction.data;
+
+        if (length > count) {
+            length = count;
         }
-    } else {
-        // Setup DMA
-        DMACChannelConfig dmac_channel_config;
-
-        dmac_channel_config.channel            = DMAC_CHANNEL_I2C;
-        dmac_channel_config.src_bus_index      = 0;
-        dmac_channel_config.dst_bus_index      = 0;
-        dmac_channel_config.channel_priority   = 1;
-        dmac_channel_config.src_burst_size     = DMAC_BURST_SIZE_1;
-        dmac_channel_config.src_transfer_width = DMAC_TRANSFER_WIDTH_BYTE;
-        dmac_channel_config.dst_transfer_width = DMAC_TRANSFER_WIDTH_BYTE;
-        dmac_channel_config.src_handshake_mode = (current_transaction.dir == I2C_RX);
-        dmac_channel_config.dst_handshake_mode = (current_transaction.dir == I2C_TX);
-        dmac_channel_config.src_addr_ctrl      =
-            (current_transaction.dir == I2C_TX) ? DMAC_ADDR_CTRL_INCREMENT : DMAC_ADDR_CTRL_FIXED;
-        dmac_channel_config.dst_addr_ctrl =
-            (current_transaction.dir == I2C_TX) ? DMAC_ADDR_CTRL_FIXED : DMAC_ADDR_CTRL_INCREMENT;
-        dmac_channel_config.src_pair =
-            (current_transaction.dir == I2C_TX) ? 0 : DMAC_CHANNEL_I2C;
-        dmac_channel_config.dst_pair =
-            (current_transaction.dir == I2C_TX) ? DMAC_CHANNEL_I2C : 0;
-        if (DMAC_SetupChannel(HAL_DMAC,
-                              &dmac_channel_config,
-                              false,
-                              false,
-                              false,
-                              I2C_DMACCallback) != DMAC_OK) {
-            return I2C_DMAC_ERROR;
+        AccumulateTxCrc(device, data, length);
+        for (uint16_t i = 0; i < length; i++) {
+            WriteRegister(device, &i2c_dev->Data, data[i]);
         }
+        SkipData(device, length);
+        count -= length;
+    }
+
+    if (device->transaction.remaining_data == 0) {
+        CommitRegister(device, &i2c_dev->IntEn, &device->shadow.IntEn,
+                       device->shadow.IntEn &
+                       ~(I2C_INTEN_FIFOEMPTY_MASK | I2C_INTEN_FIFOHALF_MASK));
+    }
+}
 
-        DMACTransferConfig dmac_transfer_config;
+static void ReadAvailableData(I2CDeviceContext* device,
+                              uint16_t          count)
+{
+    I2CRegisters* i2c_dev = device->i2c_dev;
 
-        dmac_transfer_config.channel       = DMAC_CHANNEL_I2C;
-        dmac_transfer_config.transfer_size = current_transaction.remaining_data;
-        dmac_transfer_config.src_address   =
-            (current_transaction.dir == I2C_TX) ?
-            ((uint32_t) current_transaction.data) : (uint32_t) (&(i2c_dev->Data));
-        dmac_transfer_config.dst_address =
-            (current_transaction.dir == I2C_TX) ?
-            (uint32_t) (&(i2c_dev->Data)) : ((uint32_t) current_transaction.data);
-        if (DMAC_SetupTransfer(HAL_DMAC, &dmac_transfer_config) != DMAC_OK) {
-            return I2C_DMAC_ERROR;
+    while ((count > 0) &&
+           (device->transaction.remaining_data > 0)) {
+        uint16_t length = ContiguousData(device);
+        uint8_t* data   = device->transaction.data;
+
+        if (length > count) {
+            length = count;
         }
-        if (DMAC_EnableChannel(HAL_DMAC, DMAC_CHANNEL_I2C) != DMAC_OK) {
-            return I2C_DMAC_ERROR;
+        for (uint16_t i = 0; i < length; i++) {
+            data[i] = (uint8_t) ReadRegister(device, &i2c_dev->Data);
         }
-        // Disable fifo interrupts
-        i2c_dev->IntEn &= ~I2C_INTEN_FIFOEMPTY_MASK;
-        i2c_dev->IntEn &= ~I2C_INTEN_FIFOFULL_MASK;
-        // Enable I2C DMA
-        i2c_dev->Setup |= I2C_SETUP_DMAEN_MASK;
+        if (device->transaction.crc_mode != I2C_CRC_NONE) {
+            device->transaction.crc = Crc8(device->transaction.crc,
+                                           data,
+                                           length,
+                                           device->transaction.crc_polynomial);
+        }
+        SkipData(device, length);
+        count -= length;
+    }
+
+    if (device->transaction.remaining_data == 0) {
+        CommitRegister(device, &i2c_dev->IntEn, &device->shadow.IntEn,
+                       device->shadow.IntEn &
+                       ~(I2C_INTEN_FIFOFULL_MASK | I2C_INTEN_FIFOHALF_MASK));
     }
-    return I2C_OK;
 }
 
-void I2C_DMACCallback(DMACReturnCode return_code)
+static bool DMADataPath(I2CDeviceContext* device)
+{
+    return I2C_FEATURE_DMA && (device->transaction.data_path == I2C_USE_DMA);
+}
+
+static void ReleaseDMAC(I2CDeviceContext* device)
 {
-    if ((return_code != DMAC_TERMINAL_COUNT) &&
-        (current_transaction.callback != NULL)) {
-        current_transaction.callback(I2C_DMAC_ERROR);
+#if I2C_FEATURE_DMA
+    if (dmac_owner == device) {
+        dmac_owner = NULL;
     }
+#else
+    UNUSED(device);
+#endif
 }
 
-I2CReturnCode I2C_Create(I2CRegisters* i2c_dev)
+#if I2C_FEATURE_DMA
+static uint8_t DMAPriority(I2CDeviceContext* device)
 {
-    if (i2c_dev == NULL) {
-        return I2C_INVALID_INPUT_DATA;
+    return (device->transaction.dma_priority == I2C_DMA_PRIORITY_LOW) ? 0 : 1;
+}
+
+// Sizes of the DMA transfers of the data phase (one per segment) ORed together:
+// a power of two divides all of them when it divides the result
+static uint16_t DMATransferSizes(I2CDeviceContext* device)
+{
+    uint16_t    sizes         = ContiguousData(device);
+    uint16_t    left          = device->transaction.remaining_data - sizes;
+    I2CSegment* segment       = device->transaction.segment;
+    uint8_t     segments_left = device->transaction.segments_left;
+
+    while (left > 0) {
+        // Past the last segment, only the CRC byte is left
+        uint16_t size = ((segments_left != 0) && (segment->data_count < left)) ?
+                        segment->data_count : left;
+
+        sizes |= size;
+        left  -= size;
+        if (segments_left != 0) {
+            segment++;
+            segments_left--;
+        }
+    }
+    return sizes;
+}
+
+// Largest burst not above the requested one (half the FIFO by default) that
+// fits in the FIFO and splits the DMA transfers of the data phase into whole bursts
+static uint8_t DMABurstSize(I2CDeviceContext* device)
+{
+    const uint8_t dmac_burst_sizes[] = {
+        DMAC_BURST_SIZE_1,
+        DMAC_BURST_SIZE_2,
+        DMAC_BURST_SIZE_4,
+        DMAC_BURST_SIZE_8,
+        DMAC_BURST_SIZE_16
+    };
+    uint8_t burst = (device->transaction.dma_burst_size == I2C_DMA_BURST_SIZE_AUTO) ?
+                    (device->config.fifo_size / 2) :
+                    (0x01 << (device->transaction.dma_burst_size - I2C_DMA_BURST_SIZE_1));
+    uint16_t sizes = DMATransferSizes(device);
+    uint8_t  index = 0;
+
+    while ((burst > 1) &&
+           ((burst > device->config.fifo_size) ||
+            ((sizes % burst) != 0))) {
+        burst /= 2;
+    }
+    while ((burst >>= 1) != 0) {
+        index++;
+    }
+    return dmac_burst_sizes[index];
+}
+
+static I2CReturnCode SetupDMATransfer(I2CDeviceContext* device)
+{
+    DMACChannelConfig dmac_channel_config;
+
+    dmac_channel_config.channel            = DMAC_CHANNEL_I2C;
+    dmac_channel_config.src_bus_index      = 0;
+    dmac_channel_config.dst_bus_index      = 0;
+    dmac_channel_config.channel_priority   = DMAPriority(device);
+    dmac_channel_config.src_burst_size     = DMABurstSize(device);
+    dmac_channel_config.src_transfer_width = DMAC_TRANSFER_WIDTH_BYTE;
+    dmac_channel_config.dst_transfer_width = DMAC_TRANSFER_WIDTH_BYTE;
+    dmac_channel_config.src_handshake_mode = (device->transaction.dir == I2C_RX);
+    dmac_channel_config.dst_handshake_mode = (device->transaction.dir == I2C_TX);
+    dmac_channel_config.src_addr_ctrl      =
+        (device->transaction.dir == I2C_TX) ? DMAC_ADDR_CTRL_INCREMENT : DMAC_ADDR_CTRL_FIXED;
+    dmac_channel_config.dst_addr_ctrl =
+        (device->transaction.dir == I2C_TX) ? DMAC_ADDR_CTRL_FIXED : DMAC_ADDR_CTRL_INCREMENT;
+    dmac_channel_config.src_pair =
+        (device->transaction.dir == I2C_TX) ? 0 : DMAC_CHANNEL_I2C;
+    dmac_channel_config.dst_pair =
+        (device->transaction.dir == I2C_TX) ? DMAC_CHANNEL_I2C : 0;
+    if (DMAC_SetupChannel(HAL_DMAC,
+                          &dmac_channel_config,
+                          false,
+                          false,
+                          false,
+                          I2C_DMACCallback) != DMAC_OK) {
+        return I2C_DMAC_ERROR;
+    }
+    return SetupDMAChunk(device);
+}
+
+// One DMA transfer per segment in the data phase
+static I2CReturnCode SetupDMAChunk(I2CDeviceContext* device)
+{
+    I2CRegisters*      i2c_dev = device->i2c_dev;
+    DMACTransferConfig dmac_transfer_config;
+
+    device->transaction.dma_data = ContiguousData(device);
+    if (device->transaction.dir == I2C_TX) {
+        AccumulateTxCrc(device, device->transaction.data, device->transaction.dma_data);
+    }
+
+    dmac_transfer_config.channel       = DMAC_CHANNEL_I2C;
+    dmac_transfer_config.transfer_size = device->transaction.dma_data;
+    dmac_transfer_config.src_address   =
+        (device->transaction.dir == I2C_TX) ?
+        ((uint32_t) device->transaction.data) : (uint32_t) (&(i2c_dev->Data));
+    dmac_transfer_config.dst_address =
+        (device->transaction.dir == I2C_TX) ?
+        (uint32_t) (&(i2c_dev->Data)) : ((uint32_t) device->transaction.data);
+    if (DMAC_SetupTransfer(HAL_DMAC, &dmac_transfer_config) != DMAC_OK) {
+        return I2C_DMAC_ERROR;
     }
-    ReadHWConfig(i2c_dev);
     return I2C_OK;
 }
+#endif
 
-I2CReturnCode I2C_GetConfig(I2CRegisters* i2c_dev,
-                            I2CConfig**   return_value)
+static I2CReturnCode SetupDataPath(I2CDeviceContext* device)
 {
-    if ((i2c_dev == NULL) ||
-        (return_value == NULL)) {
-        return I2C_INVALID_INPUT_DATA;
+#if I2C_FEATURE_DMA
+    I2CRegisters* i2c_dev = device->i2c_dev;
+
+    ReleaseDMAC(device);
+
+    if ((device->transaction.remaining_data == 0) ||
+        (!DMADataPath(device))) {
+        // Disable DMA
+        CommitRegister(device, &i2c_dev->Setup, &device->shadow.Setup,
+                       device->shadow.Setup & ~I2C_SETUP_DMAEN_MASK);
+    }
+
+    if ((device->transaction.remaining_data != 0) && DMADataPath(device)) {
+        // The DMA channel is shared by all the controllers
+        if (dmac_owner != NULL) {
+            return I2C_DMAC_CHANNEL_BUSY;
+        }
+
+        // Setup DMA
+        I2CReturnCode ret = SetupDMATransfer(device);
+
+        if (ret != I2C_OK) {
+            return ret;
+        }
+        dmac_owner = device;
+        if (DMAC_EnableChannel(HAL_DMAC, DMAC_CHANNEL_I2C) != DMAC_OK) {
+            dmac_owner = NULL;
+            return I2C_DMAC_ERROR;
+        }
+        // Enable I2C DMA
+        CommitRegister(device, &i2c_dev->Setup, &device->shadow.Setup,
+                       device->shadow.Setup | I2C_SETUP_DMAEN_MASK);
+        return I2C_OK;
+    }
+#endif
+
+    if ((device->transaction.remaining_data != 0) &&
+        (device->transaction.dir == I2C_TX)) {
+        // The FIFO is empty before a data phase: fill it up
+        WriteAvailableData(device, device->config.fifo_size);
     }
-    *return_value = &i2c_config;
     return I2C_OK;
 }
 
-I2CReturnCode I2C_SetupController(I2CRegisters* i2c_dev,
-                                  I2CSetupInfo* setup_info)
+// Transaction Phases, Direction and Data Count
+static uint32_t CtrlImage(uint32_t     phases,
+                          I2CDirection dir,
+                          uint16_t     data_count)
 {
-    if ((i2c_dev == NULL) ||
-        (setup_info == NULL) ||
-        (setup_info->mode >= I2C_UNSUPPORTED_MODE)) {
-        return I2C_INVALID_INPUT_DATA;
+    return phases |
+           ((dir << I2C_CTRL_DIR_OFFSET) & I2C_CTRL_DIR_MASK) |
+           ((data_count << I2C_CTRL_DATACNT_OFFSET) & I2C_CTRL_DATACNT_MASK);
+}
+
+static I2CReturnCode StartTransfer(I2CDeviceContext* device,
+                                   uint32_t          phases,
+                                   uint32_t          ctrl)
+{
+    I2CRegisters* i2c_dev = device->i2c_dev;
+    I2CReturnCode ret     = I2C_OK;
+
+    device->transaction.phases = phases;
+
+    WriteRegister(device, &i2c_dev->Ctrl, ctrl);
+
+    // Setup Data Path (DMA or FIFO)
+    if ((ret = SetupDataPath(device)) != I2C_OK) {
+        return ret;
     }
 
-    i2c_dev->Setup &= ~I2C_SETUP_MASTER_MASK;
-    i2c_dev->Setup |= (setup_info->role << I2C_SETUP_MASTER_OFFSET) & I2C_SETUP_MASTER_MASK;
+    // Completion and FIFO interrupts of the phase in a single write
+    uint32_t int_en = device->shadow.IntEn &
+                      ~(I2C_INTEN_CMPL_MASK | I2C_INTEN_ARBLOSE_MASK | I2C_INTEN_FIFOEMPTY_MASK |
+                        I2C_INTEN_FIFOFULL_MASK | I2C_INTEN_FIFOHALF_MASK);
 
-    // Setup Timing Parameter Multiplier
-    i2c_dev->TPM |= (I2C_TPM << I2C_TPM_TPM_OFFSET) & I2C_TPM_TPM_MASK;
+    if (!device->transaction.polled) {
+        int_en |= I2C_INTEN_CMPL_MASK | I2C_INTEN_ARBLOSE_MASK;
+        if ((!DMADataPath(device)) &&
+            (device->transaction.remaining_data != 0)) {
+            int_en |= FifoInterrupt(device);
+        }
+    }
+    CommitRegister(device, &i2c_dev->IntEn, &device->shadow.IntEn, int_en);
 
-    // Setup Timing Parameters
-    i2c_dev->Setup &= ~I2C_SETUP_T_SP_MASK;
-    i2c_dev->Setup |= (T_SP << I2C_SETUP_T_SP_OFFSET) & I2C_SETUP_T_SP_MASK;
+    // Issue Transaction
+    WriteRegister(device, &i2c_dev->Cmd,
+                  (I2C_CMD_ISSUE_TRANSACTION << I2C_CMD_CMD_OFFSET) & I2C_CMD_CMD_MASK);
 
-    I2CMode mode = setup_info->mode;
+    return ret;
+}
 
-    i2c_dev->Setup &= ~I2C_SETUP_T_SUDAT_MASK;
-    i2c_dev->Setup |= (T_SUDAT(mode) << I2C_SETUP_T_SUDAT_OFFSET) &
-                      I2C_SETUP_T_SUDAT_MASK;
+// Next data phase of the data loaded by LoadData or LoadSegments
+static I2CReturnCode StartDataPhase(I2CDeviceContext* device,
+                                    uint32_t          phases,
+                                    bool              stop)
+{
+    uint16_t pending = device->transaction.pending_data;
+    uint16_t length  = (pending > I2C_MAX_DATA_PHASE_LENGTH) ? I2C_MAX_DATA_PHASE_LENGTH : pending;
 
-    i2c_dev->Setup &= ~I2C_SETUP_T_HDDAT_MASK;
-    i2c_dev->Setup |= (T_HDDAT(mode) << I2C_SETUP_T_HDDAT_OFFSET) &
-                      I2C_SETUP_T_HDDAT_MASK;
+    device->transaction.remaining_data = length;
+    device->transaction.pending_data   = pending - length;
 
-    i2c_dev->Setup &= ~I2C_SETUP_T_SCLHI_MASK;
-    i2c_dev->Setup |= (T_SCLHI(mode) << I2C_SETUP_T_SCLHI_OFFSET) &
-                      I2C_SETUP_T_SCLHI_MASK;
+    if (length != 0) {
+        phases |= I2C_CTRL_PHASE_DATA_MASK;
+    }
+    // Larger transfers keep the bus: STOP only after the last data phase
+    if (stop && (device->transaction.pending_data == 0)) {
+        phases |= I2C_CTRL_PHASE_STOP_MASK;
+    }
+    return StartTransfer(device, phases, CtrlImage(phases, device->transaction.dir, length));
+}
 
-    i2c_dev->Setup &= ~I2C_SETUP_T_SCLRATIO_MASK;
-    i2c_dev->Setup |= (T_SCLRATIO(mode) << I2C_SETUP_T_SCLRATIO_OFFSET) &
-                      I2C_SETUP_T_SCLRATIO_MASK;
+static bool StartNextPhase(I2CDeviceContext* device,
+                           I2CReturnCode     status)
+{
+    volatile I2CTransaction* transaction = &(device->transaction);
 
-    I2CEnable(i2c_dev);
+    if ((status == I2C_OK) && (transaction->pending_data != 0)) {
+        // Continue the data phase in the same direction, no START nor ADDR
+        status = StartDataPhase(device, 0, transaction->rx_data_count == 0);
+        if (status == I2C_OK) {
+            return true;
+        }
+    } else if ((status == I2C_OK) && (transaction->rx_data_count != 0)) {
+        // Write phase done, the bus is still held: repeated START and read
+        uint16_t rx_data_count = transaction->rx_data_count;
+
+        transaction->dir           = I2C_RX;
+        transaction->rx_data_count = 0;
+        if (transaction->crc_mode == I2C_CRC_DATA) {
+            // Only the read bytes are covered
+            transaction->crc = 0;
+        }
+        AccumulateAddressCrc(device, I2C_RX);
+        LoadData(device, transaction->rx_data, rx_data_count);
+        status = StartDataPhase(device, I2C_CTRL_PHASE_START_MASK | I2C_CTRL_PHASE_ADDR_MASK, true);
+        if (status == I2C_OK) {
+            return true;
+        }
+    }
 
-    return I2C_OK;
+    transaction->status = status;
+
+    if (!(transaction->phases & I2C_CTRL_PHASE_STOP_MASK)) {
+        // A phase without STOP failed: release the bus before reporting
+        transaction->remaining_data = 0;
+        transaction->pending_data   = 0;
+        transaction->rx_data_count  = 0;
+        if (StartTransfer(device,
+                          I2C_CTRL_PHASE_STOP_MASK,
+                          CtrlImage(I2C_CTRL_PHASE_STOP_MASK, transaction->dir, 0)) == I2C_OK) {
+            return true;
+        }
+    }
+    return false;
 }
 
-I2CReturnCode I2C_ShutdownController(I2CRegisters* i2c_dev)
+static uint32_t SegmentsDataCount(I2CSegment* segments,
+                                  uint8_t     segment_count)
 {
-    if (i2c_dev == NULL) {
-        return I2C_INVALID_INPUT_DATA;
+    uint32_t data_count = 0;
+
+    for (uint8_t i = 0; i < segment_count; i++) {
+        data_count += segments[i].data_count;
     }
-    DisableInterrupt(i2c_dev);
-    I2CDisable(i2c_dev);
-    return I2C_OK;
+    return data_count;
 }
 
-I2CReturnCode I2C_LaunchTransaction(I2CRegisters*             i2c_dev,
-                                    I2CTransactionDescriptor* descriptor)
+static uint32_t DescriptorDataCount(I2CTransactionDescriptor* descriptor)
 {
-    I2CReturnCode ret = I2C_OK;
+    return (descriptor->segments != NULL) ?
+           SegmentsDataCount(descriptor->segments, descriptor->segment_count) :
+           descriptor->data_count;
+}
 
-    if ((i2c_dev == NULL) ||
-        (descriptor == NULL) ||
-        ((descriptor->data == NULL) && (descriptor->data_count != 0)) ||
-        ((descriptor->data == NULL) && (descriptor->data_count == 0) &&
-         (descriptor->direction != I2C_TX)) ||
-        ((descriptor->data != NULL) && (descriptor->data_count == 0)) ||
-        (descriptor->data_count > (I2C_CTRL_DATACNT_MASK + 1)) ||
-        ((descriptor->addressing_mode == I2C_ADDRESSING_MODE_10_BIT) &&
-         (descriptor->address > I2C_ADDR_MAX_10BIT)) ||
-        ((descriptor->addressing_mode == I2C_ADDRESSING_MODE_7_BIT) &&
-         (descriptor->address > I2C_ADDR_MAX_7BIT))) {
-        return I2C_INVALID_INPUT_DATA;
+// A write ends with the CRC byte generated by the HAL, a write-read only checks the read bytes
+static bool TxCrcByte(I2CTransactionDescriptor* descriptor)
+{
+    return (descriptor->crc != I2C_CRC_NONE) &&
+           (descriptor->direction == I2C_TX) &&
+           (descriptor->type != I2C_WRITE_READ_TRANSACTION);
+}
+
+// Bytes of the first data phases on the bus, the generated CRC byte included
+static uint32_t BusDataCount(I2CTransactionDescriptor* descriptor)
+{
+    return DescriptorDataCount(descriptor) + (TxCrcByte(descriptor) ? 1 : 0);
+}
+
+#if I2C_VALIDATION_LEVEL == I2C_VALIDATION_FULL
+static bool ValidSegments(I2CTransactionDescriptor* descriptor)
+{
+    if (descriptor->segments == NULL) {
+        return true;
     }
+    if ((descriptor->data != NULL) ||
+        (descriptor->data_count != 0) ||
+        (descriptor->direction != I2C_TX) ||
+        (descriptor->segment_count == 0) ||
+        (SegmentsDataCount(descriptor->segments, descriptor->segment_count) > UINT16_MAX)) {
+        return false;
+    }
+    for (uint8_t i = 0; i < descriptor->segment_count; i++) {
+        if ((descriptor->segments[i].data == NULL) || (descriptor->segments[i].data_count == 0)) {
+            return false;
+        }
+    }
+    return true;
+}
 
-    if (!I2CEnabled(i2c_dev)) {
-        return I2C_CONTROLLER_NOT_ENABLED;
+#endif
+
+static bool ValidDescriptor(I2CTransactionDescriptor* descriptor)
+{
+#if I2C_VALIDATION_LEVEL == I2C_VALIDATION_BASIC
+    // The caller is trusted with the descriptor fields
+    return descriptor != NULL;
+#else
+    return !((descriptor == NULL) ||
+             (!ValidSegments(descriptor)) ||
+             ((descriptor->data == NULL) && (descriptor->data_count != 0)) ||
+             ((descriptor->data == NULL) && (descriptor->data_count == 0) &&
+              (descriptor->direction != I2C_TX)) ||
+             ((descriptor->data != NULL) && (descriptor->data_count == 0)) ||
+             ((descriptor->addressing_mode == I2C_ADDRESSING_MODE_10_BIT) &&
+              (descriptor->address > I2C_ADDR_MAX_10BIT)) ||
+             ((descriptor->addressing_mode == I2C_ADDRESSING_MODE_7_BIT) &&
+              (descriptor->address > I2C_ADDR_MAX_7BIT)) ||
+             ((!I2C_FEATURE_10_BIT_ADDRESSING) &&
+              (descriptor->addressing_mode != I2C_ADDRESSING_MODE_7_BIT)) ||
+             ((!I2C_FEATURE_DMA) && (descriptor->data_path == I2C_USE_DMA)) ||
+             (descriptor->type >= I2C_UNSUPPORTED_TRANSACTION) ||
+             (descriptor->dma_priority >= I2C_DMA_PRIORITY_UNSUPPORTED) ||
+             (descriptor->dma_burst_size >= I2C_DMA_BURST_SIZE_UNSUPPORTED) ||
+             (descriptor->crc >= I2C_CRC_UNSUPPORTED) ||
+             ((descriptor->crc != I2C_CRC_NONE) &&
+              (descriptor->data == NULL) && (descriptor->segments == NULL)) ||
+             ((descriptor->crc == I2C_CRC_PEC) &&
+              (descriptor->addressing_mode != I2C_ADDRESSING_MODE_7_BIT)) ||
+             (BusDataCount(descriptor) > UINT16_MAX) ||
+             ((descriptor->type == I2C_WRITE_READ_TRANSACTION) &&
+              ((descriptor->direction != I2C_TX) ||
+               ((descriptor->data == NULL) && (descriptor->segments == NULL)) ||
+               (descriptor->rx_data == NULL) ||
+               (descriptor->rx_data_count == 0))));
+#endif
+}
+
+static bool ValidTiming(const I2CTiming* timing)
+{
+    return (timing->tpm <= I2C_TIMING_TPM_MAX) &&
+           (timing->t_sp <= I2C_TIMING_SP_MAX) &&
+           (timing->t_sudat <= I2C_TIMING_SUDAT_MAX) &&
+           (timing->t_hddat <= I2C_TIMING_HDDAT_MAX) &&
+           (timing->t_sclhi <= I2C_TIMING_SCLHI_MAX) &&
+           (timing->t_sclratio <= 1);
+}
+
+static void GetModeTiming(I2CMode    mode,
+                          I2CTiming* timing)
+{
+#if !I2C_FEATURE_FAST_MODES
+    UNUSED(mode);
+#endif
+    timing->tpm        = I2C_TPM;
+    timing->t_sp       = T_SP;
+    timing->t_sudat    = T_SUDAT(mode);
+    timing->t_hddat    = T_HDDAT(mode);
+    timing->t_sclhi    = T_SCLHI(mode);
+    timing->t_sclratio = T_SCLRATIO(mode);
+}
+
+static I2CDataPath SelectDataPath(I2CDeviceContext*         device,
+                                  I2CTransactionDescriptor* descriptor)
+{
+    if (descriptor->data_path != I2C_USE_AUTO) {
+        return descriptor->data_path;
     }
 
-    if (I2CCmdPending(i2c_dev)) {
-        return I2C_CMD_PENDING;
+#if I2C_FEATURE_DMA
+    uint32_t data_count = DescriptorDataCount(descriptor);
+
+    if (descriptor->type == I2C_WRITE_READ_TRANSACTION) {
+        data_count += descriptor->rx_data_count;
     }
+    return (data_count >= device->stats.auto_dma_threshold) ? I2C_USE_DMA : I2C_USE_FIFO;
+#else
+    UNUSED(device);
+    return I2C_USE_FIFO;
+#endif
+}
 
-    current_transaction.role =
-        (bool) ((i2c_dev->Setup & I2C_SETUP_MASTER_MASK) >> I2C_SETUP_MASTER_OFFSET);
-    current_transaction.addr           = descriptor->address;
-    current_transaction.addr_mode      = descriptor->addressing_mode;
-    current_transaction.dir            = descriptor->direction;
-    current_transaction.remaining_data = descriptor->data_count;
-    current_transaction.data           = descriptor->data;
-    current_transaction.data_path      = descriptor->data_path;
-    current_transaction.callback       = descriptor->callback;
-
-    // Set address and addressing mode
-    i2c_dev->Addr &= ~I2C_ADDR_ADDR_MASK;
-    i2c_dev->Addr |= (descriptor->address << I2C_ADDR_ADDR_OFFSET) & I2C_ADDR_ADDR_MASK;
-
-    i2c_dev->Setup &= ~I2C_SETUP_ADDRESSING_MASK;
-    i2c_dev->Setup |= (descriptor->addressing_mode << I2C_SETUP_ADDRESSING_OFFSET) &
-                      I2C_SETUP_ADDRESSING_MASK;
-
-    // Set transaction Phases
-    i2c_dev->Ctrl |= I2C_CTRL_PHASE_START_MASK;
-    i2c_dev->Ctrl |= I2C_CTRL_PHASE_ADDR_MASK;
-    if (current_transaction.data != NULL) {
-        i2c_dev->Ctrl |= I2C_CTRL_PHASE_DATA_MASK;
+static void LoadDescriptor(I2CDeviceContext*         device,
+                           I2CTransactionDescriptor* descriptor)
+{
+    bool write_read = (descriptor->type == I2C_WRITE_READ_TRANSACTION);
+
+    device->transaction.dir            = descriptor->direction;
+    device->transaction.rx_data        = write_read ? descriptor->rx_data : NULL;
+    device->transaction.rx_data_count  = write_read ? descriptor->rx_data_count : 0;
+    device->transaction.status         = I2C_OK;
+    device->transaction.transferred    = 0;
+    device->transaction.crc_mode       = descriptor->crc;
+    device->transaction.crc_polynomial = descriptor->crc_polynomial;
+    device->transaction.crc            = 0;
+    AccumulateAddressCrc(device, descriptor->direction);
+
+    if (descriptor->segments != NULL) {
+        LoadSegments(device, descriptor->segments, descriptor->segment_count);
     } else {
-        i2c_dev->Ctrl &= ~I2C_CTRL_PHASE_DATA_MASK;
+        LoadData(device, descriptor->data, descriptor->data_count);
     }
-    i2c_dev->Ctrl |= I2C_CTRL_PHASE_STOP_MASK;
+    if (TxCrcByte(descriptor)) {
+        device->transaction.crc_trailer   = true;
+        device->transaction.pending_data += 1;
+    }
+}
+
+// Starts the descriptor over after lost arbitration
+static I2CReturnCode StartDescriptor(I2CDeviceContext*         device,
+                                     I2CTransactionDescriptor* descriptor)
+{
+    LoadDescriptor(device, descriptor);
 
-    // Set Direction
-    i2c_dev->Ctrl &= ~I2C_CTRL_DIR_MASK;
-    i2c_dev->Ctrl |= (descriptor->direction << I2C_CTRL_DIR_OFFSET) & I2C_CTRL_DIR_MASK;
+    // A write-read keeps the bus (no STOP) for the repeated START of its read phase
+    return StartDataPhase(device,
+                          I2C_CTRL_PHASE_START_MASK | I2C_CTRL_PHASE_ADDR_MASK,
+                          descriptor->type != I2C_WRITE_READ_TRANSACTION);
+}
 
-    // Set Data Count
-    i2c_dev->Ctrl &= ~I2C_CTRL_DATACNT_MASK;
-    i2c_dev->Ctrl |= (descriptor->data_count << I2C_CTRL_DATACNT_OFFSET) & I2C_CTRL_DATACNT_MASK;
+// Register images of the first phase, the same for each launch of the descriptor
+static void PrepareDescriptor(I2CDeviceContext*         device,
+                              I2CTransactionDescriptor* descriptor,
+                              I2CPreparedTransaction*   prepared)
+{
+    uint32_t data_count = BusDataCount(descriptor);
+    uint16_t length     = (data_count > I2C_MAX_DATA_PHASE_LENGTH) ? I2C_MAX_DATA_PHASE_LENGTH :
+                          data_count;
+    uint32_t phases     = I2C_CTRL_PHASE_START_MASK | I2C_CTRL_PHASE_ADDR_MASK;
 
-    // Setup Data Path (DMA or FIFO)
-    if ((ret = SetupDataPath(i2c_dev) != I2C_OK)) {
-        return ret;
+    if (length != 0) {
+        phases |= I2C_CTRL_PHASE_DATA_MASK;
+    }
+    // A write-read keeps the bus (no STOP) for the repeated START of its read phase
+    if ((descriptor->type != I2C_WRITE_READ_TRANSACTION) && (data_count == length)) {
+        phases |= I2C_CTRL_PHASE_STOP_MASK;
     }
-    i2c_dev->IntEn |= I2C_INTEN_CMPL_MASK;
 
-    // Issue Transaction
-    i2c_dev->Cmd |= (I2C_CMD_ISSUE_TRANSACTION << I2C_CMD_CMD_OFFSET) & I2C_CMD_CMD_MASK;
+    prepared->i2c_dev          = device->i2c_dev;
+    prepared->descriptor       = descriptor;
+    prepared->addr             = (descriptor->address << I2C_ADDR_ADDR_OFFSET) &
+                                 I2C_ADDR_ADDR_MASK;
+    prepared->addressing       = (descriptor->addressing_mode << I2C_SETUP_ADDRESSING_OFFSET) &
+                                 I2C_SETUP_ADDRESSING_MASK;
+    prepared->phases           = phases;
+    prepared->ctrl             = CtrlImage(phases, descriptor->direction, length);
+    prepared->phase_data_count = length;
+    prepared->data_path        = SelectDataPath(device, descriptor);
+}
 
-    EnableInterrupt(i2c_dev, I2C_INTERRUPT_PRIORITY);
+static I2CReturnCode IssuePrepared(I2CDeviceContext*             device,
+                                   const I2CPreparedTransaction* prepared,
+                                   bool                          polled)
+{
+    I2CRegisters*             i2c_dev    = device->i2c_dev;
+    I2CTransactionDescriptor* descriptor = prepared->descriptor;
+    I2CDataPath               data_path  = polled ? I2C_USE_FIFO : prepared->data_path;
+    I2CReturnCode             ret        = I2C_OK;
+
+    if (!I2CEnabled(device)) {
+        return I2C_CONTROLLER_NOT_ENABLED;
+    }
+
+    if (I2CCmdPending(device)) {
+        return I2C_CMD_PENDING;
+    }
+
+#if I2C_FEATURE_DMA
+    // Fall back to the FIFO rather than waiting for the DMA channel
+    if ((descriptor->data_path == I2C_USE_AUTO) && (data_path == I2C_USE_DMA) &&
+        (dmac_owner != NULL) && (dmac_owner != device)) {
+        data_path = I2C_USE_FIFO;
+    }
+#endif
+
+    device->transaction.role =
+        (bool) ((device->shadow.Setup & I2C_SETUP_MASTER_MASK) >> I2C_SETUP_MASTER_OFFSET);
+    device->transaction.addr                = descriptor->address;
+    device->transaction.addr_mode           = descriptor->addressing_mode;
+    device->transaction.data_path           = data_path;
+    device->transaction.dma_priority        = descriptor->dma_priority;
+    device->transaction.dma_burst_size      = descriptor->dma_burst_size;
+    device->transaction.callback            = descriptor->callback;
+    device->transaction.context_callback    = descriptor->context_callback;
+    device->transaction.context             = descriptor->context;
+    device->transaction.polled              = polled;
+    device->transaction.ticks_left          = polled ? 0 : descriptor->timeout;
+    device->transaction.arbitration_retries = 0;
+    device->transaction.backoff_ticks       = 0;
+    device->transaction.descriptor          = descriptor;
+
+    // Set address and addressing mode, unchanged for back-to-back transactions to a target
+    CommitRegister(device, &i2c_dev->Addr, &device->shadow.Addr,
+                   (device->shadow.Addr & ~I2C_ADDR_ADDR_MASK) | prepared->addr);
+#if I2C_FEATURE_10_BIT_ADDRESSING
+    CommitRegister(device, &i2c_dev->Setup, &device->shadow.Setup,
+                   (device->shadow.Setup & ~I2C_SETUP_ADDRESSING_MASK) | prepared->addressing);
+#endif
+
+    LoadDescriptor(device, descriptor);
+    device->transaction.remaining_data = prepared->phase_data_count;
+    device->transaction.pending_data  -= prepared->phase_data_count;
+
+    if ((ret = StartTransfer(device, prepared->phases, prepared->ctrl)) != I2C_OK) {
+        return ret;
+    }
+    device->busy = true;
+
+    if ((descriptor->data != NULL) || (descriptor->segments != NULL)) {
+        if (DMADataPath(device)) {
+            device->stats.dma_transactions++;
+        } else {
+            device->stats.fifo_transactions++;
+        }
+    }
 
     return ret;
 }
 
-void ExternalInterrupts_I2cIrqHandler(void)
+static I2CReturnCode IssueDescriptor(I2CDeviceContext*         device,
+                                     I2CTransactionDescriptor* descriptor,
+                                     bool                      polled)
 {
-    I2C_DeviceIrqHandler(HAL_I2C);
+    I2CPreparedTransaction prepared;
+
+    PrepareDescriptor(device, descriptor, &prepared);
+    return IssuePrepared(device, &prepared, polled);
 }
 
-I2CReturnCode I2C_DeviceIrqHandler(I2CRegisters* i2c_dev)
+static I2CReturnCode EnqueueDescriptor(I2CDeviceContext*         device,
+                                       I2CTransactionDescriptor* descriptor)
 {
-    if (i2c_dev == NULL) {
-        return I2C_INVALID_INPUT_DATA;
+    if (device->queue.count == I2C_TRANSACTION_QUEUE_DEPTH) {
+        return I2C_QUEUE_FULL;
     }
 
-    if ((i2c_dev->Status & I2C_STATUS_CMPL_MASK)) {
-        I2CReturnCode ret = (i2c_dev->Status &
-                             I2C_STATUS_ADDRHIT_MASK) ? I2C_OK : I2C_ADDR_HIT_ERROR;
-        if ((ret == I2C_OK) &&
-            (current_transaction.dir == I2C_RX) &&
-            (current_transaction.data_path != I2C_USE_DMA)) {
-            ReadAvailableData(i2c_dev);
-        }
-        i2c_dev->Status |= I2C_STATUS_CMPL_MASK;
-        if (current_transaction.callback != NULL) {
-            current_transaction.callback(ret);
-        }
-        return I2C_OK;
-    }
+    uint8_t tail = (device->queue.head + device->queue.count) % I2C_TRANSACTION_QUEUE_DEPTH;
 
-    if (((i2c_dev->Status & I2C_STATUS_FIFOEMPTY_MASK)) &&
-        (current_transaction.dir == I2C_TX)) {
-        WriteAvailableData(i2c_dev);
-        return I2C_OK;
+    device->queue.descriptors[tail] = descriptor;
+    device->queue.count++;
+    return I2C_OK;
+}
+
+static I2CTransactionDescriptor* PopQueuedDescriptor(I2CDeviceContext* device)
+{
+    if (device->queue.count == 0) {
+        return NULL;
     }
 
-    if (((i2c_dev->Status & I2C_STATUS_FIFOFULL_MASK)) &&
-        (current_transaction.dir == I2C_RX)) {
-        ReadAvailableData(i2c_dev);
-        return I2C_OK;
+    I2CTransactionDescriptor* descriptor = device->queue.descriptors[device->queue.head];
+
+    device->queue.head = (device->queue.head + 1) % I2C_TRANSACTION_QUEUE_DEPTH;
+    device->queue.count--;
+    return descriptor;
+}
+
+static void ReportCompletion(I2CTransactionDescriptor* descriptor,
+                             I2CCallback               callback,
+                             I2CContextCallback        context_callback,
+                             void*                     context,
+                             I2CReturnCode             status,
+                             uint32_t                  data_count)
+{
+    if (descriptor != NULL) {
+        descriptor->status = status;
+    }
+    if (context_callback != NULL) {
+        context_callback(context,
+                         status,
+                         data_count,
+                         (I2C_GetCycleCount != NULL) ? I2C_GetCycleCount() : 0);
+    } else if (callback != NULL) {
+        callback(status);
     }
+}
+
+static void CompleteTransaction(I2CDeviceContext* device)
+{
+    I2CTransactionDescriptor* descriptor       = device->transaction.descriptor;
+    I2CCallback               callback         = device->transaction.callback;
+    I2CContextCallback        context_callback = device->transaction.context_callback;
+    void*                     context          = device->transaction.context;
+    I2CReturnCode             status           = device->transaction.status;
+    uint32_t                  transferred      = device->transaction.transferred;
+
+    device->busy = false;
+
+    // Issue the next queued descriptor before running the callback to keep the bus busy
+    I2CTransactionDescriptor* next        = PopQueuedDescriptor(device);
+    I2CReturnCode             next_status = (next != NULL) ? IssueDescriptor(device, next, false) :
+                                            I2C_OK;
+
+    ReportCompletion(descriptor, callback, context_callback, context, status, transferred);
+
+    while ((next != NULL) && (next_status != I2C_OK)) {
+        ReportCompletion(next,
+                         next->callback,
+                         next->context_callback,
+                         next->context,
+                         next_status,
+                         0);
+        next        = PopQueuedDescriptor(device);
+        next_status = (next != NULL) ? IssueDescriptor(device, next, false) : I2C_OK;
+    }
+}
+
+static void RestartDescriptor(I2CDeviceContext* device)
+{
+    I2CReturnCode ret;
+
+    if ((ret = StartDescriptor(device, device->transaction.descriptor)) != I2C_OK) {
+        device->transaction.status = ret;
+        CompleteTransaction(device);
+    }
+}
+
+static void RetryAfterArbitrationLoss(I2CDeviceContext* device)
+{
+    I2CRegisters* i2c_dev = device->i2c_dev;
+    uint8_t       retries = device->transaction.arbitration_retries;
+
+    ReleaseDMAC(device);
+    device->stats.arbitration_losses++;
+
+    if (retries >= I2C_ARBITRATION_RETRIES) {
+        device->transaction.status = I2C_ARBITRATION_LOST;
+        CompleteTransaction(device);
+        return;
+    }
+
+    // Drop what was written for the lost phase before starting the descriptor over
+    WriteRegister(device, &i2c_dev->Cmd,
+                  (I2C_CMD_CLEAR_FIFO << I2C_CMD_CMD_OFFSET) & I2C_CMD_CMD_MASK);
+    if (!WaitCmdIdle(device)) {
+        device->transaction.status = I2C_CMD_PENDING;
+        CompleteTransaction(device);
+        return;
+    }
+    device->transaction.arbitration_retries = retries + 1;
+
+    // Reissued by I2C_TimeoutTick, without backoff the controller holds the START until the
+    // winner's STOP. No tick reaches a polled transaction: it is reissued at once.
+    device->transaction.backoff_ticks = device->transaction.polled ? 0 :
+                                        (uint32_t) I2C_ARBITRATION_BACKOFF_TICKS << retries;
+    if (device->transaction.backoff_ticks == 0) {
+        RestartDescriptor(device);
+    }
+}
+
+// Called with the controller interrupt disabled, completes the descriptor with status
+static void AbortTransaction(I2CDeviceContext* device,
+                             I2CReturnCode     status)
+{
+    I2CRegisters* i2c_dev = device->i2c_dev;
+
+    // Abort the transaction, release the lines and empty the FIFO, the reset also clears
+    // Status and IntEn: no late CMPL for the aborted transaction
+    WriteRegister(device, &i2c_dev->Cmd,
+                  (I2C_CMD_RESET << I2C_CMD_CMD_OFFSET) & I2C_CMD_CMD_MASK);
+    device->shadow.IntEn    = 0;
+    device->deferred_status = 0;
+    ReleaseDMAC(device);
+    // Issued by CompleteTransaction: a queued descriptor needs the reset to be done
+    WaitCmdIdle(device);
+
+    device->transaction.status = status;
+    CompleteTransaction(device);
+}
+
+// Events already acked by the top half when deferred, acked here otherwise
+static void HandleStatus(I2CDeviceContext* device,
+                         uint32_t          status,
+                         bool              ack)
+{
+    I2CRegisters* i2c_dev = device->i2c_dev;
+
+    if (!device->busy) {
+        // Nothing in progress, e.g. events raised before an abort: nobody waits for them
+        if (ack && (status != 0)) {
+            WriteRegister(device, &i2c_dev->Status, status);
+        }
+        return;
+    }
+
+    if ((status & I2C_STATUS_ARBLOSE_MASK) && (device->transaction.role == I2C_MASTER)) {
+        // Another master won the bus, the phase did not complete
+        if (ack) {
+            WriteRegister(device, &i2c_dev->Status, status);
+        }
+        RetryAfterArbitrationLoss(device);
+        return;
+    }
+
+    if ((status & I2C_STATUS_CMPL_MASK)) {
+        I2CReturnCode ret = (status & I2C_STATUS_ADDRHIT_MASK) ? I2C_OK : I2C_ADDR_HIT_ERROR;
+        if (device->transaction.phases == I2C_CTRL_PHASE_STOP_MASK) {
+            // Bus released after a failed phase
+            ret = device->transaction.status;
+        } else if (!(device->transaction.phases & I2C_CTRL_PHASE_ADDR_MASK)) {
+            // Continued data phase: the target was addressed by a previous phase
+            ret = I2C_OK;
+        }
+        if ((ret == I2C_OK) &&
+            (device->transaction.dir == I2C_RX) &&
+            (!DMADataPath(device))) {
+            // The controller holds the bus when the FIFO is full: the tail fits in it
+            ReadAvailableData(device, device->config.fifo_size);
+        }
+        if (DMADataPath(device)) {
+            // The rest of the data phase was moved by the DMA
+            if ((device->transaction.dir == I2C_RX) &&
+                (device->transaction.crc_mode != I2C_CRC_NONE)) {
+                device->transaction.crc = Crc8(device->transaction.crc,
+                                               device->transaction.data,
+                                               device->transaction.remaining_data,
+                                               device->transaction.crc_polynomial);
+            }
+            SkipData(device, device->transaction.remaining_data);
+        }
+        if ((ret == I2C_OK) && RxCrcFailed(device)) {
+            ret = I2C_CRC_ERROR;
+        }
+        ReleaseDMAC(device);
+        // Write back the events read above to clear them
+        if (ack) {
+            WriteRegister(device, &i2c_dev->Status, status);
+        }
+        if (!StartNextPhase(device, ret)) {
+            CompleteTransaction(device);
+        }
+        return;
+    }
+
+    if (DMADataPath(device)) {
+        return;
+    }
+
+    if (device->transaction.dir == I2C_TX) {
+        WriteAvailableData(device, FifoSpace(device, I2C_TX, status));
+    } else {
+        ReadAvailableData(device, FifoSpace(device, I2C_RX, status));
+    }
+}
+
+static I2CReturnCode IssueScanProbe(I2CDeviceContext* device)
+{
+    // Queued descriptors keep their turn: the scan only takes an idle bus
+    if (device->busy || (device->queue.count != 0)) {
+        return EnqueueDescriptor(device, &device->scan.probe);
+    }
+    return IssueDescriptor(device, &device->scan.probe, false);
+}
+
+// A NACKed address completes after its ninth clock, a probe only times out on a held bus
+static void ScanProbeComplete(void*         context,
+                              I2CReturnCode status,
+                              uint32_t      data_count,
+                              uint32_t      timestamp)
+{
+    I2CDeviceContext*  device  = (I2CDeviceContext*) context;
+    I2CScanDescriptor* scan    = device->scan.descriptor;
+    uint16_t           address = device->scan.probe.address;
+
+    UNUSED(data_count);
+    UNUSED(timestamp);
+
+    if (status == I2C_OK) {
+        scan->presence[address / 8] |= (uint8_t) (1u << (address % 8));
+        scan->found++;
+    } else if (status == I2C_ADDR_HIT_ERROR) {
+        // Nothing at this address
+        status = I2C_OK;
+    }
+
+    if ((status == I2C_OK) && (address < scan->last_address)) {
+        device->scan.probe.address = address + 1;
+        if ((status = IssueScanProbe(device)) == I2C_OK) {
+            return;
+        }
+    }
+
+    device->scan.descriptor = NULL;
+    scan->status            = status;
+    ReportCompletion(NULL, NULL, scan->context_callback, scan->context, status, scan->found);
+}
+
+#if I2C_FEATURE_SLAVE
+static bool ValidSlaveDescriptor(I2CSlaveDescriptor* descriptor)
+{
+#if I2C_VALIDATION_LEVEL == I2C_VALIDATION_BASIC
+    return descriptor != NULL;
+#else
+    return !((descriptor == NULL) ||
+             (descriptor->mode >= I2C_SLAVE_UNSUPPORTED_MODE) ||
+             ((descriptor->rx_data == NULL) != (descriptor->rx_data_count == 0)) ||
+             ((descriptor->tx_data == NULL) != (descriptor->tx_data_count == 0)) ||
+             ((descriptor->mode == I2C_SLAVE_REGISTER_FILE) && (descriptor->rx_data == NULL)) ||
+             ((descriptor->addressing_mode == I2C_ADDRESSING_MODE_10_BIT) &&
+              (descriptor->address > I2C_ADDR_MAX_10BIT)) ||
+             ((descriptor->addressing_mode == I2C_ADDRESSING_MODE_7_BIT) &&
+              (descriptor->address > I2C_ADDR_MAX_7BIT)) ||
+             ((!I2C_FEATURE_10_BIT_ADDRESSING) &&
+              (descriptor->addressing_mode != I2C_ADDRESSING_MODE_7_BIT)));
+#endif
+}
+
+// Received bytes go straight from the FIFO to the registered buffer
+static void SlaveReceive(I2CDeviceContext* device,
+                         uint16_t          count)
+{
+    I2CSlaveDescriptor* descriptor = device->slave.descriptor;
+
+    while (count-- > 0) {
+        uint8_t byte = (uint8_t) ReadRegister(device, &device->i2c_dev->Data);
+
+        if (descriptor->mode == I2C_SLAVE_BUFFERS) {
+            if (device->slave.count < descriptor->rx_data_count) {
+                descriptor->rx_data[device->slave.count] = byte;
+                device->slave.stored++;
+            }
+        } else if (device->slave.general_call) {
+            // Not addressed to the register file: dropped
+        } else if (!device->slave.pointer_received) {
+            device->slave.offset           = byte % descriptor->rx_data_count;
+            device->slave.pointer_received = true;
+        } else {
+            descriptor->rx_data[device->slave.offset] = byte;
+            device->slave.offset = (device->slave.offset + 1) % descriptor->rx_data_count;
+            device->slave.stored++;
+        }
+        device->slave.count++;
+    }
+}
+
+// Transmitted bytes go straight from the registered buffer to the FIFO
+static void SlaveTransmit(I2CDeviceContext* device,
+                          uint16_t          count)
+{
+    I2CSlaveDescriptor* descriptor = device->slave.descriptor;
+
+    while (count-- > 0) {
+        uint8_t byte = I2C_SLAVE_TX_PADDING;
+
+        if (descriptor->mode == I2C_SLAVE_REGISTER_FILE) {
+            byte = descriptor->rx_data[(device->slave.offset + device->slave.count) %
+                                       descriptor->rx_data_count];
+        } else if (device->slave.count < descriptor->tx_data_count) {
+            byte = descriptor->tx_data[device->slave.count];
+        }
+        WriteRegister(device, &device->i2c_dev->Data, byte);
+        device->slave.count++;
+    }
+}
+
+static void StartSlaveTransfer(I2CDeviceContext* device,
+                               uint32_t          status)
+{
+    I2CRegisters* i2c_dev = device->i2c_dev;
+    uint32_t      dir     = (ReadRegister(device, &i2c_dev->Ctrl) & I2C_CTRL_DIR_MASK) >>
+                            I2C_CTRL_DIR_OFFSET;
+
+    device->slave.in_transfer      = true;
+    device->slave.general_call     = (status & I2C_STATUS_GENCALL_MASK) != 0;
+    device->slave.pointer_received = false;
+    device->slave.dir              = (dir == I2C_CTRL_DIR_SLAVE_TX) ? I2C_TX : I2C_RX;
+    device->slave.count            = 0;
+    device->slave.stored           = 0;
+
+    if (device->slave.dir == I2C_TX) {
+        // The FIFO is empty when addressed: fill it before the first data byte is clocked
+        SlaveTransmit(device, device->config.fifo_size);
+    }
+
+    // Half a FIFO of byte times to serve the FIFO before the controller stretches SCL
+    CommitRegister(device, &i2c_dev->IntEn, &device->shadow.IntEn,
+                   device->shadow.IntEn | I2C_INTEN_FIFOHALF_MASK);
+}
+
+static void FinishSlaveTransfer(I2CDeviceContext* device)
+{
+    I2CRegisters*       i2c_dev    = device->i2c_dev;
+    I2CSlaveDescriptor* descriptor = device->slave.descriptor;
+    I2CSlaveEvent       event      = I2C_SLAVE_RX_DONE;
+    uint16_t            data_count = 0;
+
+    // The controller counts the bytes of the transfer in DataCnt (modulo 256), the
+    // difference with the bytes moved is still in the FIFO
+    uint16_t transferred = (ReadRegister(device, &i2c_dev->Ctrl) & I2C_CTRL_DATACNT_MASK) >>
+                           I2C_CTRL_DATACNT_OFFSET;
+    uint16_t in_fifo = (transferred - device->slave.count) & I2C_CTRL_DATACNT_MASK;
+
+    if (device->slave.dir == I2C_RX) {
+        SlaveReceive(device, in_fifo);
+        data_count = device->slave.general_call ? device->slave.count : device->slave.stored;
+        event      = device->slave.general_call ? I2C_SLAVE_GENERAL_CALL :
+                     (device->slave.stored < device->slave.count) &&
+                     (descriptor->mode == I2C_SLAVE_BUFFERS) ? I2C_SLAVE_RX_OVERFLOW :
+                     I2C_SLAVE_RX_DONE;
+    } else {
+        // Bytes written ahead were not read by the master: drop them
+        data_count = device->slave.count - ((device->slave.count - transferred) &
+                                            I2C_CTRL_DATACNT_MASK);
+        WriteRegister(device, &i2c_dev->Cmd,
+                      (I2C_CMD_CLEAR_FIFO << I2C_CMD_CMD_OFFSET) & I2C_CMD_CMD_MASK);
+        if (descriptor->mode == I2C_SLAVE_REGISTER_FILE) {
+            device->slave.offset = (device->slave.offset + data_count) % descriptor->rx_data_count;
+        }
+        event = ((descriptor->mode == I2C_SLAVE_BUFFERS) &&
+                 (data_count > descriptor->tx_data_count)) ? I2C_SLAVE_TX_UNDERFLOW :
+                I2C_SLAVE_TX_DONE;
+    }
+
+    device->slave.in_transfer = false;
+    CommitRegister(device, &i2c_dev->IntEn, &device->shadow.IntEn,
+                   device->shadow.IntEn & ~I2C_INTEN_FIFOHALF_MASK);
+
+    if (descriptor->callback != NULL) {
+        descriptor->callback(event, data_count);
+    }
+}
+
+static void HandleSlaveStatus(I2CDeviceContext* device,
+                              uint32_t          status,
+                              bool              ack)
+{
+    I2CRegisters* i2c_dev   = device->i2c_dev;
+    bool          completed = false;
+
+    // STOP or repeated START of the transfer in progress, before a new address match
+    if (device->slave.in_transfer && (status & I2C_STATUS_CMPL_MASK)) {
+        FinishSlaveTransfer(device);
+        completed = true;
+    }
+    if (status & I2C_STATUS_ADDRHIT_MASK) {
+        StartSlaveTransfer(device, status);
+    }
+    if (device->slave.in_transfer) {
+        if (device->slave.dir == I2C_TX) {
+            SlaveTransmit(device, FifoSpace(device, I2C_TX, status));
+        } else {
+            SlaveReceive(device, FifoSpace(device, I2C_RX, status));
+        }
+        if ((!completed) && (status & I2C_STATUS_CMPL_MASK)) {
+            // Whole transfer between two interrupts
+            FinishSlaveTransfer(device);
+        }
+    }
+
+    // Write back the events read above to clear them
+    if (ack) {
+        WriteRegister(device, &i2c_dev->Status, status);
+    }
+}
+#endif
+
+// Top half: a single Status read, the events acked and the controller masked
+static void DeferStatus(I2CDeviceContext* device)
+{
+    I2CRegisters* i2c_dev = device->i2c_dev;
+
+    // Masked until I2C_ProcessDeferredIrq ran, the line is shared with the other controllers
+    if (device->deferred_status != 0) {
+        return;
+    }
+
+    uint32_t status = ReadRegister(device, &i2c_dev->Status);
+
+    if (!(status & device->shadow.IntEn)) {
+        return;
+    }
+
+    WriteRegister(device, &i2c_dev->Status, status);
+    WriteRegister(device, &i2c_dev->IntEn, 0);
+    device->deferred_status = status;
+    I2C_DeferIrq(i2c_dev);
+}
+
+#if I2C_FEATURE_DMA
+void I2C_DMACCallback(DMACReturnCode return_code)
+{
+    I2CDeviceContext* device = dmac_owner;
+
+    if ((device == NULL) || (!device->busy)) {
+        return;
+    }
+
+    // Owned by the bottom half: the deferred CMPL or ARBLOSE, the only events of the DMA data
+    // path, ends or restarts the data phase of this event
+    if (device->deferred_status != 0) {
+        return;
+    }
+
+    if (return_code == DMAC_TERMINAL_COUNT) {
+        if (device->transaction.dma_data == device->transaction.remaining_data) {
+            // Last transfer of the data phase, completed by CMPL
+            return;
+        }
+        // Next segment of the data phase, the controller stretches SCL until it is fed
+        SkipData(device, device->transaction.dma_data);
+        if ((SetupDMAChunk(device) == I2C_OK) &&
+            (DMAC_EnableChannel(HAL_DMAC, DMAC_CHANNEL_I2C) == DMAC_OK)) {
+            return;
+        }
+    }
+
+    // The data phase cannot complete: free the controller and the channel for the queue
+    DisableInterrupt(device->i2c_dev);
+    AbortTransaction(device, I2C_DMAC_ERROR);
+    RestoreInterrupt(device);
+}
+#endif
+
+I2CReturnCode I2C_Create(I2CRegisters* i2c_dev)
+{
+    if (i2c_dev == NULL) {
+        return I2C_INVALID_INPUT_DATA;
+    }
+
+    I2CDeviceContext* device = AllocateDeviceContext(i2c_dev);
+
+    if (device == NULL) {
+        return I2C_NO_DEVICE_CONTEXT_AVAILABLE;
+    }
+
+    ReleaseDMAC(device);
+    device->i2c_dev                      = i2c_dev;
+    device->transaction.remaining_data   = 0;
+    device->transaction.dma_data         = 0;
+    LoadData(device, NULL, 0);
+    device->transaction.callback         = NULL;
+    device->transaction.context_callback = NULL;
+    device->transaction.descriptor       = NULL;
+    device->busy                         = false;
+    device->queue.head                   = 0;
+    device->queue.count                  = 0;
+#if I2C_FEATURE_SLAVE
+    device->slave.descriptor             = NULL;
+    device->slave.in_transfer            = false;
+#endif
+    device->deferred_status              = 0;
+    device->scan.descriptor              = NULL;
+    device->stats.fifo_transactions      = 0;
+    device->stats.dma_transactions       = 0;
+    device->stats.dma_setup_cycles       = 0;
+    device->stats.fifo_byte_cycles       = 0;
+    device->stats.mmio_reads             = 0;
+    device->stats.mmio_writes            = 0;
+    device->stats.auto_dma_threshold     = I2C_AUTO_DMA_THRESHOLD;
+    device->stats.arbitration_losses     = 0;
+    device->stats.bus_recoveries         = 0;
+    device->stats.recovery_cycles        = 0;
+    ReadHWConfig(device);
+    ReadShadowRegisters(device);
+    return I2C_OK;
+}
+
+I2CReturnCode I2C_Destroy(I2CRegisters* i2c_dev)
+{
+    if (i2c_dev == NULL) {
+        return I2C_INVALID_INPUT_DATA;
+    }
+
+    I2CDeviceContext* device = FindDeviceContext(i2c_dev);
+
+    if (device == NULL) {
+        return I2C_DEVICE_NOT_REGISTERED;
+    }
+
+    ReleaseDMAC(device);
+    device->i2c_dev = NULL;
+    return I2C_OK;
+}
+
+I2CReturnCode I2C_GetConfig(I2CRegisters* i2c_dev,
+                            I2CConfig**   return_value)
+{
+    if ((i2c_dev == NULL) ||
+        (return_value == NULL)) {
+        return I2C_INVALID_INPUT_DATA;
+    }
+
+    I2CDeviceContext* device = FindDeviceContext(i2c_dev);
+
+    if (device == NULL) {
+        return I2C_DEVICE_NOT_REGISTERED;
+    }
+    *return_value = &device->config;
+    return I2C_OK;
+}
+
+I2CReturnCode I2C_GetStats(I2CRegisters* i2c_dev,
+                           I2CStats**    return_value)
+{
+    if ((i2c_dev == NULL) ||
+        (return_value == NULL)) {
+        return I2C_INVALID_INPUT_DATA;
+    }
+
+    I2CDeviceContext* device = FindDeviceContext(i2c_dev);
+
+    if (device == NULL) {
+        return I2C_DEVICE_NOT_REGISTERED;
+    }
+    *return_value = &device->stats;
+    return I2C_OK;
+}
+
+#if I2C_FEATURE_DMA
+I2CReturnCode I2C_Calibrate(I2CRegisters* i2c_dev)
+{
+    if (i2c_dev == NULL) {
+        return I2C_INVALID_INPUT_DATA;
+    }
+
+    I2CDeviceContext* device = FindDeviceContext(i2c_dev);
+
+    if (device == NULL) {
+        return I2C_DEVICE_NOT_REGISTERED;
+    }
+
+    if (I2C_GetCycleCount == NULL) {
+        return I2C_CYCLE_COUNTER_NOT_AVAILABLE;
+    }
+
+    if (!I2CEnabled(device)) {
+        return I2C_CONTROLLER_NOT_ENABLED;
+    }
+
+    if (device->busy || I2CCmdPending(device)) {
+        return I2C_CMD_PENDING;
+    }
+
+    if (dmac_owner != NULL) {
+        return I2C_DMAC_CHANNEL_BUSY;
+    }
+
+    uint8_t       scratch[16] = {0};
+    uint8_t       fifo_size   = device->config.fifo_size;
+    I2CReturnCode ret         = I2C_OK;
+
+    // DMA setup cost: channel and transfer programming, the channel stays disabled
+    device->transaction.dir            = I2C_TX;
+    device->transaction.remaining_data = fifo_size;
+    LoadData(device, scratch, fifo_size);
+
+    uint32_t start = I2C_GetCycleCount();
+
+    ret = SetupDMATransfer(device);
+
+    uint32_t dma_setup_cycles = I2C_GetCycleCount() - start;
+
+    device->transaction.remaining_data = 0;
+    LoadData(device, NULL, 0);
+    if (ret != I2C_OK) {
+        return ret;
+    }
+
+    // Per-byte cost of the FIFO path: fill the idle FIFO, then drop its content
+    start = I2C_GetCycleCount();
+    for (uint8_t i = 0; i < fifo_size; i++) {
+        WriteRegister(device, &i2c_dev->Data, scratch[i]);
+    }
+
+    uint32_t fifo_cycles = I2C_GetCycleCount() - start;
+
+    WriteRegister(device, &i2c_dev->Cmd,
+                  (I2C_CMD_CLEAR_FIFO << I2C_CMD_CMD_OFFSET) & I2C_CMD_CMD_MASK);
+    if (!WaitCmdIdle(device)) {
+        return I2C_CMD_PENDING;
+    }
+
+    device->stats.dma_setup_cycles = dma_setup_cycles;
+    device->stats.fifo_byte_cycles = (fifo_cycles / fifo_size) ? (fifo_cycles / fifo_size) : 1;
+
+    // DMA pays off once moving the data through the FIFO costs more than the DMA setup
+    uint32_t threshold = (dma_setup_cycles + device->stats.fifo_byte_cycles - 1) /
+                         device->stats.fifo_byte_cycles;
+
+    device->stats.auto_dma_threshold = (threshold > UINT16_MAX) ? UINT16_MAX :
+                                       (threshold == 0) ? 1 : (uint16_t) threshold;
+    return ret;
+}
+#endif
+
+I2CReturnCode I2C_ComputeTiming(uint32_t   scl_frequency,
+                                uint32_t   apb_clock,
+                                I2CTiming* timing)
+{
+    if ((timing == NULL) ||
+        (scl_frequency == 0) ||
+        (scl_frequency > I2C_FAST_MODE_PLUS_MAX_FREQUENCY) ||
+        (apb_clock < scl_frequency)) {
+        return I2C_INVALID_INPUT_DATA;
+    }
+
+    // Same steps as I2C_TIMING(), each intermediate value computed once
+    uint32_t period = I2C_TIMING_PERIOD(scl_frequency, apb_clock);
+    uint32_t ratio  = I2C_TIMING_RATIO(scl_frequency);
+    uint32_t tpm    = I2C_TIMING_TPM_FOR_LIMITS(scl_frequency, apb_clock, period, ratio);
+    uint32_t sp     = I2C_TIMING_SP_FOR_TPM(apb_clock, tpm);
+    uint32_t sudat  =
+        I2C_TIMING_FIELD(I2C_TIMING_CYCLES(I2C_SPEC_MIN_SUDAT(scl_frequency), apb_clock), tpm, sp);
+    uint32_t hddat =
+        I2C_TIMING_FIELD(I2C_TIMING_CYCLES(I2C_SPEC_MIN_HDDAT(scl_frequency), apb_clock), tpm, sp);
+    uint32_t sclhi =
+        I2C_TIMING_SCLHI_FOR_LIMITS(scl_frequency, apb_clock, period, tpm, sp, ratio);
+
+    if ((tpm > I2C_TIMING_TPM_MAX) ||
+        (sudat > I2C_TIMING_SUDAT_MAX) ||
+        (hddat > I2C_TIMING_HDDAT_MAX) ||
+        (sclhi > I2C_TIMING_SCLHI_MAX)) {
+        return I2C_TIMING_OUT_OF_RANGE;
+    }
+
+    timing->tpm           = (uint8_t) tpm;
+    timing->t_sp          = (uint8_t) sp;
+    timing->t_sudat       = (uint8_t) sudat;
+    timing->t_hddat       = (uint8_t) hddat;
+    timing->t_sclhi       = (uint16_t) sclhi;
+    timing->t_sclratio    = (uint8_t) ratio;
+    timing->scl_frequency = apb_clock / I2C_TIMING_SCL_PERIOD(tpm, sp, sclhi, ratio);
+    return I2C_OK;
+}
+
+I2CReturnCode I2C_SetupController(I2CRegisters* i2c_dev,
+                                  I2CSetupInfo* setup_info)
+{
+    if ((i2c_dev == NULL) ||
+        (setup_info == NULL) ||
+        (setup_info->mode >= I2C_UNSUPPORTED_MODE) ||
+        ((!I2C_FEATURE_FAST_MODES) && (setup_info->timing == NULL) &&
+         (setup_info->mode != I2C_STANDARD_MODE)) ||
+        ((!I2C_FEATURE_SLAVE) && (setup_info->role != I2C_MASTER)) ||
+        ((setup_info->timing != NULL) && (!ValidTiming(setup_info->timing)))) {
+        return I2C_INVALID_INPUT_DATA;
+    }
+
+    I2CDeviceContext* device = FindDeviceContext(i2c_dev);
+
+    if (device == NULL) {
+        return I2C_DEVICE_NOT_REGISTERED;
+    }
+
+    // Timing computed for the SCL frequency, or tuned for the mode at I2C_CLK
+    I2CTiming timing;
+
+    if (setup_info->timing != NULL) {
+        timing = *setup_info->timing;
+    } else {
+        GetModeTiming(setup_info->mode, &timing);
+    }
+
+    // Setup Timing Parameter Multiplier
+    CommitRegister(device, &i2c_dev->TPM, &device->shadow.TPM,
+                   (device->shadow.TPM & ~I2C_TPM_TPM_MASK) |
+                   ((timing.tpm << I2C_TPM_TPM_OFFSET) & I2C_TPM_TPM_MASK));
+
+    uint32_t setup = device->shadow.Setup &
+                     ~(I2C_SETUP_MASTER_MASK | I2C_SETUP_T_SP_MASK | I2C_SETUP_T_SUDAT_MASK |
+                       I2C_SETUP_T_HDDAT_MASK | I2C_SETUP_T_SCLHI_MASK |
+                       I2C_SETUP_T_SCLRATIO_MASK);
+
+    // Role, Timing Parameters and enable bit in a single write, none if unchanged
+    setup |= (setup_info->role << I2C_SETUP_MASTER_OFFSET) & I2C_SETUP_MASTER_MASK;
+    setup |= (timing.t_sp << I2C_SETUP_T_SP_OFFSET) & I2C_SETUP_T_SP_MASK;
+    setup |= (timing.t_sudat << I2C_SETUP_T_SUDAT_OFFSET) & I2C_SETUP_T_SUDAT_MASK;
+    setup |= (timing.t_hddat << I2C_SETUP_T_HDDAT_OFFSET) & I2C_SETUP_T_HDDAT_MASK;
+    setup |= (timing.t_sclhi << I2C_SETUP_T_SCLHI_OFFSET) & I2C_SETUP_T_SCLHI_MASK;
+    setup |= (timing.t_sclratio << I2C_SETUP_T_SCLRATIO_OFFSET) & I2C_SETUP_T_SCLRATIO_MASK;
+    setup |= (0x01 << I2C_SETUP_IICEN_OFFSET) & I2C_SETUP_IICEN_MASK;
+    CommitRegister(device, &i2c_dev->Setup, &device->shadow.Setup, setup);
+
+    return I2C_OK;
+}
+
+I2CReturnCode I2C_ShutdownController(I2CRegisters* i2c_dev)
+{
+    if (i2c_dev == NULL) {
+        return I2C_INVALID_INPUT_DATA;
+    }
+
+    I2CDeviceContext* device = FindDeviceContext(i2c_dev);
+
+    if (device == NULL) {
+        return I2C_DEVICE_NOT_REGISTERED;
+    }
+
+    // The external interrupt line is shared by all the controllers
+    if (!OtherDeviceEnabled(device)) {
+        DisableInterrupt(i2c_dev);
+    }
+    I2CDisable(device);
+    return I2C_OK;
+}
+
+I2CReturnCode I2C_LaunchTransaction(I2CRegisters*             i2c_dev,
+                                    I2CTransactionDescriptor* descriptor)
+{
+    I2CReturnCode ret = I2C_OK;
+
+    if ((i2c_dev == NULL) ||
+        (!ValidDescriptor(descriptor))) {
+        return I2C_INVALID_INPUT_DATA;
+    }
+
+    I2CDeviceContext* device = FindDeviceContext(i2c_dev);
+
+    if (device == NULL) {
+        return I2C_DEVICE_NOT_REGISTERED;
+    }
+
+    if ((ret = IssueDescriptor(device, descriptor, false)) != I2C_OK) {
+        return ret;
+    }
+
+    EnableInterrupt(i2c_dev, I2C_INTERRUPT_PRIORITY);
+
+    return ret;
+}
+
+I2CReturnCode I2C_PrepareTransaction(I2CRegisters*             i2c_dev,
+                                     I2CTransactionDescriptor* descriptor,
+                                     I2CPreparedTransaction*   prepared)
+{
+    if ((i2c_dev == NULL) ||
+        (prepared == NULL) ||
+        (!ValidDescriptor(descriptor))) {
+        return I2C_INVALID_INPUT_DATA;
+    }
+
+    I2CDeviceContext* device = FindDeviceContext(i2c_dev);
+
+    if (device == NULL) {
+        return I2C_DEVICE_NOT_REGISTERED;
+    }
+
+    PrepareDescriptor(device, descriptor, prepared);
+    return I2C_OK;
+}
+
+// No validation nor register image computation: see I2C_PrepareTransaction
+I2CReturnCode I2C_LaunchPreparedTransaction(const I2CPreparedTransaction* prepared)
+{
+    I2CReturnCode ret = I2C_OK;
+
+    if ((prepared == NULL) || (prepared->descriptor == NULL)) {
+        return I2C_INVALID_INPUT_DATA;
+    }
+
+    I2CDeviceContext* device = FindDeviceContext(prepared->i2c_dev);
+
+    if (device == NULL) {
+        return I2C_DEVICE_NOT_REGISTERED;
+    }
+
+    if ((ret = IssuePrepared(device, prepared, false)) != I2C_OK) {
+        return ret;
+    }
+
+    EnableInterrupt(prepared->i2c_dev, I2C_INTERRUPT_PRIORITY);
+
+    return ret;
+}
+
+I2CReturnCode I2C_QueueTransaction(I2CRegisters*             i2c_dev,
+                                   I2CTransactionDescriptor* descriptor)
+{
+    I2CReturnCode ret = I2C_OK;
+
+    if ((i2c_dev == NULL) ||
+        (!ValidDescriptor(descriptor))) {
+        return I2C_INVALID_INPUT_DATA;
+    }
+
+    I2CDeviceContext* device = FindDeviceContext(i2c_dev);
+
+    if (device == NULL) {
+        return I2C_DEVICE_NOT_REGISTERED;
+    }
+
+    if (!I2CEnabled(device)) {
+        return I2C_CONTROLLER_NOT_ENABLED;
+    }
+
+    // The IRQ handler pops the queue: keep it out while the queue is updated
+    DisableInterrupt(i2c_dev);
+
+    if (!device->busy) {
+        ret = IssueDescriptor(device, descriptor, false);
+    } else {
+        ret = EnqueueDescriptor(device, descriptor);
+    }
+
+    EnableInterrupt(i2c_dev, I2C_INTERRUPT_PRIORITY);
+
+    return ret;
+}
+
+I2CReturnCode I2C_PollTransaction(I2CRegisters*             i2c_dev,
+                                  I2CTransactionDescriptor* descriptor,
+                                  uint32_t                  poll_budget)
+{
+    I2CReturnCode ret = I2C_OK;
+
+    if ((i2c_dev == NULL) ||
+        (!ValidDescriptor(descriptor))) {
+        return I2C_INVALID_INPUT_DATA;
+    }
+
+    I2CDeviceContext* device = FindDeviceContext(i2c_dev);
+
+    if (device == NULL) {
+        return I2C_DEVICE_NOT_REGISTERED;
+    }
+
+    if (device->busy) {
+        return I2C_CMD_PENDING;
+    }
+
+    if ((ret = IssueDescriptor(device, descriptor, true)) != I2C_OK) {
+        return ret;
+    }
+
+    // Same Status processing as the IRQ handler, one Status read per poll
+    while (device->busy) {
+        if (poll_budget == 0) {
+            // Abort the transaction and release the bus, the reset also clears IntEn
+            WriteRegister(device, &i2c_dev->Cmd,
+                          (I2C_CMD_RESET << I2C_CMD_CMD_OFFSET) & I2C_CMD_CMD_MASK);
+            device->shadow.IntEn = 0;
+            device->transaction.status = I2C_POLL_TIMEOUT;
+            CompleteTransaction(device);
+            break;
+        }
+        poll_budget--;
+        HandleStatus(device, ReadRegister(device, &i2c_dev->Status), true);
+    }
+
+    return descriptor->status;
+}
+
+#if I2C_FEATURE_SLAVE
+I2CReturnCode I2C_StartSlave(I2CRegisters*       i2c_dev,
+                             I2CSlaveDescriptor* descriptor)
+{
+    if ((i2c_dev == NULL) ||
+        (!ValidSlaveDescriptor(descriptor))) {
+        return I2C_INVALID_INPUT_DATA;
+    }
+
+    I2CDeviceContext* device = FindDeviceContext(i2c_dev);
+
+    if (device == NULL) {
+        return I2C_DEVICE_NOT_REGISTERED;
+    }
+
+    if (!I2CEnabled(device)) {
+        return I2C_CONTROLLER_NOT_ENABLED;
+    }
+
+    if (device->shadow.Setup & I2C_SETUP_MASTER_MASK) {
+        return I2C_WRONG_ROLE;
+    }
+
+    if (device->busy || device->slave.in_transfer) {
+        return I2C_CMD_PENDING;
+    }
+
+    // Keep the IRQ handler out while the slave state is replaced
+    DisableInterrupt(i2c_dev);
+
+    // Own address and addressing mode, matched by the controller to raise ADDRHIT
+    CommitRegister(device, &i2c_dev->Addr, &device->shadow.Addr,
+                   (device->shadow.Addr & ~I2C_ADDR_ADDR_MASK) |
+                   ((descriptor->address << I2C_ADDR_ADDR_OFFSET) & I2C_ADDR_ADDR_MASK));
+#if I2C_FEATURE_10_BIT_ADDRESSING
+    CommitRegister(device, &i2c_dev->Setup, &device->shadow.Setup,
+                   (device->shadow.Setup & ~I2C_SETUP_ADDRESSING_MASK) |
+                   ((descriptor->addressing_mode << I2C_SETUP_ADDRESSING_OFFSET) &
+                    I2C_SETUP_ADDRESSING_MASK));
+#endif
+    WriteRegister(device, &i2c_dev->Cmd,
+                  (I2C_CMD_CLEAR_FIFO << I2C_CMD_CMD_OFFSET) & I2C_CMD_CMD_MASK);
+
+    device->slave.descriptor  = descriptor;
+    device->slave.in_transfer = false;
+    device->slave.offset      = 0;
+
+    // The FIFO interrupt is only enabled while addressed
+    CommitRegister(device, &i2c_dev->IntEn, &device->shadow.IntEn,
+                   (device->shadow.IntEn & ~(I2C_INTEN_FIFOHALF_MASK |
+                                             I2C_INTEN_FIFOFULL_MASK |
+                                             I2C_INTEN_FIFOEMPTY_MASK)) |
+                   I2C_INTEN_ADDRHIT_MASK | I2C_INTEN_CMPL_MASK);
+
+    EnableInterrupt(i2c_dev, I2C_INTERRUPT_PRIORITY);
+
+    return I2C_OK;
+}
+
+I2CReturnCode I2C_StopSlave(I2CRegisters* i2c_dev)
+{
+    if (i2c_dev == NULL) {
+        return I2C_INVALID_INPUT_DATA;
+    }
+
+    I2CDeviceContext* device = FindDeviceContext(i2c_dev);
+
+    if (device == NULL) {
+        return I2C_DEVICE_NOT_REGISTERED;
+    }
+
+    CommitRegister(device, &i2c_dev->IntEn, &device->shadow.IntEn,
+                   device->shadow.IntEn & ~(I2C_INTEN_ADDRHIT_MASK |
+                                            I2C_INTEN_CMPL_MASK |
+                                            I2C_INTEN_FIFOHALF_MASK |
+                                            I2C_INTEN_FIFOFULL_MASK |
+                                            I2C_INTEN_FIFOEMPTY_MASK));
+    device->slave.descriptor  = NULL;
+    device->slave.in_transfer = false;
+
+    return I2C_OK;
+}
+#endif
+
+I2CReturnCode I2C_RecoverBus(I2CRegisters* i2c_dev)
+{
+    I2CReturnCode ret = I2C_OK;
+
+    if (i2c_dev == NULL) {
+        return I2C_INVALID_INPUT_DATA;
+    }
+
+    I2CDeviceContext* device = FindDeviceContext(i2c_dev);
+
+    if (device == NULL) {
+        return I2C_DEVICE_NOT_REGISTERED;
+    }
+
+    uint32_t start = (I2C_GetCycleCount != NULL) ? I2C_GetCycleCount() : 0;
+
+    DisableInterrupt(i2c_dev);
+
+    // Release the lines driven by the controller, the reset also clears IntEn. A status not
+    // processed yet belongs to the aborted transaction, not to the next queued one.
+    WriteRegister(device, &i2c_dev->Cmd,
+                  (I2C_CMD_RESET << I2C_CMD_CMD_OFFSET) & I2C_CMD_CMD_MASK);
+    device->shadow.IntEn    = 0;
+    device->deferred_status = 0;
+    ReleaseDMAC(device);
+    WaitCmdIdle(device);
+
+    uint32_t status = ReadRegister(device, &i2c_dev->Status);
+
+    if (!(status & I2C_STATUS_LINESCL_MASK)) {
+        // A slave is stretching SCL: no pulse can be driven on it, only a power cycle helps
+        device->stats.bus_recoveries++;
+        ret = I2C_BUS_HANG;
+    } else if (!(status & I2C_STATUS_LINESDA_MASK)) {
+        // A slave is holding SDA low: clock it out of the byte it is sending
+        uint8_t pulses = 0;
+
+        device->stats.bus_recoveries++;
+        while ((I2C_PulseSCL != NULL) &&
+               (pulses < I2C_BUS_RECOVERY_PULSES) &&
+               (!(status & I2C_STATUS_LINESDA_MASK))) {
+            I2C_PulseSCL(i2c_dev);
+            pulses++;
+            status = ReadRegister(device, &i2c_dev->Status);
+        }
+        ret = (status & I2C_STATUS_LINESDA_MASK) ? I2C_OK : I2C_BUS_HANG;
+    }
+    if (I2C_GetCycleCount != NULL) {
+        device->stats.recovery_cycles = I2C_GetCycleCount() - start;
+    }
+
+    // The transaction in progress, if any, was aborted by the reset
+    if (device->busy) {
+        device->transaction.status = I2C_BUS_HANG;
+        CompleteTransaction(device);
+    }
+
+    RestoreInterrupt(device);
+
+    return ret;
+}
+
+I2CReturnCode I2C_ScanBus(I2CRegisters*      i2c_dev,
+                          I2CScanDescriptor* descriptor)
+{
+    I2CReturnCode ret = I2C_OK;
+
+    if ((i2c_dev == NULL) ||
+        (descriptor == NULL) ||
+        (descriptor->first_address > descriptor->last_address) ||
+        (descriptor->last_address > I2C_ADDR_MAX_7BIT)) {
+        return I2C_INVALID_INPUT_DATA;
+    }
+
+    I2CDeviceContext* device = FindDeviceContext(i2c_dev);
+
+    if (device == NULL) {
+        return I2C_DEVICE_NOT_REGISTERED;
+    }
+
+    if (!I2CEnabled(device)) {
+        return I2C_CONTROLLER_NOT_ENABLED;
+    }
+
+    if (!(device->shadow.Setup & I2C_SETUP_MASTER_MASK)) {
+        return I2C_WRONG_ROLE;
+    }
+
+    if (device->scan.descriptor != NULL) {
+        return I2C_CMD_PENDING;
+    }
+
+    for (uint8_t i = 0; i < I2C_SCAN_MAP_SIZE; i++) {
+        descriptor->presence[i] = 0;
+    }
+    descriptor->found = 0;
+
+    device->scan.probe.type             = I2C_SIMPLE_TRANSACTION;
+    device->scan.probe.direction        = I2C_TX;
+    device->scan.probe.addressing_mode  = I2C_ADDRESSING_MODE_7_BIT;
+    device->scan.probe.address          = descriptor->first_address;
+    device->scan.probe.data_path        = I2C_USE_FIFO;
+    device->scan.probe.data             = NULL;
+    device->scan.probe.data_count       = 0;
+    device->scan.probe.segments         = NULL;
+    device->scan.probe.segment_count    = 0;
+    device->scan.probe.rx_data          = NULL;
+    device->scan.probe.rx_data_count    = 0;
+    device->scan.probe.callback         = NULL;
+    device->scan.probe.context_callback = ScanProbeComplete;
+    device->scan.probe.context          = device;
+    device->scan.probe.dma_priority     = I2C_DMA_PRIORITY_DEFAULT;
+    device->scan.probe.dma_burst_size   = I2C_DMA_BURST_SIZE_AUTO;
+    device->scan.probe.crc              = I2C_CRC_NONE;
+    device->scan.probe.crc_polynomial   = 0;
+    device->scan.probe.timeout          = descriptor->probe_timeout;
+
+    // The IRQ handler chains the probes: keep it out until the first one is on the bus
+    DisableInterrupt(i2c_dev);
+
+    device->scan.descriptor = descriptor;
+    if ((ret = IssueScanProbe(device)) != I2C_OK) {
+        device->scan.descriptor = NULL;
+    }
+
+    EnableInterrupt(i2c_dev, I2C_INTERRUPT_PRIORITY);
+
+    return ret;
+}
+
+void ExternalInterrupts_I2cIrqHandler(void)
+{
+    // The external interrupt line is shared by all the controllers
+    for (uint8_t i = 0; i < I2C_MAX_DEVICES; i++) {
+        if (i2c_devices[i].i2c_dev != NULL) {
+            I2C_DeviceIrqHandler(i2c_devices[i].i2c_dev);
+        }
+    }
+}
+
+I2CReturnCode I2C_DeviceIrqHandler(I2CRegisters* i2c_dev)
+{
+    if (i2c_dev == NULL) {
+        return I2C_INVALID_INPUT_DATA;
+    }
+
+    I2CDeviceContext* device = FindDeviceContext(i2c_dev);
+
+    if (device == NULL) {
+        return I2C_DEVICE_NOT_REGISTERED;
+    }
+
+    if (I2C_DeferIrq != NULL) {
+        DeferStatus(device);
+        return I2C_OK;
+    }
+
+#if I2C_FEATURE_SLAVE
+    if (device->slave.descriptor != NULL) {
+        HandleSlaveStatus(device, ReadRegister(device, &i2c_dev->Status), true);
+        return I2C_OK;
+    }
+#endif
+
+    // Polled transactions are completed by I2C_PollTransaction
+    if (!device->transaction.polled) {
+        HandleStatus(device, ReadRegister(device, &i2c_dev->Status), true);
+    }
+    return I2C_OK;
+}
+
+void I2C_TimeoutTick(void)
+{
+    for (uint8_t i = 0; i < I2C_MAX_DEVICES; i++) {
+        I2CDeviceContext* device = &i2c_devices[i];
+
+        // Polled transactions are completed by I2C_PollTransaction. Owned by the bottom half
+        // until it is done: the deadline and the backoff are aged from the next tick.
+        if ((device->i2c_dev == NULL) || (!device->busy) || device->transaction.polled ||
+            (device->deferred_status != 0)) {
+            continue;
+        }
+
+        // The deadline covers the whole descriptor, the arbitration retries included
+        if ((device->transaction.ticks_left != 0) && (--device->transaction.ticks_left == 0)) {
+            // Keep the IRQ handler out while the transaction is torn down
+            DisableInterrupt(device->i2c_dev);
+            AbortTransaction(device, I2C_TRANSACTION_TIMEOUT);
+            RestoreInterrupt(device);
+        } else if ((device->transaction.backoff_ticks != 0) &&
+                   (--device->transaction.backoff_ticks == 0)) {
+            DisableInterrupt(device->i2c_dev);
+            RestartDescriptor(device);
+            RestoreInterrupt(device);
+        }
+    }
+}
+
+I2CReturnCode I2C_ProcessDeferredIrq(I2CRegisters* i2c_dev)
+{
+    if (i2c_dev == NULL) {
+        return I2C_INVALID_INPUT_DATA;
+    }
+
+    I2CDeviceContext* device = FindDeviceContext(i2c_dev);
+
+    if (device == NULL) {
+        return I2C_DEVICE_NOT_REGISTERED;
+    }
+
+    uint32_t status = device->deferred_status;
+
+    if (status == 0) {
+        return I2C_OK;
+    }
+
+#if I2C_FEATURE_SLAVE
+    if (device->slave.descriptor != NULL) {
+        HandleSlaveStatus(device, status, false);
+    } else if (!device->transaction.polled) {
+        HandleStatus(device, status, false);
+    }
+#else
+    if (!device->transaction.polled) {
+        HandleStatus(device, status, false);
+    }
+#endif
+
+    // Unmask the interrupts left enabled by the handlers, kept in the shadow meanwhile. The
+    // transaction is handed back to the tick and the DMAC once the shadow is written.
+    DisableInterrupt(i2c_dev);
+    WriteRegister(device, &i2c_dev->IntEn, device->shadow.IntEn);
+    device->deferred_status = 0;
+    RestoreInterrupt(device);
+
     return I2C_OK;
 }
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) TheDevHuts, 2022.
+ * All rights reserved. Permission to use, copy, modify, distribute in any
+ * form or by any means or store in any database or retrieval system any
+ * parts of this copyrighted work is forbidden.
+ * Contact TheDevHuts (contact@thedevhuts.com) for licensing agreement
+ * opportunities.
+ *
+ * Contributor: Julien Gros
+ *
+ */
+
+#include "CppUTestExt/MockSupport_c.h"
+#include "I2CMock.h"
+#include "task.h"
+
+static uint32_t      transfer_ticks;
+static uint32_t      transfer_count;
+static I2CReturnCode statuses[I2C_MOCK_MAX_TRANSFERS];
+
+// Transfer on the bus, a scan being reported like a transaction
+static bool                      busy;
+static I2CTransactionDescriptor* descriptor;
+static I2CReturnCode             status;
+static TickType_t                launch_tick;
+static uint32_t                  ticks_left; // Of the deadline, 0 for none
+static I2CContextCallback        context_callback;
+static void*                     context;
+
+static void Complete(I2CReturnCode completion_status)
+{
+    busy = false;
+    if (descriptor != NULL) {
+        descriptor->status = completion_status;
+    }
+    context_callback(context, completion_status, 0, 0);
+}
+
+static void StartTransfer(I2CTransactionDescriptor* transfer_descriptor,
+                          uint32_t                  timeout,
+                          I2CContextCallback        callback,
+                          void*                     callback_context)
+{
+    descriptor       = transfer_descriptor;
+    status           = (transfer_count < I2C_MOCK_MAX_TRANSFERS) ?
+                       statuses[transfer_count] : I2C_OK;
+    launch_tick      = xTaskGetTickCount();
+    ticks_left       = timeout;
+    context_callback = callback;
+    context          = callback_context;
+    busy             = true;
+    transfer_count++;
+}
+
+void I2CMock_Reset(void)
+{
+    transfer_ticks = 1;
+    transfer_count = 0;
+    busy           = false;
+    for (uint32_t i = 0; i < I2C_MOCK_MAX_TRANSFERS; i++) {
+        statuses[i] = I2C_OK;
+    }
+}
+
+void I2CMock_SetTransferTicks(uint32_t ticks)
+{
+    transfer_ticks = ticks;
+}
+
+void I2CMock_FailTransfer(uint32_t      transfer,
+                          I2CReturnCode transfer_status)
+{
+    if (transfer < I2C_MOCK_MAX_TRANSFERS) {
+        statuses[transfer] = transfer_status;
+    }
+}
+
+void I2CMock_Interrupts(void)
+{
+    if ((!busy) || (transfer_ticks == 0) || (xTaskGetTickCount() - launch_tick < transfer_ticks)) {
+        return;
+    }
+    Complete(status);
+}
+
+I2CReturnCode I2C_SetupController(I2CRegisters* i2c_dev,
+                                  I2CSetupInfo* setup_info)
+{
+    mock_c()->actualCall("I2C_SetupController")
+    ->withPointerParameters("i2c_dev", i2c_dev)
+    ->withParameterOfType("I2CSetupInfo*", "setup_info", setup_info);
+    return (I2CReturnCode) mock_c()->returnValue().value.intValue;
+}
+
+I2CReturnCode I2C_LaunchTransaction(I2CRegisters*             i2c_dev,
+                                    I2CTransactionDescriptor* transaction_descriptor)
+{
+    mock_c()->actualCall("I2C_LaunchTransaction")
+    ->withPointerParameters("i2c_dev", i2c_dev)
+    ->withPointerParameters("descriptor", transaction_descriptor)
+    ->withUnsignedIntParameters("timeout", transaction_descriptor->timeout);
+
+    I2CReturnCode ret = (I2CReturnCode) mock_c()->returnValue().value.intValue;
+
+    if (ret == I2C_OK) {
+        StartTransfer(transaction_descriptor,
+                      transaction_descriptor->timeout,
+                      transaction_descriptor->context_callback,
+                      transaction_descriptor->context);
+    }
+    return ret;
+}
+
+// Run as one transfer, the deadline covering all the probes
+I2CReturnCode I2C_ScanBus(I2CRegisters*      i2c_dev,
+                          I2CScanDescriptor* scan_descriptor)
+{
+    mock_c()->actualCall("I2C_ScanBus")
+    ->withPointerParameters("i2c_dev", i2c_dev)
+    ->withPointerParameters("descriptor", scan_descriptor)
+    ->withUnsignedIntParameters("probe_timeout", scan_descriptor->probe_timeout);
+
+    I2CReturnCode ret = (I2CReturnCode) mock_c()->returnValue().value.intValue;
+
+    if (ret == I2C_OK) {
+        StartTransfer(NULL,
+                      (scan_descriptor->last_address - scan_descriptor->first_address + 1) *
+                      scan_descriptor->probe_timeout,
+                      scan_descriptor->context_callback,
+                      scan_descriptor->context);
+    }
+    return ret;
+}
+
+// Like the HAL, completes the aborted transfer from the caller, a task
+I2CReturnCode I2C_RecoverBus(I2CRegisters* i2c_dev)
+{
+    mock_c()->actualCall("I2C_RecoverBus")
+    ->withPointerParameters("i2c_dev", i2c_dev);
+
+    I2CReturnCode ret = (I2CReturnCode) mock_c()->returnValue().value.intValue;
+
+    if (busy) {
+        Complete(I2C_BUS_HANG);
+    }
+    return ret;
+}
+
+void I2C_TimeoutTick(void)
+{
+    if ((!busy) || (ticks_left == 0)) {
+        return;
+    }
+    if (--ticks_left == 0) {
+        Complete(I2C_TRANSACTION_TIMEOUT);
+    }
+}
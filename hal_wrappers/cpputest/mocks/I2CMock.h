@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) TheDevHuts, 2022.
+ * All rights reserved. Permission to use, copy, modify, distribute in any
+ * form or by any means or store in any database or retrieval system any
+ * parts of this copyrighted work is forbidden.
+ * Contact TheDevHuts (contact@thedevhuts.com) for licensing agreement
+ * opportunities.
+ *
+ * Contributor: Julien Gros
+ *
+ */
+
+#ifndef __I2C_MOCK_H
+#define __I2C_MOCK_H
+
+#include "FreeRTOS.h"
+#include "I2C.h"
+
+#define I2C_MOCK_MAX_TRANSFERS 64 // Transfers whose status can be set, the next ones end OK
+
+// The HAL calls of the wrapper are mock_c() expectations: I2C_SetupController,
+// I2C_LaunchTransaction, I2C_ScanBus and I2C_RecoverBus. A launch or a scan returning I2C_OK then
+// runs on a fake bus, completed from RTOSMock_InterruptHook after its bus time, its deadline being
+// aged by I2C_TimeoutTick like in the HAL.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void I2CMock_Reset(void);
+
+// Ticks on the bus of every transfer, 0: the transfers never end
+void I2CMock_SetTransferTicks(uint32_t ticks);
+
+// Status of the transfer-th transfer since the reset, I2C_OK by default
+void I2CMock_FailTransfer(uint32_t      transfer,
+                          I2CReturnCode status);
+
+// Called at each tick, from RTOSMock_InterruptHook
+void I2CMock_Interrupts(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __I2C_MOCK_H
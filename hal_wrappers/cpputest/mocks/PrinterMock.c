@@ -0,0 +1,22 @@
+/*
+ * Copyright (c) TheDevHuts, 2022.
+ * All rights reserved. Permission to use, copy, modify, distribute in any
+ * form or by any means or store in any database or retrieval system any
+ * parts of this copyrighted work is forbidden.
+ * Contact TheDevHuts (contact@thedevhuts.com) for licensing agreement
+ * opportunities.
+ *
+ * Contributor: Julien Gros
+ *
+ */
+
+#include "Printer.h"
+
+// The error traces of the wrapper are not checked
+void Printer_Printf(TickType_t  timeout,
+                    const char* format,
+                    ...)
+{
+    UNUSED(timeout);
+    UNUSED(format);
+}
@@ -0,0 +1,555 @@
+/*
+ * Copyright (c) TheDevHuts, 2022.
+ * All rights reserved. Permission to use, copy, modify, distribute in any
+ * form or by any means or store in any database or retrieval system any
+ * parts of this copyrighted work is forbidden.
+ * Contact TheDevHuts (contact@thedevhuts.com) for licensing agreement
+ * opportunities.
+ *
+ * Contributor: Julien Gros
+ *
+ */
+
+#include "event_groups.h"
+#include "queue.h"
+#include "RTOSMock.h"
+#include "semphr.h"
+#include <string.h>
+#include <ucontext.h>
+
+#define RTOS_MOCK_MAX_TASKS        16
+#define RTOS_MOCK_MAX_SEMAPHORES   4
+#define RTOS_MOCK_MAX_QUEUES       4
+#define RTOS_MOCK_MAX_EVENT_GROUPS 4
+#define RTOS_MOCK_STACK_SIZE       (64 * 1024)
+
+typedef enum {
+    RTOS_MOCK_TASK_DELETED,
+    RTOS_MOCK_TASK_READY,
+    RTOS_MOCK_TASK_WAIT_SEMAPHORE,
+    RTOS_MOCK_TASK_WAIT_NOTIFY,
+    RTOS_MOCK_TASK_DELAYED
+} RTOSMockTaskState;
+
+typedef struct {
+    TaskHandle_t handle;
+    UBaseType_t  priority;
+    bool         notified;     // Notification pending
+    uint32_t     notify_value; // Count of xTaskNotifyGive or value of xTaskNotifyFromISR
+} RTOSMockTask;
+
+typedef struct {
+    UBaseType_t count;
+    UBaseType_t max_count;
+} RTOSMockSemaphore;
+
+// Never blocks: a full queue refuses the item, an empty one has nothing to receive
+typedef struct {
+    uint8_t*    storage;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+} RTOSMockQueue;
+
+void (* RTOSMock_InterruptHook)(void) = NULL;
+void (* RTOSMock_TickHook)(void)      = NULL;
+
+static TickType_t        tick_count;
+static RTOSMockTask      tasks[RTOS_MOCK_MAX_TASKS];
+static uint8_t           task_count;
+static RTOSMockTask*     current_task;
+static RTOSMockSemaphore semaphores[RTOS_MOCK_MAX_SEMAPHORES];
+static uint8_t           semaphore_count;
+static RTOSMockQueue     queues[RTOS_MOCK_MAX_QUEUES];
+static uint8_t           queue_count;
+static EventBits_t       event_groups[RTOS_MOCK_MAX_EVENT_GROUPS];
+static uint8_t           event_group_count;
+
+// The task created by xTaskCreateStatic runs on task_stack, the test being the current client
+static RTOSMockTask*      created_task;
+static TaskFunction_t     task_function;
+static void*              task_parameters;
+static RTOSMockTaskState  task_state;
+static RTOSMockSemaphore* task_semaphore; // Waited on in RTOS_MOCK_TASK_WAIT_SEMAPHORE
+static TickType_t         task_wake_tick; // End of the notification wait or of the delay
+static bool               task_forever;   // RTOS_MOCK_TASK_WAIT_NOTIFY without timeout
+static TickType_t         delay_ticks;
+static bool               in_interrupt;   // Running RTOSMock_InterruptHook or RTOSMock_TickHook
+static uint32_t           isr_calls_from_tasks;
+static ucontext_t         task_context;
+static ucontext_t         test_context;
+static uint8_t            task_stack[RTOS_MOCK_STACK_SIZE] __attribute__((aligned(16)));
+
+static RTOSMockTask* FindTask(TaskHandle_t handle)
+{
+    for (uint8_t i = 0; i < task_count; i++) {
+        if (tasks[i].handle == handle) {
+            return &tasks[i];
+        }
+    }
+    if (task_count == RTOS_MOCK_MAX_TASKS) {
+        return NULL;
+    }
+    tasks[task_count].handle       = handle;
+    tasks[task_count].priority     = 0;
+    tasks[task_count].notified     = false;
+    tasks[task_count].notify_value = 0;
+
+    return &tasks[task_count++];
+}
+
+static void TaskEntry(void)
+{
+    task_function(task_parameters);
+    task_state = RTOS_MOCK_TASK_DELETED;
+    swapcontext(&task_context, &test_context);
+}
+
+static void RunCreatedTask(void)
+{
+    RTOSMockTask* test_task = current_task;
+
+    current_task = created_task;
+    swapcontext(&test_context, &task_context);
+    current_task = test_task;
+}
+
+// Called by the created task, back to the test until the scheduler makes it ready again
+static void BlockCreatedTask(RTOSMockTaskState state)
+{
+    task_state = state;
+    swapcontext(&task_context, &test_context);
+}
+
+static void Tick(void)
+{
+    tick_count++;
+    in_interrupt = true;
+    if (RTOSMock_InterruptHook != NULL) {
+        RTOSMock_InterruptHook();
+    }
+    if (RTOSMock_TickHook != NULL) {
+        RTOSMock_TickHook();
+    }
+    in_interrupt = false;
+    if (((task_state == RTOS_MOCK_TASK_WAIT_NOTIFY) && (!task_forever) &&
+         (tick_count == task_wake_tick)) ||
+        ((task_state == RTOS_MOCK_TASK_DELAYED) && (tick_count == task_wake_tick))) {
+        task_state = RTOS_MOCK_TASK_READY;
+    }
+}
+
+// The created task runs whenever it is ready, the ticks age otherwise. Returns once waiter is
+// notified or after timeout ticks, portMAX_DELAY: once the created task has nothing left to do.
+static void Schedule(TickType_t    timeout,
+                     RTOSMockTask* waiter)
+{
+    TickType_t until = tick_count + timeout;
+
+    while (1) {
+        if (task_state == RTOS_MOCK_TASK_READY) {
+            RunCreatedTask();
+            continue;
+        }
+        if ((waiter != NULL) && waiter->notified) {
+            return;
+        }
+        if (timeout == portMAX_DELAY) {
+            if ((task_state == RTOS_MOCK_TASK_WAIT_SEMAPHORE) ||
+                (task_state == RTOS_MOCK_TASK_DELETED)) {
+                return;
+            }
+        } else if (tick_count == until) {
+            return;
+        }
+        Tick();
+    }
+}
+
+void RTOSMock_Reset(void)
+{
+    RTOSMock_InterruptHook = NULL;
+    RTOSMock_TickHook      = NULL;
+    tick_count             = 0;
+    task_count             = 0;
+    semaphore_count        = 0;
+    queue_count            = 0;
+    event_group_count      = 0;
+    created_task           = NULL;
+    task_state             = RTOS_MOCK_TASK_DELETED;
+    delay_ticks            = 0;
+    in_interrupt           = false;
+    isr_calls_from_tasks   = 0;
+    current_task           = FindTask(MOCK_CLIENT_TASK(0));
+}
+
+void RTOSMock_SetCurrentTask(TaskHandle_t task,
+                             UBaseType_t  priority)
+{
+    current_task           = FindTask(task);
+    current_task->priority = priority;
+}
+
+void RTOSMock_RunUntil(TickType_t tick)
+{
+    if (tick >= tick_count) {
+        Schedule(tick - tick_count, NULL);
+    }
+}
+
+void RTOSMock_RunUntilIdle(void)
+{
+    Schedule(portMAX_DELAY, NULL);
+}
+
+TickType_t RTOSMock_DelayTicks(void)
+{
+    return delay_ticks;
+}
+
+uint32_t RTOSMock_IsrCallsFromTasks(void)
+{
+    return isr_calls_from_tasks;
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t pxTaskCode,
+                               const char*    pcName,
+                               uint32_t       ulStackDepth,
+                               void*          pvParameters,
+                               UBaseType_t    uxPriority,
+                               StackType_t*   puxStackBuffer,
+                               StaticTask_t*  pxTaskBuffer)
+{
+    UNUSED(pcName);
+    UNUSED(ulStackDepth);
+    UNUSED(puxStackBuffer);
+
+    created_task           = FindTask((TaskHandle_t) pxTaskBuffer);
+    created_task->priority = uxPriority;
+    task_function          = pxTaskCode;
+    task_parameters        = pvParameters;
+    task_state             = RTOS_MOCK_TASK_READY;
+
+    getcontext(&task_context);
+    task_context.uc_stack.ss_sp   = task_stack;
+    task_context.uc_stack.ss_size = sizeof(task_stack);
+    task_context.uc_link          = NULL;
+    makecontext(&task_context, TaskEntry, 0);
+
+    return created_task->handle;
+}
+
+void vTaskDelete(TaskHandle_t xTaskToDelete)
+{
+    if ((created_task != NULL) && (created_task->handle == xTaskToDelete)) {
+        task_state = RTOS_MOCK_TASK_DELETED;
+    }
+}
+
+void vTaskDelay(TickType_t xTicksToDelay)
+{
+    if (current_task != created_task) {
+        Schedule(xTicksToDelay, NULL);
+        return;
+    }
+    delay_ticks   += xTicksToDelay;
+    task_wake_tick = tick_count + xTicksToDelay;
+    BlockCreatedTask(RTOS_MOCK_TASK_DELAYED);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return tick_count;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return current_task->handle;
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t xTask)
+{
+    return (xTask == NULL) ? current_task->priority : FindTask(xTask)->priority;
+}
+
+void vTaskSetTimeOutState(TimeOut_t* pxTimeOut)
+{
+    pxTimeOut->xOverflowCount  = 0;
+    pxTimeOut->xTimeOnEntering = tick_count;
+}
+
+BaseType_t xTaskCheckForTimeOut(TimeOut_t*  pxTimeOut,
+                                TickType_t* pxTicksToWait)
+{
+    TickType_t elapsed = tick_count - pxTimeOut->xTimeOnEntering;
+
+    if (*pxTicksToWait == portMAX_DELAY) {
+        return pdFALSE;
+    }
+    if (elapsed >= *pxTicksToWait) {
+        *pxTicksToWait = 0;
+        return pdTRUE;
+    }
+    *pxTicksToWait            -= elapsed;
+    pxTimeOut->xTimeOnEntering = tick_count;
+
+    return pdFALSE;
+}
+
+// Only the created task blocks in it, the test task is never notified this way
+BaseType_t xTaskNotifyWait(uint32_t    ulBitsToClearOnEntry,
+                           uint32_t    ulBitsToClearOnExit,
+                           uint32_t*   pulNotificationValue,
+                           TickType_t  xTicksToWait)
+{
+    RTOSMockTask* task = current_task;
+
+    if (!task->notified) {
+        task->notify_value &= ~ulBitsToClearOnEntry;
+        if ((xTicksToWait != 0) && (task == created_task)) {
+            task_forever   = (xTicksToWait == portMAX_DELAY);
+            task_wake_tick = tick_count + xTicksToWait;
+            BlockCreatedTask(RTOS_MOCK_TASK_WAIT_NOTIFY);
+        }
+    }
+    if (!task->notified) {
+        return pdFALSE;
+    }
+    if (pulNotificationValue != NULL) {
+        *pulNotificationValue = task->notify_value;
+    }
+    task->notified      = false;
+    task->notify_value &= ~ulBitsToClearOnExit;
+
+    return pdTRUE;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t  xTaskToNotify,
+                              uint32_t      ulValue,
+                              eNotifyAction eAction,
+                              BaseType_t*   pxHigherPriorityTaskWoken)
+{
+    RTOSMockTask* task = FindTask(xTaskToNotify);
+
+    if (!in_interrupt) {
+        isr_calls_from_tasks++;
+    }
+
+    switch (eAction) {
+        case eSetBits:
+            task->notify_value |= ulValue;
+            break;
+
+        case eIncrement:
+            task->notify_value++;
+            break;
+
+        case eSetValueWithOverwrite:
+            task->notify_value = ulValue;
+            break;
+
+        case eSetValueWithoutOverwrite:
+            if (task->notified) {
+                return pdFAIL;
+            }
+            task->notify_value = ulValue;
+            break;
+
+        default:
+            break;
+    }
+    task->notified = true;
+
+    if ((task == created_task) && (task_state == RTOS_MOCK_TASK_WAIT_NOTIFY)) {
+        task_state = RTOS_MOCK_TASK_READY;
+        if (pxHigherPriorityTaskWoken != NULL) {
+            *pxHigherPriorityTaskWoken = pdTRUE;
+        }
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify)
+{
+    RTOSMockTask* task = FindTask(xTaskToNotify);
+
+    task->notify_value++;
+    task->notified = true;
+
+    return pdPASS;
+}
+
+// Only the test task blocks in it: the created task runs meanwhile
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit,
+                          TickType_t xTicksToWait)
+{
+    RTOSMockTask* task = current_task;
+    uint32_t      value;
+
+    if ((task->notify_value == 0) && (xTicksToWait != 0)) {
+        task->notified = false;
+        Schedule(xTicksToWait, task);
+    }
+    value              = task->notify_value;
+    task->notified     = false;
+    task->notify_value = ((xClearCountOnExit != pdFALSE) || (value == 0)) ? 0 : value - 1;
+
+    return value;
+}
+
+BaseType_t xTaskNotifyStateClear(TaskHandle_t xTask)
+{
+    RTOSMockTask* task = (xTask == NULL) ? current_task : FindTask(xTask);
+    BaseType_t    was_notified = task->notified ? pdTRUE : pdFALSE;
+
+    task->notified = false;
+
+    return was_notified;
+}
+
+SemaphoreHandle_t xSemaphoreCreateCountingStatic(UBaseType_t        uxMaxCount,
+                                                 UBaseType_t        uxInitialCount,
+                                                 StaticSemaphore_t* pxSemaphoreBuffer)
+{
+    UNUSED(pxSemaphoreBuffer);
+
+    if (semaphore_count == RTOS_MOCK_MAX_SEMAPHORES) {
+        return NULL;
+    }
+    semaphores[semaphore_count].count     = uxInitialCount;
+    semaphores[semaphore_count].max_count = uxMaxCount;
+
+    return (SemaphoreHandle_t) &semaphores[semaphore_count++];
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t xSemaphore)
+{
+    UNUSED(xSemaphore);
+}
+
+// The created task waits until the semaphore is given, whatever xTicksToWait
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore,
+                          TickType_t        xTicksToWait)
+{
+    RTOSMockSemaphore* semaphore = (RTOSMockSemaphore*) xSemaphore;
+
+    while ((semaphore->count == 0) && (xTicksToWait != 0) && (current_task == created_task)) {
+        task_semaphore = semaphore;
+        BlockCreatedTask(RTOS_MOCK_TASK_WAIT_SEMAPHORE);
+    }
+    if (semaphore->count == 0) {
+        return pdFALSE;
+    }
+    semaphore->count--;
+
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore)
+{
+    RTOSMockSemaphore* semaphore = (RTOSMockSemaphore*) xSemaphore;
+
+    if (semaphore->count == semaphore->max_count) {
+        return pdFALSE;
+    }
+    semaphore->count++;
+
+    if ((task_state == RTOS_MOCK_TASK_WAIT_SEMAPHORE) && (task_semaphore == semaphore)) {
+        task_state = RTOS_MOCK_TASK_READY;
+    }
+    return pdTRUE;
+}
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t    uxQueueLength,
+                                 UBaseType_t    uxItemSize,
+                                 uint8_t*       pucQueueStorageBuffer,
+                                 StaticQueue_t* pxQueueBuffer)
+{
+    UNUSED(pxQueueBuffer);
+
+    if (queue_count == RTOS_MOCK_MAX_QUEUES) {
+        return NULL;
+    }
+
+    RTOSMockQueue* queue = &queues[queue_count++];
+
+    queue->storage   = pucQueueStorageBuffer;
+    queue->length    = uxQueueLength;
+    queue->item_size = uxItemSize;
+    queue->head      = 0;
+    queue->count     = 0;
+
+    return (QueueHandle_t) queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t xQueue,
+                      const void*   pvItemToQueue,
+                      TickType_t    xTicksToWait)
+{
+    RTOSMockQueue* queue = (RTOSMockQueue*) xQueue;
+
+    UNUSED(xTicksToWait);
+
+    if (queue->count == queue->length) {
+        return errQUEUE_FULL;
+    }
+    memcpy(&queue->storage[((queue->head + queue->count) % queue->length) * queue->item_size],
+           pvItemToQueue,
+           queue->item_size);
+    queue->count++;
+
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue,
+                         void*         pvBuffer,
+                         TickType_t    xTicksToWait)
+{
+    RTOSMockQueue* queue = (RTOSMockQueue*) xQueue;
+
+    UNUSED(xTicksToWait);
+
+    if (queue->count == 0) {
+        return pdFALSE;
+    }
+    memcpy(pvBuffer, &queue->storage[queue->head * queue->item_size], queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+
+    return pdTRUE;
+}
+
+EventGroupHandle_t xEventGroupCreateStatic(StaticEventGroup_t* pxEventGroupBuffer)
+{
+    UNUSED(pxEventGroupBuffer);
+
+    if (event_group_count == RTOS_MOCK_MAX_EVENT_GROUPS) {
+        return NULL;
+    }
+    event_groups[event_group_count] = 0;
+
+    return (EventGroupHandle_t) &event_groups[event_group_count++];
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t xEventGroup,
+                               EventBits_t        uxBitsToSet)
+{
+    EventBits_t* bits = (EventBits_t*) xEventGroup;
+
+    *bits |= uxBitsToSet;
+
+    return *bits;
+}
+
+// Returns the bits before clearing them, also xEventGroupGetBits
+EventBits_t xEventGroupClearBits(EventGroupHandle_t xEventGroup,
+                                 EventBits_t        uxBitsToClear)
+{
+    EventBits_t* bits  = (EventBits_t*) xEventGroup;
+    EventBits_t  value = *bits;
+
+    *bits &= ~uxBitsToClear;
+
+    return value;
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) TheDevHuts, 2022.
+ * All rights reserved. Permission to use, copy, modify, distribute in any
+ * form or by any means or store in any database or retrieval system any
+ * parts of this copyrighted work is forbidden.
+ * Contact TheDevHuts (contact@thedevhuts.com) for licensing agreement
+ * opportunities.
+ *
+ * Contributor: Julien Gros
+ *
+ */
+
+#ifndef __RTOS_MOCK_H
+#define __RTOS_MOCK_H
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define MOCK_CLIENT_TASK(n) ((TaskHandle_t) (uintptr_t) (0x2000 + (n)))
+
+// FreeRTOS kernel simulated on virtual ticks. The task created by xTaskCreateStatic runs on its own
+// stack, the test is the current client task. The created task only runs when the test blocks
+// (ulTaskNotifyTake) or calls RTOSMock_RunUntil / RTOSMock_RunUntilIdle: the requests submitted
+// in between are queued as if the task was busy.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Called at each tick: the peripheral interrupts first, then the tick hook (vApplicationTickHook)
+extern void (* RTOSMock_InterruptHook)(void);
+extern void (* RTOSMock_TickHook)(void);
+
+void RTOSMock_Reset(void);
+void RTOSMock_SetCurrentTask(TaskHandle_t task,
+                             UBaseType_t  priority);
+
+// Runs the created task and ages the ticks until tick, the test task being blocked
+void RTOSMock_RunUntil(TickType_t tick);
+
+// Runs the created task until it waits on an empty semaphore
+void RTOSMock_RunUntilIdle(void);
+
+// Ticks spent by the created task in vTaskDelay
+TickType_t RTOSMock_DelayTicks(void);
+
+// FromISR calls made outside RTOSMock_InterruptHook and RTOSMock_TickHook, i.e. from a task
+uint32_t RTOSMock_IsrCallsFromTasks(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __RTOS_MOCK_H
@@ -0,0 +1,19 @@
+/*
+ * Copyright (c) TheDevHuts, 2022.
+ * All rights reserved. Permission to use, copy, modify, distribute in any
+ * form or by any means or store in any database or retrieval system any
+ * parts of this copyrighted work is forbidden.
+ * Contact TheDevHuts (contact@thedevhuts.com) for licensing agreement
+ * opportunities.
+ *
+ * Contributor: Florent Remis
+ *
+ */
+
+#include "CppUTest/CommandLineTestRunner.h"
+
+int main(int          argc,
+         const char** argv)
+{
+    return RUN_ALL_TESTS(argc, argv);
+}
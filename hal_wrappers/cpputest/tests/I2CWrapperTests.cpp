@@ -0,0 +1,868 @@
+/*
+ * Copyright (c) TheDevHuts, 2022.
+ * All rights reserved. Permission to use, copy, modify, distribute in any
+ * form or by any means or store in any database or retrieval system any
+ * parts of this copyrighted work is forbidden.
+ * Contact TheDevHuts (contact@thedevhuts.com) for licensing agreement
+ * opportunities.
+ *
+ * Contributor: Julien Gros
+ *
+ */
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTestExt/MockSupport.h"
+#include "I2CMock.h"
+#include "I2CWrapper.h"
+#include "RTOSMock.h"
+
+#define WRAPPER_QUEUE_LENGTH 8 // Default I2C_WRAPPER_QUEUE_LENGTH
+#define CLIENT_COUNT         (WRAPPER_QUEUE_LENGTH + 1)
+#define DEFAULT_SLAVE_ADDR   0x10
+#define TRANSFER_TICKS       2
+#define CLIENT_TIMEOUT_TICKS 7 // Derived for the two data bytes of a client at 100 kHz
+#define LARGE_DATA_COUNT     256
+#define FIXED_TIMEOUT_TICKS  25 // Wait of every transfer before the timeouts were derived
+#define NOTIFICATION_BITS    0x05
+#define MAX_STEP_DELAY_MS    20 // Default I2C_WRAPPER_MAX_STEP_DELAY_MS
+#define STEP_COUNT           3
+#define FIRST_STEP_CLIENT    (CLIENT_COUNT - STEP_COUNT) // Descriptors of the batch steps
+#define MAX_DEVICES          4  // Default I2C_WRAPPER_MAX_DEVICES
+#define DEVICE_ADDR          0x40
+
+class I2CSetupInfo_Comparator : public MockNamedValueComparator
+{
+public:
+bool isEqual(const void* object1,
+             const void* object2)
+{
+    const auto* SetupInfo1 = (const I2CSetupInfo*) object1;
+    const auto* SetupInfo2 = (const I2CSetupInfo*) object2;
+
+    return (SetupInfo1->role == SetupInfo2->role) &&
+           (SetupInfo1->mode == SetupInfo2->mode) &&
+           (SetupInfo1->timing == SetupInfo2->timing);
+}
+
+SimpleString valueToString(const void* object)
+{
+    return StringFrom(object);
+}
+};
+
+static I2CSetupInfo_Comparator setup_info_comparator;
+
+// Load of a client submitting a request every period, measured at its completion callback
+typedef struct {
+    TickType_t submit_tick;
+    TickType_t worst_latency;
+    uint32_t   submitted;
+    uint32_t   completed;
+    uint32_t   skipped; // Periods where the previous request was still in progress
+} ClientLoad;
+
+static I2CSetupInfo             default_setup;
+static uint8_t                  client_data[CLIENT_COUNT][2];
+static uint8_t                  large_data[LARGE_DATA_COUNT];
+static I2CTransactionDescriptor client_descriptors[CLIENT_COUNT];
+static I2CWrapperRequest        client_requests[CLIENT_COUNT];
+static ClientLoad               client_loads[CLIENT_COUNT];
+static I2CWrapperBatchStep      batch_steps[STEP_COUNT];
+static I2CWrapperDeviceProfile  device_profile;
+
+static I2CWrapperRequest*   notification_queue_storage[2];
+static StaticQueue_t        notification_queue_buffer;
+static StaticEventGroup_t   event_group_buffer;
+static uint32_t             callback_count;
+static I2CWrapperRequest*   callback_request;
+static I2CWrapperReturnCode callback_return_code;
+
+static void CountCallback(I2CWrapperRequest* request)
+{
+    callback_count++;
+    callback_request     = request;
+    callback_return_code = request->return_code;
+}
+
+static void RecordCompletion(I2CWrapperRequest* request)
+{
+    ClientLoad* load    = &client_loads[request - client_requests];
+    TickType_t  latency = xTaskGetTickCount() - load->submit_tick;
+
+    load->completed++;
+    if (latency > load->worst_latency) {
+        load->worst_latency = latency;
+    }
+}
+
+static void ResetStaticVariables(void)
+{
+    default_setup.role   = I2C_MASTER;
+    default_setup.mode   = I2C_STANDARD_MODE;
+    default_setup.timing = NULL;
+
+    for (uint8_t i = 0; i < CLIENT_COUNT; i++) {
+        I2CTransactionDescriptor* descriptor = &client_descriptors[i];
+        I2CWrapperRequest*        request    = &client_requests[i];
+
+        memset(descriptor, 0, sizeof(*descriptor));
+        descriptor->type            = I2C_SIMPLE_TRANSACTION;
+        descriptor->direction       = I2C_TX;
+        descriptor->addressing_mode = I2C_ADDRESSING_MODE_7_BIT;
+        descriptor->address         = DEFAULT_SLAVE_ADDR + i;
+        descriptor->data_path       = I2C_USE_FIFO;
+        descriptor->data            = client_data[i];
+        descriptor->data_count      = sizeof(client_data[i]);
+        descriptor->crc             = I2C_CRC_NONE;
+
+        memset(request, 0, sizeof(*request));
+        request->setup_info             = &default_setup;
+        request->transaction_descriptor = descriptor;
+        request->notification           = I2C_WRAPPER_NOTIFY_NONE;
+        request->done                   = true; // Free for the load of the client
+
+        memset(&client_loads[i], 0, sizeof(client_loads[i]));
+    }
+    for (uint8_t i = 0; i < STEP_COUNT; i++) {
+        batch_steps[i].descriptor  = &client_descriptors[FIRST_STEP_CLIENT + i];
+        batch_steps[i].delay_ms    = 4;
+        batch_steps[i].return_code = I2C_WRAPPER_NB_OF_RETURN_CODES;
+    }
+    device_profile.mode            = I2C_STANDARD_MODE;
+    device_profile.timing          = NULL;
+    device_profile.addressing_mode = I2C_ADDRESSING_MODE_7_BIT;
+    device_profile.address         = DEVICE_ADDR;
+    device_profile.data_path       = I2C_USE_AUTO;
+
+    callback_count       = 0;
+    callback_request     = NULL;
+    callback_return_code = I2C_WRAPPER_NB_OF_RETURN_CODES;
+}
+
+static I2CWrapperReturnCode SubmitFrom(uint8_t     client,
+                                       UBaseType_t priority)
+{
+    RTOSMock_SetCurrentTask(MOCK_CLIENT_TASK(client), priority);
+    return I2CWrapper_SubmitI2CTransaction(&client_requests[client]);
+}
+
+static void ExpectSetup(I2CSetupInfo* setup_info)
+{
+    mock().expectOneCall("I2C_SetupController")
+    .withPointerParameter("i2c_dev", HAL_I2C)
+    .withParameterOfType("I2CSetupInfo*", "setup_info", setup_info)
+    .andReturnValue(I2C_OK);
+}
+
+static void ExpectLaunch(uint8_t  client,
+                         uint32_t timeout)
+{
+    mock().expectOneCall("I2C_LaunchTransaction")
+    .withPointerParameter("i2c_dev", HAL_I2C)
+    .withPointerParameter("descriptor", &client_descriptors[client])
+    .withUnsignedIntParameter("timeout", timeout)
+    .andReturnValue(I2C_OK);
+}
+
+static void ExpectLaunchOrder(const uint8_t* clients,
+                              uint8_t        count)
+{
+    for (uint8_t i = 0; i < count; i++) {
+        ExpectLaunch(clients[i], CLIENT_TIMEOUT_TICKS);
+    }
+}
+
+static void ExpectRecovery(void)
+{
+    mock().expectOneCall("I2C_RecoverBus")
+    .withPointerParameter("i2c_dev", HAL_I2C)
+    .andReturnValue(I2C_OK);
+}
+
+// Client i has priority i + 1 and submits at the start of each period if its request is done
+static void RunClients(uint8_t    clients,
+                       TickType_t period,
+                       TickType_t duration)
+{
+    for (TickType_t tick = 0; tick < duration; tick++) {
+        RTOSMock_RunUntil(tick);
+        if ((tick % period) != 0) {
+            continue;
+        }
+        for (uint8_t i = 0; i < clients; i++) {
+            client_requests[i].notification = I2C_WRAPPER_NOTIFY_CALLBACK;
+            client_requests[i].callback     = RecordCompletion;
+            if (!client_requests[i].done) {
+                client_loads[i].skipped++;
+                continue;
+            }
+            client_loads[i].submit_tick = tick;
+            client_loads[i].submitted++;
+            LONGS_EQUAL(I2C_WRAPPER_OK, SubmitFrom(i, i + 1));
+        }
+    }
+    RTOSMock_RunUntilIdle();
+}
+
+TEST_GROUP(I2CWrapperBusManager)
+{
+    void setup()
+    {
+        mock().strictOrder();
+        mock().installComparator("I2CSetupInfo*", setup_info_comparator);
+        RTOSMock_Reset();
+        I2CMock_Reset();
+        RTOSMock_InterruptHook = I2CMock_Interrupts;
+        RTOSMock_TickHook      = I2C_TimeoutTick;
+        I2CMock_SetTransferTicks(TRANSFER_TICKS);
+        ResetStaticVariables();
+        LONGS_EQUAL(I2C_WRAPPER_OK, I2CWrapper_Create());
+        RTOSMock_RunUntilIdle();
+    }
+
+    void teardown()
+    {
+        I2CWrapper_Destroy();
+        mock().checkExpectations();
+        mock().clear();
+        mock().removeAllComparatorsAndCopiers();
+    }
+};
+
+TEST(I2CWrapperBusManager, HigherPriorityRequestsRunFirst)
+{
+    const uint8_t expected_order[] = {3, 1, 2, 0};
+
+    ExpectSetup(&default_setup);
+    ExpectLaunchOrder(expected_order, sizeof(expected_order));
+    LONGS_EQUAL(I2C_WRAPPER_OK, SubmitFrom(0, 1));
+    LONGS_EQUAL(I2C_WRAPPER_OK, SubmitFrom(1, 3));
+    LONGS_EQUAL(I2C_WRAPPER_OK, SubmitFrom(2, 2));
+    LONGS_EQUAL(I2C_WRAPPER_OK, SubmitFrom(3, 4));
+    RTOSMock_RunUntilIdle();
+}
+
+TEST(I2CWrapperBusManager, SamePriorityRequestsRunInSubmitOrder)
+{
+    const uint8_t expected_order[] = {2, 0, 1, 3, 4};
+
+    ExpectSetup(&default_setup);
+    ExpectLaunchOrder(expected_order, sizeof(expected_order));
+    LONGS_EQUAL(I2C_WRAPPER_OK, SubmitFrom(0, 2));
+    LONGS_EQUAL(I2C_WRAPPER_OK, SubmitFrom(1, 2));
+    LONGS_EQUAL(I2C_WRAPPER_OK, SubmitFrom(2, 3));
+    LONGS_EQUAL(I2C_WRAPPER_OK, SubmitFrom(3, 2));
+    LONGS_EQUAL(I2C_WRAPPER_OK, SubmitFrom(4, 2));
+    RTOSMock_RunUntilIdle();
+
+    for (uint8_t i = 0; i < sizeof(expected_order); i++) {
+        CHECK(client_requests[i].done);
+        LONGS_EQUAL(I2C_WRAPPER_OK, client_requests[i].return_code);
+    }
+}
+
+TEST(I2CWrapperBusManager, FullQueueRefusesTheRequest)
+{
+    ExpectSetup(&default_setup);
+    for (uint8_t i = 0; i < WRAPPER_QUEUE_LENGTH; i++) {
+        ExpectLaunch(i, CLIENT_TIMEOUT_TICKS);
+        LONGS_EQUAL(I2C_WRAPPER_OK, SubmitFrom(i, 1));
+    }
+    LONGS_EQUAL(I2C_WRAPPER_QUEUE_FULL, SubmitFrom(WRAPPER_QUEUE_LENGTH, 1));
+    RTOSMock_RunUntilIdle();
+    mock().checkExpectations();
+
+    ExpectLaunch(WRAPPER_QUEUE_LENGTH, CLIENT_TIMEOUT_TICKS);
+    LONGS_EQUAL(I2C_WRAPPER_OK, SubmitFrom(WRAPPER_QUEUE_LENGTH, 1));
+    RTOSMock_RunUntilIdle();
+}
+
+TEST(I2CWrapperBusManager, ExpiredHalDeadlineReportsTimeout)
+{
+    I2CMock_SetTransferTicks(0);
+
+    // No recovery: the HAL reports the expired deadline
+    ExpectSetup(&default_setup);
+    ExpectLaunch(0, CLIENT_TIMEOUT_TICKS);
+    LONGS_EQUAL(I2C_WRAPPER_TIMEOUT,
+                I2CWrapper_LaunchI2CTransaction(&default_setup, &client_descriptors[0]));
+    LONGS_EQUAL(I2C_TRANSACTION_TIMEOUT, client_descriptors[0].status);
+    LONGS_EQUAL(CLIENT_TIMEOUT_TICKS, xTaskGetTickCount());
+}
+
+TEST(I2CWrapperBusManager, MissingTickHookRecoversTheBusAtTheBackstop)
+{
+    I2CMock_SetTransferTicks(0);
+    RTOSMock_TickHook = NULL;
+
+    ExpectSetup(&default_setup);
+    ExpectLaunch(0, CLIENT_TIMEOUT_TICKS);
+    ExpectRecovery();
+    LONGS_EQUAL(I2C_WRAPPER_TIMEOUT,
+                I2CWrapper_LaunchI2CTransaction(&default_setup, &client_descriptors[0]));
+    LONGS_EQUAL(2 * CLIENT_TIMEOUT_TICKS, xTaskGetTickCount());
+    // The aborted transfer is completed from the bus manager, not from an interrupt
+    LONGS_EQUAL(I2C_BUS_HANG, client_descriptors[0].status);
+    LONGS_EQUAL(0, RTOSMock_IsrCallsFromTasks());
+
+    // The bus is free again for the next request
+    I2CMock_SetTransferTicks(TRANSFER_TICKS);
+    ExpectLaunch(1, CLIENT_TIMEOUT_TICKS);
+    LONGS_EQUAL(I2C_WRAPPER_OK,
+                I2CWrapper_LaunchI2CTransaction(&default_setup, &client_descriptors[1]));
+}
+
+TEST(I2CWrapperBusManager, SimultaneousClientsWaitForTheHigherPriorities)
+{
+    // Timing of the scheduler only, the HAL calls are not checked
+    mock().ignoreOtherCalls();
+    // All the clients submit at the same tick, once
+    RunClients(WRAPPER_QUEUE_LENGTH, 1000, 1);
+
+    for (uint8_t i = 0; i < WRAPPER_QUEUE_LENGTH; i++) {
+        LONGS_EQUAL(1, client_loads[i].completed);
+        LONGS_EQUAL((WRAPPER_QUEUE_LENGTH - i) * TRANSFER_TICKS, client_loads[i].worst_latency);
+    }
+    LONGS_EQUAL(WRAPPER_QUEUE_LENGTH * TRANSFER_TICKS, xTaskGetTickCount());
+}
+
+TEST(I2CWrapperBusManager, ClientsBelowBusCapacityAreAllServed)
+{
+    // Timing of the scheduler only, the HAL calls are not checked
+    mock().ignoreOtherCalls();
+    const TickType_t period    = 4 * WRAPPER_QUEUE_LENGTH * TRANSFER_TICKS; // 25 % bus load
+    const TickType_t duration  = 1000;
+    uint32_t         completed = 0;
+
+    RunClients(WRAPPER_QUEUE_LENGTH, period, duration);
+
+    for (uint8_t i = 0; i < WRAPPER_QUEUE_LENGTH; i++) {
+        LONGS_EQUAL(client_loads[i].submitted, client_loads[i].completed);
+        LONGS_EQUAL(0, client_loads[i].skipped);
+        // Tail latency: behind every higher priority request of the period
+        TickType_t latency_bound = (WRAPPER_QUEUE_LENGTH - i) * TRANSFER_TICKS;
+
+        CHECK(client_loads[i].worst_latency <= latency_bound);
+        completed += client_loads[i].completed;
+    }
+    LONGS_EQUAL(WRAPPER_QUEUE_LENGTH * ((duration + period - 1) / period), completed);
+}
+
+TEST(I2CWrapperBusManager, OverloadedBusKeepsTheHighPriorityLatency)
+{
+    // Timing of the scheduler only, the HAL calls are not checked
+    mock().ignoreOtherCalls();
+    const TickType_t period    = WRAPPER_QUEUE_LENGTH * TRANSFER_TICKS / 2; // 200 % bus load
+    const TickType_t duration  = 1000;
+    uint32_t         completed = 0;
+
+    RunClients(WRAPPER_QUEUE_LENGTH, period, duration);
+
+    for (uint8_t i = 0; i < WRAPPER_QUEUE_LENGTH; i++) {
+        completed += client_loads[i].completed;
+    }
+    // Throughput: the bus never idles, one transfer every TRANSFER_TICKS
+    CHECK(completed >= duration / TRANSFER_TICKS - 1);
+
+    // The highest priority client waits at most for the transfer in progress
+    const ClientLoad* highest = &client_loads[WRAPPER_QUEUE_LENGTH - 1];
+
+    LONGS_EQUAL(highest->submitted, highest->completed);
+    LONGS_EQUAL(0, highest->skipped);
+    CHECK(highest->worst_latency <= 2 * TRANSFER_TICKS);
+
+    // No aging of the priorities: the lowest priority client starves until the others stop
+    CHECK(client_loads[0].completed < highest->completed / 4);
+}
+
+TEST_GROUP(I2CWrapperTimeout)
+{
+    void setup()
+    {
+        mock().strictOrder();
+        mock().installComparator("I2CSetupInfo*", setup_info_comparator);
+        RTOSMock_Reset();
+        I2CMock_Reset();
+        RTOSMock_InterruptHook = I2CMock_Interrupts;
+        RTOSMock_TickHook      = I2C_TimeoutTick;
+        I2CMock_SetTransferTicks(TRANSFER_TICKS);
+        ResetStaticVariables();
+        LONGS_EQUAL(I2C_WRAPPER_OK, I2CWrapper_Create());
+        RTOSMock_RunUntilIdle();
+    }
+
+    void teardown()
+    {
+        I2CWrapper_Destroy();
+        mock().checkExpectations();
+        mock().clear();
+        mock().removeAllComparatorsAndCopiers();
+    }
+};
+
+TEST(I2CWrapperTimeout, OneByteAtOneMegahertzIsGivenSevenTicks)
+{
+    default_setup.mode               = I2C_FAST_MODE_PLUS;
+    client_descriptors[0].data_count = 1;
+
+    // 21 bits with the address byte: 1 ms rounded up, 5 ms of clock stretching, 1 tick of launch
+    ExpectSetup(&default_setup);
+    ExpectLaunch(0, 7);
+    LONGS_EQUAL(I2C_WRAPPER_OK,
+                I2CWrapper_LaunchI2CTransaction(&default_setup, &client_descriptors[0]));
+    LONGS_EQUAL(0, client_descriptors[0].timeout);
+}
+
+TEST(I2CWrapperTimeout, LargeTransferAtOneHundredKilohertzIsGivenThirtyTicks)
+{
+    client_descriptors[0].data       = large_data;
+    client_descriptors[0].data_count = LARGE_DATA_COUNT;
+
+    // 2316 bits with the address byte: 24 ms rounded up, 5 ms of clock stretching, 1 tick of launch
+    ExpectSetup(&default_setup);
+    ExpectLaunch(0, 30);
+    LONGS_EQUAL(I2C_WRAPPER_OK,
+                I2CWrapper_LaunchI2CTransaction(&default_setup, &client_descriptors[0]));
+    LONGS_EQUAL(0, client_descriptors[0].timeout);
+}
+
+TEST(I2CWrapperTimeout, CallerTimeoutIsUsedAsIs)
+{
+    client_descriptors[0].timeout = 3;
+
+    ExpectSetup(&default_setup);
+    ExpectLaunch(0, 3);
+    LONGS_EQUAL(I2C_WRAPPER_OK,
+                I2CWrapper_LaunchI2CTransaction(&default_setup, &client_descriptors[0]));
+    LONGS_EQUAL(3, client_descriptors[0].timeout);
+}
+
+TEST(I2CWrapperTimeout, StuckTransferBlocksTheCallerUntilItsDeadline)
+{
+    default_setup.mode               = I2C_FAST_MODE_PLUS;
+    client_descriptors[0].data_count = 1;
+    I2CMock_SetTransferTicks(0);
+
+    ExpectSetup(&default_setup);
+    ExpectLaunch(0, 7);
+    LONGS_EQUAL(I2C_WRAPPER_TIMEOUT,
+                I2CWrapper_LaunchI2CTransaction(&default_setup, &client_descriptors[0]));
+    LONGS_EQUAL(7, xTaskGetTickCount());
+    CHECK(xTaskGetTickCount() < FIXED_TIMEOUT_TICKS);
+}
+
+TEST(I2CWrapperTimeout, StuckTransferWithoutTickHookBlocksTheCallerUntilTheBackstop)
+{
+    default_setup.mode               = I2C_FAST_MODE_PLUS;
+    client_descriptors[0].data_count = 1;
+    I2CMock_SetTransferTicks(0);
+    RTOSMock_TickHook = NULL;
+
+    ExpectSetup(&default_setup);
+    ExpectLaunch(0, 7);
+    ExpectRecovery();
+    LONGS_EQUAL(I2C_WRAPPER_TIMEOUT,
+                I2CWrapper_LaunchI2CTransaction(&default_setup, &client_descriptors[0]));
+    LONGS_EQUAL(2 * 7, xTaskGetTickCount());
+    CHECK(xTaskGetTickCount() < FIXED_TIMEOUT_TICKS);
+}
+
+TEST_GROUP(I2CWrapperSubmit)
+{
+    void setup()
+    {
+        mock().strictOrder();
+        mock().installComparator("I2CSetupInfo*", setup_info_comparator);
+        RTOSMock_Reset();
+        I2CMock_Reset();
+        RTOSMock_InterruptHook = I2CMock_Interrupts;
+        RTOSMock_TickHook      = I2C_TimeoutTick;
+        I2CMock_SetTransferTicks(TRANSFER_TICKS);
+        ResetStaticVariables();
+        LONGS_EQUAL(I2C_WRAPPER_OK, I2CWrapper_Create());
+        RTOSMock_RunUntilIdle();
+    }
+
+    void teardown()
+    {
+        I2CWrapper_Destroy();
+        mock().checkExpectations();
+        mock().clear();
+        mock().removeAllComparatorsAndCopiers();
+    }
+};
+
+TEST(I2CWrapperSubmit, InvalidRequestsAreRefused)
+{
+    I2CWrapperRequest* request = &client_requests[0];
+
+    LONGS_EQUAL(I2C_WRAPPER_INVALID_INPUT_DATA, I2CWrapper_SubmitI2CTransaction(NULL));
+
+    request->notification = I2C_WRAPPER_NOTIFY_CALLBACK;
+    LONGS_EQUAL(I2C_WRAPPER_INVALID_INPUT_DATA, I2CWrapper_SubmitI2CTransaction(request));
+
+    request->notification = I2C_WRAPPER_NOTIFY_QUEUE;
+    LONGS_EQUAL(I2C_WRAPPER_INVALID_INPUT_DATA, I2CWrapper_SubmitI2CTransaction(request));
+
+    request->notification = I2C_WRAPPER_NOTIFY_EVENT_GROUP;
+    LONGS_EQUAL(I2C_WRAPPER_INVALID_INPUT_DATA, I2CWrapper_SubmitI2CTransaction(request));
+
+    LONGS_EQUAL(I2C_WRAPPER_INVALID_INPUT_DATA, I2CWrapper_WaitI2CRequest(NULL, 0));
+    RTOSMock_RunUntilIdle();
+}
+
+TEST(I2CWrapperSubmit, SubmitReturnsBeforeTheTransfer)
+{
+    LONGS_EQUAL(I2C_WRAPPER_OK, SubmitFrom(0, 1));
+    CHECK_FALSE(client_requests[0].done);
+    LONGS_EQUAL(I2C_WRAPPER_REQUEST_PENDING, client_requests[0].return_code);
+    LONGS_EQUAL(0, xTaskGetTickCount());
+
+    // Launched by the bus manager only
+    ExpectSetup(&default_setup);
+    ExpectLaunch(0, CLIENT_TIMEOUT_TICKS);
+    RTOSMock_RunUntilIdle();
+    CHECK(client_requests[0].done);
+    LONGS_EQUAL(I2C_WRAPPER_OK, client_requests[0].return_code);
+}
+
+TEST(I2CWrapperSubmit, WaitWithoutTimeoutPollsTheRequest)
+{
+    ExpectSetup(&default_setup);
+    ExpectLaunch(0, CLIENT_TIMEOUT_TICKS);
+    LONGS_EQUAL(I2C_WRAPPER_OK, SubmitFrom(0, 1));
+    LONGS_EQUAL(I2C_WRAPPER_REQUEST_PENDING, I2CWrapper_WaitI2CRequest(&client_requests[0], 0));
+    LONGS_EQUAL(0, xTaskGetTickCount());
+    POINTERS_EQUAL(NULL, client_requests[0].waiter);
+
+    RTOSMock_RunUntilIdle();
+    LONGS_EQUAL(I2C_WRAPPER_OK, I2CWrapper_WaitI2CRequest(&client_requests[0], 0));
+}
+
+TEST(I2CWrapperSubmit, WaitTimesOutBeforeALongerTransfer)
+{
+    // Within the deadline of the transaction
+    I2CMock_SetTransferTicks(5);
+    ExpectSetup(&default_setup);
+    ExpectLaunch(0, CLIENT_TIMEOUT_TICKS);
+
+    LONGS_EQUAL(I2C_WRAPPER_OK, SubmitFrom(0, 1));
+    LONGS_EQUAL(I2C_WRAPPER_REQUEST_PENDING, I2CWrapper_WaitI2CRequest(&client_requests[0], 3));
+    LONGS_EQUAL(3, xTaskGetTickCount());
+    POINTERS_EQUAL(NULL, client_requests[0].waiter);
+
+    LONGS_EQUAL(I2C_WRAPPER_OK, I2CWrapper_WaitI2CRequest(&client_requests[0], 20));
+    LONGS_EQUAL(5, xTaskGetTickCount());
+}
+
+TEST(I2CWrapperSubmit, FailedTransferIsReportedToTheWaiter)
+{
+    I2CMock_FailTransfer(0, I2C_CRC_ERROR);
+    I2CMock_FailTransfer(1, I2C_ADDR_HIT_ERROR);
+    ExpectSetup(&default_setup);
+    ExpectLaunch(0, CLIENT_TIMEOUT_TICKS);
+    ExpectLaunch(1, CLIENT_TIMEOUT_TICKS);
+
+    LONGS_EQUAL(I2C_WRAPPER_OK, SubmitFrom(0, 1));
+    LONGS_EQUAL(I2C_WRAPPER_CRC_ERROR, I2CWrapper_WaitI2CRequest(&client_requests[0], 20));
+    LONGS_EQUAL(I2C_WRAPPER_OK, SubmitFrom(1, 1));
+    LONGS_EQUAL(I2C_WRAPPER_I2C_ERROR, I2CWrapper_WaitI2CRequest(&client_requests[1], 20));
+}
+
+TEST(I2CWrapperSubmit, CallbackIsCalledOnceWithTheResult)
+{
+    client_requests[0].notification = I2C_WRAPPER_NOTIFY_CALLBACK;
+    client_requests[0].callback     = CountCallback;
+    ExpectSetup(&default_setup);
+    ExpectLaunch(0, CLIENT_TIMEOUT_TICKS);
+
+    LONGS_EQUAL(I2C_WRAPPER_OK, SubmitFrom(0, 1));
+    RTOSMock_RunUntilIdle();
+    LONGS_EQUAL(1, callback_count);
+    POINTERS_EQUAL(&client_requests[0], callback_request);
+    LONGS_EQUAL(I2C_WRAPPER_OK, callback_return_code);
+    CHECK(client_requests[0].done);
+}
+
+TEST(I2CWrapperSubmit, QueueGetsTheRequestHandle)
+{
+    QueueHandle_t      queue = xQueueCreateStatic(2,
+                                                  sizeof(I2CWrapperRequest*),
+                                                  (uint8_t*) notification_queue_storage,
+                                                  &notification_queue_buffer);
+    I2CWrapperRequest* received = NULL;
+
+    client_requests[0].notification = I2C_WRAPPER_NOTIFY_QUEUE;
+    client_requests[0].queue        = queue;
+    ExpectSetup(&default_setup);
+    ExpectLaunch(0, CLIENT_TIMEOUT_TICKS);
+
+    LONGS_EQUAL(I2C_WRAPPER_OK, SubmitFrom(0, 1));
+    RTOSMock_RunUntilIdle();
+    LONGS_EQUAL(pdTRUE, xQueueReceive(queue, &received, 0));
+    POINTERS_EQUAL(&client_requests[0], received);
+    LONGS_EQUAL(0, I2CWrapper_GetLostNotifications());
+}
+
+TEST(I2CWrapperSubmit, FullQueueLosesTheNotificationButNotTheResult)
+{
+    QueueHandle_t      queue = xQueueCreateStatic(1,
+                                                  sizeof(I2CWrapperRequest*),
+                                                  (uint8_t*) notification_queue_storage,
+                                                  &notification_queue_buffer);
+    I2CWrapperRequest* received = NULL;
+
+    ExpectSetup(&default_setup);
+    for (uint8_t i = 0; i < 2; i++) {
+        client_requests[i].notification = I2C_WRAPPER_NOTIFY_QUEUE;
+        client_requests[i].queue        = queue;
+        ExpectLaunch(i, CLIENT_TIMEOUT_TICKS);
+        LONGS_EQUAL(I2C_WRAPPER_OK, SubmitFrom(i, 1));
+    }
+    RTOSMock_RunUntilIdle();
+
+    LONGS_EQUAL(1, I2CWrapper_GetLostNotifications());
+    LONGS_EQUAL(pdTRUE, xQueueReceive(queue, &received, 0));
+    POINTERS_EQUAL(&client_requests[0], received);
+    LONGS_EQUAL(pdFALSE, xQueueReceive(queue, &received, 0));
+    LONGS_EQUAL(I2C_WRAPPER_OK, I2CWrapper_WaitI2CRequest(&client_requests[1], 0));
+}
+
+TEST(I2CWrapperSubmit, EventGroupGetsTheBits)
+{
+    EventGroupHandle_t event_group = xEventGroupCreateStatic(&event_group_buffer);
+
+    client_requests[0].notification = I2C_WRAPPER_NOTIFY_EVENT_GROUP;
+    client_requests[0].event_group  = event_group;
+    client_requests[0].event_bits   = NOTIFICATION_BITS;
+    ExpectSetup(&default_setup);
+    ExpectLaunch(0, CLIENT_TIMEOUT_TICKS);
+
+    LONGS_EQUAL(I2C_WRAPPER_OK, SubmitFrom(0, 1));
+    LONGS_EQUAL(0, xEventGroupGetBits(event_group));
+    RTOSMock_RunUntilIdle();
+    LONGS_EQUAL(NOTIFICATION_BITS, xEventGroupGetBits(event_group));
+}
+
+TEST_GROUP(I2CWrapperBatch)
+{
+    void setup()
+    {
+        mock().strictOrder();
+        mock().installComparator("I2CSetupInfo*", setup_info_comparator);
+        RTOSMock_Reset();
+        I2CMock_Reset();
+        RTOSMock_InterruptHook = I2CMock_Interrupts;
+        RTOSMock_TickHook      = I2C_TimeoutTick;
+        I2CMock_SetTransferTicks(TRANSFER_TICKS);
+        ResetStaticVariables();
+        LONGS_EQUAL(I2C_WRAPPER_OK, I2CWrapper_Create());
+        RTOSMock_RunUntilIdle();
+    }
+
+    void teardown()
+    {
+        I2CWrapper_Destroy();
+        mock().checkExpectations();
+        mock().clear();
+        mock().removeAllComparatorsAndCopiers();
+    }
+};
+
+TEST(I2CWrapperBatch, StepsRunInOrderWithTheDelaysInBetween)
+{
+    const uint8_t expected_order[] = {FIRST_STEP_CLIENT, FIRST_STEP_CLIENT + 1,
+                                      FIRST_STEP_CLIENT + 2};
+
+    // The bus is set up once for the whole batch
+    ExpectSetup(&default_setup);
+    ExpectLaunchOrder(expected_order, sizeof(expected_order));
+    LONGS_EQUAL(I2C_WRAPPER_OK, I2CWrapper_LaunchI2CBatch(&default_setup, batch_steps, STEP_COUNT));
+
+    for (uint8_t i = 0; i < STEP_COUNT; i++) {
+        LONGS_EQUAL(I2C_WRAPPER_OK, batch_steps[i].return_code);
+    }
+    // None after the last step
+    LONGS_EQUAL(2 * 4, RTOSMock_DelayTicks());
+}
+
+TEST(I2CWrapperBatch, FirstFailedStepStopsTheBatch)
+{
+    I2CMock_FailTransfer(1, I2C_ADDR_HIT_ERROR);
+
+    // The last step is not launched
+    ExpectSetup(&default_setup);
+    ExpectLaunch(FIRST_STEP_CLIENT, CLIENT_TIMEOUT_TICKS);
+    ExpectLaunch(FIRST_STEP_CLIENT + 1, CLIENT_TIMEOUT_TICKS);
+    LONGS_EQUAL(I2C_WRAPPER_I2C_ERROR,
+                I2CWrapper_LaunchI2CBatch(&default_setup, batch_steps, STEP_COUNT));
+
+    LONGS_EQUAL(I2C_WRAPPER_OK, batch_steps[0].return_code);
+    LONGS_EQUAL(I2C_WRAPPER_I2C_ERROR, batch_steps[1].return_code);
+    LONGS_EQUAL(I2C_WRAPPER_STEP_NOT_RUN, batch_steps[2].return_code);
+    LONGS_EQUAL(4, RTOSMock_DelayTicks());
+}
+
+TEST(I2CWrapperBatch, StepsOfAFailedSubmitAreNotRun)
+{
+    client_requests[0].transaction_descriptor = NULL;
+    client_requests[0].steps                  = batch_steps;
+    client_requests[0].step_count             = STEP_COUNT;
+    I2CMock_FailTransfer(0, I2C_CRC_ERROR);
+    ExpectSetup(&default_setup);
+    ExpectLaunch(FIRST_STEP_CLIENT, CLIENT_TIMEOUT_TICKS);
+
+    LONGS_EQUAL(I2C_WRAPPER_OK, SubmitFrom(0, 1));
+    for (uint8_t i = 0; i < STEP_COUNT; i++) {
+        LONGS_EQUAL(I2C_WRAPPER_STEP_NOT_RUN, batch_steps[i].return_code);
+    }
+    LONGS_EQUAL(I2C_WRAPPER_CRC_ERROR, I2CWrapper_WaitI2CRequest(&client_requests[0], 100));
+    LONGS_EQUAL(I2C_WRAPPER_CRC_ERROR, batch_steps[0].return_code);
+    LONGS_EQUAL(I2C_WRAPPER_STEP_NOT_RUN, batch_steps[1].return_code);
+    LONGS_EQUAL(I2C_WRAPPER_STEP_NOT_RUN, batch_steps[2].return_code);
+}
+
+TEST(I2CWrapperBatch, OtherRequestsWaitForTheWholeBatch)
+{
+    const uint8_t expected_order[] = {FIRST_STEP_CLIENT, FIRST_STEP_CLIENT + 1,
+                                      FIRST_STEP_CLIENT + 2, 1};
+
+    client_requests[0].transaction_descriptor = NULL;
+    client_requests[0].steps                  = batch_steps;
+    client_requests[0].step_count             = STEP_COUNT;
+    batch_steps[0].delay_ms                   = MAX_STEP_DELAY_MS;
+    batch_steps[1].delay_ms                   = MAX_STEP_DELAY_MS;
+
+    ExpectSetup(&default_setup);
+    ExpectLaunchOrder(expected_order, sizeof(expected_order));
+    LONGS_EQUAL(I2C_WRAPPER_OK, SubmitFrom(0, 1));
+    RTOSMock_RunUntil(1);
+    LONGS_EQUAL(I2C_WRAPPER_OK, SubmitFrom(1, 5));
+    RTOSMock_RunUntilIdle();
+
+    // The bus is held for the transfers and the delays of the batch, then for the transfer of 1
+    LONGS_EQUAL(4 * TRANSFER_TICKS + 2 * MAX_STEP_DELAY_MS, xTaskGetTickCount());
+}
+
+TEST(I2CWrapperBatch, StepDelayAboveTheCapIsRefused)
+{
+    batch_steps[1].delay_ms = MAX_STEP_DELAY_MS + 1;
+
+    LONGS_EQUAL(I2C_WRAPPER_INVALID_INPUT_DATA,
+                I2CWrapper_LaunchI2CBatch(&default_setup, batch_steps, STEP_COUNT));
+}
+
+TEST_GROUP(I2CWrapperRegistry)
+{
+    void setup()
+    {
+        mock().strictOrder();
+        mock().installComparator("I2CSetupInfo*", setup_info_comparator);
+        RTOSMock_Reset();
+        I2CMock_Reset();
+        RTOSMock_InterruptHook = I2CMock_Interrupts;
+        RTOSMock_TickHook      = I2C_TimeoutTick;
+        I2CMock_SetTransferTicks(TRANSFER_TICKS);
+        ResetStaticVariables();
+        LONGS_EQUAL(I2C_WRAPPER_OK, I2CWrapper_Create());
+        RTOSMock_RunUntilIdle();
+    }
+
+    void teardown()
+    {
+        I2CWrapper_Destroy();
+        mock().checkExpectations();
+        mock().clear();
+        mock().removeAllComparatorsAndCopiers();
+    }
+};
+
+TEST(I2CWrapperRegistry, RegistryRefusesTheDeviceAfterTheLastSlot)
+{
+    I2CWrapperDevice* devices[MAX_DEVICES];
+    I2CWrapperDevice* extra_device = NULL;
+
+    for (uint8_t i = 0; i < MAX_DEVICES; i++) {
+        device_profile.address = DEVICE_ADDR + i;
+        LONGS_EQUAL(I2C_WRAPPER_OK, I2CWrapper_RegisterDevice(&device_profile, &devices[i]));
+    }
+    LONGS_EQUAL(I2C_WRAPPER_REGISTRY_FULL,
+                I2CWrapper_RegisterDevice(&device_profile, &extra_device));
+    POINTERS_EQUAL(NULL, extra_device);
+
+    // Freed by the unregistration
+    LONGS_EQUAL(I2C_WRAPPER_OK, I2CWrapper_UnregisterDevice(devices[1]));
+    LONGS_EQUAL(I2C_WRAPPER_OK, I2CWrapper_RegisterDevice(&device_profile, &extra_device));
+    POINTERS_EQUAL(devices[1], extra_device);
+}
+
+TEST(I2CWrapperRegistry, UnregisteredDeviceIsRefused)
+{
+    I2CWrapperDevice* device;
+
+    LONGS_EQUAL(I2C_WRAPPER_OK, I2CWrapper_RegisterDevice(&device_profile, &device));
+    LONGS_EQUAL(I2C_WRAPPER_OK, I2CWrapper_UnregisterDevice(device));
+
+    LONGS_EQUAL(I2C_WRAPPER_INVALID_INPUT_DATA, I2CWrapper_UnregisterDevice(device));
+    LONGS_EQUAL(I2C_WRAPPER_INVALID_INPUT_DATA,
+                I2CWrapper_LaunchDeviceTransaction(device, &client_descriptors[0]));
+    LONGS_EQUAL(I2C_WRAPPER_INVALID_INPUT_DATA,
+                I2CWrapper_LaunchDeviceBatch(device, batch_steps, STEP_COUNT));
+}
+
+TEST(I2CWrapperRegistry, ProfileIsAppliedToTheTransaction)
+{
+    I2CWrapperDevice* device;
+
+    LONGS_EQUAL(I2C_WRAPPER_OK, I2CWrapper_RegisterDevice(&device_profile, &device));
+    ExpectSetup(&default_setup);
+    ExpectLaunch(0, CLIENT_TIMEOUT_TICKS);
+    LONGS_EQUAL(I2C_WRAPPER_OK, I2CWrapper_LaunchDeviceTransaction(device, &client_descriptors[0]));
+
+    LONGS_EQUAL(DEVICE_ADDR, client_descriptors[0].address);
+    LONGS_EQUAL(I2C_USE_AUTO, client_descriptors[0].data_path);
+}
+
+TEST(I2CWrapperRegistry, UnchangedSetupIsNotAppliedAgain)
+{
+    I2CWrapperDevice* device;
+    I2CWrapperDevice* other_device;
+
+    LONGS_EQUAL(I2C_WRAPPER_OK, I2CWrapper_RegisterDevice(&device_profile, &device));
+    device_profile.address = DEVICE_ADDR + 1;
+    LONGS_EQUAL(I2C_WRAPPER_OK, I2CWrapper_RegisterDevice(&device_profile, &other_device));
+
+    // Same bus setup for both devices
+    ExpectSetup(&default_setup);
+    ExpectLaunch(0, CLIENT_TIMEOUT_TICKS);
+    ExpectLaunch(1, CLIENT_TIMEOUT_TICKS);
+    ExpectLaunch(2, CLIENT_TIMEOUT_TICKS);
+    LONGS_EQUAL(I2C_WRAPPER_OK, I2CWrapper_LaunchDeviceTransaction(device, &client_descriptors[0]));
+    LONGS_EQUAL(I2C_WRAPPER_OK, I2CWrapper_LaunchDeviceTransaction(device, &client_descriptors[1]));
+    LONGS_EQUAL(I2C_WRAPPER_OK,
+                I2CWrapper_LaunchDeviceTransaction(other_device, &client_descriptors[2]));
+}
+
+TEST(I2CWrapperRegistry, ChangedSetupIsAppliedAgain)
+{
+    I2CWrapperDevice* device;
+    I2CWrapperDevice* fast_device;
+    I2CSetupInfo      fast_setup = default_setup;
+
+    LONGS_EQUAL(I2C_WRAPPER_OK, I2CWrapper_RegisterDevice(&device_profile, &device));
+    device_profile.mode    = I2C_FAST_MODE;
+    device_profile.address = DEVICE_ADDR + 1;
+    LONGS_EQUAL(I2C_WRAPPER_OK, I2CWrapper_RegisterDevice(&device_profile, &fast_device));
+    fast_setup.mode = I2C_FAST_MODE;
+
+    ExpectSetup(&default_setup);
+    ExpectLaunch(0, CLIENT_TIMEOUT_TICKS);
+    ExpectSetup(&fast_setup);
+    ExpectLaunch(1, CLIENT_TIMEOUT_TICKS);
+    ExpectSetup(&default_setup);
+    ExpectLaunch(2, CLIENT_TIMEOUT_TICKS);
+    LONGS_EQUAL(I2C_WRAPPER_OK, I2CWrapper_LaunchDeviceTransaction(device, &client_descriptors[0]));
+    LONGS_EQUAL(I2C_WRAPPER_OK,
+                I2CWrapper_LaunchDeviceTransaction(fast_device, &client_descriptors[1]));
+    LONGS_EQUAL(I2C_WRAPPER_OK, I2CWrapper_LaunchDeviceTransaction(device, &client_descriptors[2]));
+}
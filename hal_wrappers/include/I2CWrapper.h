@@ -13,17 +13,77 @@
 #ifndef __I2C_WRAPPER_H
 #define __I2C_WRAPPER_H
 
+#include "FreeRTOS.h"
+#include "event_groups.h"
 #include "I2C.h"
+#include "queue.h"
 
 typedef enum {
     I2C_WRAPPER_OK,
     I2C_WRAPPER_INVALID_INPUT_DATA,
-    I2C_WRAPPER_I2C_MUTEX_NOT_CREATED,
-    I2C_WRAPPER_I2C_MUTEX_UNAVAILABLE,
+    I2C_WRAPPER_SEMAPHORE_NOT_CREATED,
+    I2C_WRAPPER_TASK_NOT_CREATED,
+    I2C_WRAPPER_QUEUE_FULL,
     I2C_WRAPPER_I2C_ERROR,
+    I2C_WRAPPER_CRC_ERROR,
+    I2C_WRAPPER_TIMEOUT,
+    I2C_WRAPPER_REQUEST_PENDING,
+    I2C_WRAPPER_STEP_NOT_RUN,
+    I2C_WRAPPER_REGISTRY_FULL,
     I2C_WRAPPER_NB_OF_RETURN_CODES
 } I2CWrapperReturnCode;
 
+// Registered once per target, the controller is only set up again when the bus setup changes
+typedef struct {
+    I2CMode           mode;
+    const I2CTiming*  timing;          // Used instead of the mode timing when not NULL
+    I2CAddressingMode addressing_mode;
+    uint16_t          address;
+    I2CDataPath       data_path;       // Policy applied to every transfer of the device
+} I2CWrapperDeviceProfile;
+
+typedef struct I2CWrapperDevice I2CWrapperDevice;
+
+// How the completion of a submitted request is reported, on top of I2CWrapper_WaitI2CRequest
+typedef enum {
+    I2C_WRAPPER_NOTIFY_NONE,
+    I2C_WRAPPER_NOTIFY_CALLBACK,
+    I2C_WRAPPER_NOTIFY_QUEUE,
+    I2C_WRAPPER_NOTIFY_EVENT_GROUP
+} I2CWrapperNotification;
+
+// One transfer of a batch, the bus is kept for the delay before the next step
+typedef struct {
+    I2CTransactionDescriptor* descriptor;
+    uint32_t                  delay_ms;    // Up to I2C_WRAPPER_MAX_STEP_DELAY_MS, 20 by default
+    I2CWrapperReturnCode      return_code; // I2C_WRAPPER_STEP_NOT_RUN after a failed step
+} I2CWrapperBatchStep;
+
+typedef struct I2CWrapperRequest I2CWrapperRequest;
+
+// Runs in the bus manager task: keep it short, the next request waits for it
+typedef void (* I2CWrapperCallback)(I2CWrapperRequest* request);
+
+// Handle of a submitted transfer, owned by the caller until it is done
+struct I2CWrapperRequest {
+    I2CWrapperDevice*         device;                 // Or an explicit setup_info
+    I2CSetupInfo*             setup_info;
+    I2CTransactionDescriptor* transaction_descriptor; // Or a batch of steps
+    I2CWrapperBatchStep*      steps;
+    uint8_t                   step_count;
+    I2CScanDescriptor*        scan_descriptor;        // Set by the wrapper
+    I2CWrapperNotification    notification;
+    I2CWrapperCallback        callback;               // I2C_WRAPPER_NOTIFY_CALLBACK
+    QueueHandle_t             queue;                  // I2C_WRAPPER_NOTIFY_QUEUE, gets the handle
+    EventGroupHandle_t        event_group;            // I2C_WRAPPER_NOTIFY_EVENT_GROUP
+    EventBits_t               event_bits;
+    // Filled by the wrapper
+    UBaseType_t               priority;               // Of the submitting task, higher runs first
+    TaskHandle_t              waiter;                 // Task blocked in I2CWrapper_WaitI2CRequest
+    volatile bool             done;
+    I2CWrapperReturnCode      return_code;
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -32,12 +92,56 @@ I2CWrapperReturnCode I2CWrapper_Create(void);
 void I2CWrapper_Destroy(void);
 void I2CWrapper_SpiCallback(I2CReturnCode return_code);
 
-void I2CWrapper_I2CCallback(I2CReturnCode return_code);
+// I2C_WRAPPER_NOTIFY_QUEUE completions dropped on a full queue, the requests are done all the same
+uint32_t I2CWrapper_GetLostNotifications(void);
 
+void I2CWrapper_I2CCallback(void*         context,
+                            I2CReturnCode return_code,
+                            uint32_t      data_count,
+                            uint32_t      timestamp);
+
+// The profile is copied, *device is the handle of the transfers until it is unregistered
+extern I2CWrapperReturnCode (* I2CWrapper_RegisterDevice) (const I2CWrapperDeviceProfile* profile,
+                                                           I2CWrapperDevice**             device);
+extern I2CWrapperReturnCode (* I2CWrapper_UnregisterDevice) (I2CWrapperDevice* device);
+
+// The address, addressing mode and data path of the descriptor are set from the device profile
+extern I2CWrapperReturnCode (* I2CWrapper_LaunchDeviceTransaction) (I2CWrapperDevice* device,
+                                                                    I2CTransactionDescriptor*
+                                                                    transaction_descriptor);
+extern I2CWrapperReturnCode (* I2CWrapper_LaunchDeviceBatch) (I2CWrapperDevice*    device,
+                                                              I2CWrapperBatchStep* steps,
+                                                              uint8_t              step_count);
+
+// Queued for the bus manager task, ahead of the requests of lower priority tasks. The caller is
+// blocked until the transfer has run. A timing table must not change while it is in use.
+// A descriptor timeout of 0 is derived from the bus frequency, the byte count and
+// I2C_WRAPPER_CLOCK_STRETCH_MS, any other value is used as is, in RTOS ticks.
 extern I2CWrapperReturnCode (* I2CWrapper_LaunchI2CTransaction) (I2CSetupInfo* setup_info,
                                                                  I2CTransactionDescriptor*
                                                                  transaction_descriptor);
 
+// The steps run in order under one bus acquisition and one controller setup, no other request in
+// between. Stops at the first failed step, whose return code is returned.
+// Warning: the bus stays held during the step delays, delaying every other client by up to their
+// sum. Steps with a delay above I2C_WRAPPER_MAX_STEP_DELAY_MS are refused.
+extern I2CWrapperReturnCode (* I2CWrapper_LaunchI2CBatch) (I2CSetupInfo*        setup_info,
+                                                           I2CWrapperBatchStep* steps,
+                                                           uint8_t              step_count);
+
+// Queued like I2CWrapper_LaunchI2CTransaction but returns at once. The request storage and its
+// descriptor must stay valid until the request is done.
+extern I2CWrapperReturnCode (* I2CWrapper_SubmitI2CTransaction) (I2CWrapperRequest* request);
+
+// Returns I2C_WRAPPER_REQUEST_PENDING if the request is not done within timeout, 0 polls it
+extern I2CWrapperReturnCode (* I2CWrapper_WaitI2CRequest) (I2CWrapperRequest* request,
+                                                           TickType_t         timeout);
+
+// Probes scan_descriptor->first_address to last_address, a NACK costs one address byte on the bus
+// A probe_timeout of 0 is derived from the bus frequency like a transaction timeout
+extern I2CWrapperReturnCode (* I2CWrapper_ScanI2CBus) (I2CSetupInfo*      setup_info,
+                                                       I2CScanDescriptor* scan_descriptor);
+
 #ifdef __cplusplus
 }
 #endif
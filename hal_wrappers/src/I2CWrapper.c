@@ -16,77 +16,703 @@
 #include "Printer.h"
 #include "semphr.h"
 
-#define I2C_WRAPPER_I2C_TIMEOUT_MS 25
+// Transactions and scan probes are aborted by the HAL, I2C_TimeoutTick being called from the RTOS
+// tick hook. Their deadline is the bus time of their bytes plus this allowance for targets holding
+// SCL low.
+#ifndef I2C_WRAPPER_CLOCK_STRETCH_MS
+#define I2C_WRAPPER_CLOCK_STRETCH_MS 5
+#endif
 
-static SemaphoreHandle_t i2c_mutex;
-static StaticSemaphore_t i2c_mutex_buffer;
-static TaskHandle_t current_task_handle;
+// Requests waiting for the bus, one per blocked client task
+#ifndef I2C_WRAPPER_QUEUE_LENGTH
+#define I2C_WRAPPER_QUEUE_LENGTH 8
+#endif
 
+#ifndef I2C_WRAPPER_MAX_DEVICES
+#define I2C_WRAPPER_MAX_DEVICES 4
+#endif
+
+// Longest delay between two batch steps, the Si7021 conversion time. The batch keeps the bus
+// meanwhile: every other request waits for it.
+#ifndef I2C_WRAPPER_MAX_STEP_DELAY_MS
+#define I2C_WRAPPER_MAX_STEP_DELAY_MS 20
+#endif
+
+struct I2CWrapperDevice {
+    I2CWrapperDeviceProfile profile;
+    I2CSetupInfo            setup_info; // Master setup of the profile
+    bool                    registered;
+};
+
+static I2CWrapperDevice devices[I2C_WRAPPER_MAX_DEVICES];
+
+// Last setup applied by the bus manager, invalid after a failed I2C_SetupController
+static I2CSetupInfo applied_setup;
+static bool         setup_applied;
+
+// Sorted by decreasing priority, FIFO within a priority
+static I2CWrapperRequest* request_queue[I2C_WRAPPER_QUEUE_LENGTH];
+static uint8_t            request_count;
+static SemaphoreHandle_t  pending_requests;
+static StaticSemaphore_t  pending_requests_buffer;
+static TaskHandle_t       bus_manager_handle;
+static StaticTask_t       bus_manager_task;
+static StackType_t        bus_manager_stack[2 * configMINIMAL_STACK_SIZE];
+
+// Completions that did not fit in the queue of an I2C_WRAPPER_NOTIFY_QUEUE request
+static uint32_t lost_notifications;
+
+// Set by the bus manager while I2C_RecoverBus completes the aborted transaction from the task
+static volatile bool recovering_bus;
+
+static I2CWrapperReturnCode I2CWrapper_WaitForI2CCompletion(TickType_t backstop);
+static uint32_t I2CWrapper_BusFrequency(void);
+static TickType_t I2CWrapper_BusTimeout(uint64_t bytes);
+static TickType_t I2CWrapper_TransactionTimeout(
+    const I2CTransactionDescriptor* transaction_descriptor);
+static bool I2CWrapper_ValidDevice(const I2CWrapperDevice* device);
+static void I2CWrapper_ApplyProfile(const I2CWrapperDevice*   device,
+                                    I2CTransactionDescriptor* transaction_descriptor);
+static I2CWrapperReturnCode I2CWrapper_SetupController(I2CSetupInfo* setup_info);
+static bool I2CWrapper_ValidSteps(const I2CWrapperBatchStep* steps,
+                                  uint8_t                    step_count);
+static bool I2CWrapper_QueueRequest(I2CWrapperRequest* request);
+static I2CWrapperRequest* I2CWrapper_PopRequest(void);
+static I2CWrapperReturnCode I2CWrapper_SubmitRequest(I2CWrapperRequest* request);
+static I2CWrapperReturnCode I2CWrapper_RunTransaction(
+    I2CTransactionDescriptor* transaction_descriptor);
+static I2CWrapperReturnCode I2CWrapper_RunBatch(I2CWrapperRequest* request);
+static I2CWrapperReturnCode I2CWrapper_RunRequest(I2CWrapperRequest* request);
+static void I2CWrapper_CompleteRequest(I2CWrapperRequest* request,
+                                       I2CWrapperReturnCode return_code);
+static void I2CWrapper_BusManagerTask(void* pvParameters);
 static I2CWrapperReturnCode I2CWrapper_LaunchI2CTransfer_Implementation(
     I2CSetupInfo*             setup_info,
     I2CTransactionDescriptor* transaction_descriptor);
+static I2CWrapperReturnCode I2CWrapper_LaunchI2CBatch_Implementation(
+    I2CSetupInfo*        setup_info,
+    I2CWrapperBatchStep* steps,
+    uint8_t              step_count);
+static I2CWrapperReturnCode I2CWrapper_RegisterDevice_Implementation(
+    const I2CWrapperDeviceProfile* profile,
+    I2CWrapperDevice**             device);
+static I2CWrapperReturnCode I2CWrapper_UnregisterDevice_Implementation(I2CWrapperDevice* device);
+static I2CWrapperReturnCode I2CWrapper_LaunchDeviceTransaction_Implementation(
+    I2CWrapperDevice*         device,
+    I2CTransactionDescriptor* transaction_descriptor);
+static I2CWrapperReturnCode I2CWrapper_LaunchDeviceBatch_Implementation(
+    I2CWrapperDevice*    device,
+    I2CWrapperBatchStep* steps,
+    uint8_t              step_count);
+static I2CWrapperReturnCode I2CWrapper_SubmitI2CTransaction_Implementation(
+    I2CWrapperRequest* request);
+static I2CWrapperReturnCode I2CWrapper_WaitI2CRequest_Implementation(I2CWrapperRequest* request,
+                                                                     TickType_t         timeout);
+static I2CWrapperReturnCode I2CWrapper_ScanI2CBus_Implementation(I2CSetupInfo*      setup_info,
+                                                                 I2CScanDescriptor* scan_descriptor);
 
-static I2CWrapperReturnCode I2CWrapper_LaunchI2CTransfer_Implementation(
-    I2CSetupInfo*             setup_info,
-    I2CTransactionDescriptor* transaction_descriptor)
+// The backstop covers a missing tick hook, the HAL deadline normally expires first
+static I2CWrapperReturnCode I2CWrapper_WaitForI2CCompletion(TickType_t backstop)
 {
-    if ((setup_info == NULL) || (transaction_descriptor == NULL)) {
-        return I2C_WRAPPER_INVALID_INPUT_DATA;
+    uint32_t      notification_value;
+    I2CReturnCode ret;
+
+    if (xTaskNotifyWait(0x00, 0xffffffff, &notification_value, backstop) != pdTRUE) {
+        // Abort the transaction and free the bus for the next one
+        recovering_bus = true;
+        ret            = I2C_RecoverBus(HAL_I2C);
+        recovering_bus = false;
+        if (ret != I2C_OK) {
+            Printer_Printf(INFINITE_TIMEOUT, "Error %d in I2C_RecoverBus\n", ret);
+        }
+        // Drop a completion notified by the interrupt between the timeout and the recovery
+        xTaskNotifyStateClear(NULL);
+        return I2C_WRAPPER_TIMEOUT;
+    }
+    if (notification_value == I2C_CRC_ERROR) {
+        return I2C_WRAPPER_CRC_ERROR;
+    }
+    if (notification_value == I2C_TRANSACTION_TIMEOUT) {
+        return I2C_WRAPPER_TIMEOUT;
+    }
+    if (notification_value != I2C_OK) {
+        return I2C_WRAPPER_I2C_ERROR;
+    }
+    return I2C_WRAPPER_OK;
+}
+
+// SCL frequency of the applied setup, the maximum of its mode without a timing table
+static uint32_t I2CWrapper_BusFrequency(void)
+{
+    if ((applied_setup.timing != NULL) && (applied_setup.timing->scl_frequency != 0)) {
+        return applied_setup.timing->scl_frequency;
+    }
+    switch (applied_setup.mode) {
+        case I2C_FAST_MODE:
+            return I2C_FAST_MODE_MAX_FREQUENCY;
+
+        case I2C_FAST_MODE_PLUS:
+            return I2C_FAST_MODE_PLUS_MAX_FREQUENCY;
+
+        default:
+            return I2C_STANDARD_MODE_MAX_FREQUENCY;
     }
+}
+
+static TickType_t I2CWrapper_TransactionTimeout(
+    const I2CTransactionDescriptor* transaction_descriptor)
+{
+    uint32_t address_bytes =
+        (transaction_descriptor->addressing_mode == I2C_ADDRESSING_MODE_10_BIT) ? 2 : 1;
+    uint64_t bytes = address_bytes + transaction_descriptor->data_count;
 
-    if (xSemaphoreTake(i2c_mutex, IMMEDIATE_TIMEOUT) != pdPASS) {
-        return I2C_WRAPPER_I2C_MUTEX_UNAVAILABLE;
+    if (transaction_descriptor->segments != NULL) {
+        for (uint8_t i = 0; i < transaction_descriptor->segment_count; i++) {
+            bytes += transaction_descriptor->segments[i].data_count;
+        }
     }
+    if (transaction_descriptor->type == I2C_WRITE_READ_TRANSACTION) {
+        bytes += address_bytes + transaction_descriptor->rx_data_count;
+    }
+    return I2CWrapper_BusTimeout(bytes);
+}
+
+static TickType_t I2CWrapper_BusTimeout(uint64_t bytes)
+{
+    uint32_t scl_frequency = I2CWrapper_BusFrequency();
+    uint64_t bits;
+    uint64_t timeout_ms;
+
+    // 9 clocks per byte with its ACK, plus the START, repeated START and STOP conditions
+    bits       = 9 * bytes + 3;
+    timeout_ms = (bits * 1000 + scl_frequency - 1) / scl_frequency + I2C_WRAPPER_CLOCK_STRETCH_MS;
+
+    // Rounded up, plus one tick: the first I2C_TimeoutTick may come right after the launch
+    return (TickType_t) ((timeout_ms * configTICK_RATE_HZ + 999) / 1000) + 1;
+}
+
+static bool I2CWrapper_ValidDevice(const I2CWrapperDevice* device)
+{
+    return (device != NULL) && device->registered;
+}
 
-    I2CWrapperReturnCode return_code = I2C_WRAPPER_OK;
+static void I2CWrapper_ApplyProfile(const I2CWrapperDevice*   device,
+                                    I2CTransactionDescriptor* transaction_descriptor)
+{
+    transaction_descriptor->addressing_mode = device->profile.addressing_mode;
+    transaction_descriptor->address         = device->profile.address;
+    transaction_descriptor->data_path       = device->profile.data_path;
+}
+
+// Runs in the bus manager, the only task setting the controller up
+static I2CWrapperReturnCode I2CWrapper_SetupController(I2CSetupInfo* setup_info)
+{
     I2CReturnCode ret;
 
+    if (setup_applied &&
+        (setup_info->role == applied_setup.role) &&
+        (setup_info->mode == applied_setup.mode) &&
+        (setup_info->timing == applied_setup.timing)) {
+        return I2C_WRAPPER_OK;
+    }
+
+    setup_applied = false;
     if ((ret = I2C_SetupController(HAL_I2C, setup_info)) != I2C_OK) {
         Printer_Printf(INFINITE_TIMEOUT, "Error %d in I2C_SetupController\n", ret);
-        return_code = I2C_WRAPPER_I2C_ERROR;
-        goto give_mutex_and_return;
+        return I2C_WRAPPER_I2C_ERROR;
     }
+    applied_setup = *setup_info;
+    setup_applied = true;
 
-    current_task_handle              = xTaskGetCurrentTaskHandle();
-    transaction_descriptor->callback = I2CWrapper_I2CCallback;
+    return I2C_WRAPPER_OK;
+}
+
+static bool I2CWrapper_ValidSteps(const I2CWrapperBatchStep* steps,
+                                  uint8_t                    step_count)
+{
+    if ((steps == NULL) || (step_count == 0)) {
+        return false;
+    }
+    for (uint8_t i = 0; i < step_count; i++) {
+        if ((steps[i].descriptor == NULL) ||
+            (steps[i].delay_ms > I2C_WRAPPER_MAX_STEP_DELAY_MS)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool I2CWrapper_QueueRequest(I2CWrapperRequest* request)
+{
+    bool queued = false;
+
+    taskENTER_CRITICAL();
+    if (request_count < I2C_WRAPPER_QUEUE_LENGTH) {
+        uint8_t i = request_count;
+
+        // Behind the requests of the same or a higher priority
+        while ((i > 0) && (request_queue[i - 1]->priority < request->priority)) {
+            request_queue[i] = request_queue[i - 1];
+            i--;
+        }
+        request_queue[i] = request;
+        request_count++;
+        queued = true;
+    }
+    taskEXIT_CRITICAL();
+
+    if (queued) {
+        xSemaphoreGive(pending_requests);
+    }
+    return queued;
+}
+
+// Only called by the bus manager after taking pending_requests: the queue is not empty
+static I2CWrapperRequest* I2CWrapper_PopRequest(void)
+{
+    taskENTER_CRITICAL();
+    I2CWrapperRequest* request = request_queue[0];
+
+    request_count--;
+    for (uint8_t i = 0; i < request_count; i++) {
+        request_queue[i] = request_queue[i + 1];
+    }
+    taskEXIT_CRITICAL();
+
+    return request;
+}
+
+static I2CWrapperReturnCode I2CWrapper_SubmitRequest(I2CWrapperRequest* request)
+{
+    request->priority    = uxTaskPriorityGet(NULL);
+    request->waiter      = NULL;
+    request->done        = false;
+    request->return_code = I2C_WRAPPER_REQUEST_PENDING;
+    for (uint8_t i = 0; i < request->step_count; i++) {
+        request->steps[i].return_code = I2C_WRAPPER_STEP_NOT_RUN;
+        if (request->device != NULL) {
+            I2CWrapper_ApplyProfile(request->device, request->steps[i].descriptor);
+        }
+    }
+    if ((request->device != NULL) && (request->transaction_descriptor != NULL)) {
+        I2CWrapper_ApplyProfile(request->device, request->transaction_descriptor);
+    }
+
+    if (!I2CWrapper_QueueRequest(request)) {
+        return I2C_WRAPPER_QUEUE_FULL;
+    }
+    return I2C_WRAPPER_OK;
+}
+
+static I2CWrapperReturnCode I2CWrapper_RunTransaction(
+    I2CTransactionDescriptor* transaction_descriptor)
+{
+    I2CReturnCode        ret;
+    I2CWrapperReturnCode return_code;
+    uint32_t             caller_timeout = transaction_descriptor->timeout;
+
+    // The bus manager is the callback context: no global state for the waiter
+    transaction_descriptor->context_callback = I2CWrapper_I2CCallback;
+    transaction_descriptor->context          = bus_manager_handle;
+    if (caller_timeout == 0) {
+        transaction_descriptor->timeout = I2CWrapper_TransactionTimeout(transaction_descriptor);
+    }
 
     if ((ret = I2C_LaunchTransaction(HAL_I2C, transaction_descriptor)) != I2C_OK) {
         Printer_Printf(INFINITE_TIMEOUT, "Error %d in I2C_LaunchTransaction\n", ret);
         return_code = I2C_WRAPPER_I2C_ERROR;
-        goto give_mutex_and_return;
+    } else {
+        return_code = I2CWrapper_WaitForI2CCompletion(2 * transaction_descriptor->timeout);
     }
 
-    uint32_t notification_value;
+    // Computed again for the next run of the descriptor, whose data count may change
+    transaction_descriptor->timeout = caller_timeout;
+    return return_code;
+}
 
-    if (xTaskNotifyWait(0x00,
-                        0xffffffff,
-                        &notification_value,
-                        pdMS_TO_TICKS(I2C_WRAPPER_I2C_TIMEOUT_MS)) != pdTRUE) {
-        return_code = I2C_WRAPPER_I2C_ERROR;
-        goto give_mutex_and_return;
+// The bus manager runs nothing else until the last step: the delays keep the bus
+static I2CWrapperReturnCode I2CWrapper_RunBatch(I2CWrapperRequest* request)
+{
+    for (uint8_t i = 0; i < request->step_count; i++) {
+        I2CWrapperBatchStep* step = &request->steps[i];
+
+        if ((step->return_code = I2CWrapper_RunTransaction(step->descriptor)) != I2C_WRAPPER_OK) {
+            return step->return_code;
+        }
+        if ((step->delay_ms != 0) && (i < request->step_count - 1)) {
+            vTaskDelay(pdMS_TO_TICKS(step->delay_ms));
+        }
     }
-    if (notification_value != I2C_OK) {
-        return_code = I2C_WRAPPER_I2C_ERROR;
-        goto give_mutex_and_return;
+    return I2C_WRAPPER_OK;
+}
+
+static I2CWrapperReturnCode I2CWrapper_RunRequest(I2CWrapperRequest* request)
+{
+    I2CWrapperReturnCode return_code;
+    I2CReturnCode        ret;
+
+    if ((return_code =
+             I2CWrapper_SetupController((request->device != NULL) ?
+                                        &request->device->setup_info :
+                                        request->setup_info)) != I2C_WRAPPER_OK) {
+        return return_code;
     }
 
-give_mutex_and_return:
-    xSemaphoreGive(i2c_mutex);
-    return return_code;
+    if (request->scan_descriptor != NULL) {
+        I2CScanDescriptor* scan_descriptor = request->scan_descriptor;
+        uint32_t           caller_timeout  = scan_descriptor->probe_timeout;
+        uint32_t           probes          =
+            (uint32_t) scan_descriptor->last_address - scan_descriptor->first_address + 1;
+
+        // The whole range is probed by the HAL: one request and one notification
+        scan_descriptor->context_callback = I2CWrapper_I2CCallback;
+        scan_descriptor->context          = bus_manager_handle;
+        if (caller_timeout == 0) {
+            // An address byte per probe
+            scan_descriptor->probe_timeout = I2CWrapper_BusTimeout(1);
+        }
+
+        if ((ret = I2C_ScanBus(HAL_I2C, scan_descriptor)) != I2C_OK) {
+            Printer_Printf(INFINITE_TIMEOUT, "Error %d in I2C_ScanBus\n", ret);
+            return_code = I2C_WRAPPER_I2C_ERROR;
+        } else {
+            return_code = I2CWrapper_WaitForI2CCompletion(2 * probes *
+                                                          scan_descriptor->probe_timeout);
+        }
+        scan_descriptor->probe_timeout = caller_timeout;
+        return return_code;
+    }
+    if (request->steps != NULL) {
+        return I2CWrapper_RunBatch(request);
+    }
+    return I2CWrapper_RunTransaction(request->transaction_descriptor);
+}
+
+// Sole user of the controller: requests run one at a time, highest client priority first
+static void I2CWrapper_BusManagerTask(void* pvParameters)
+{
+    UNUSED(pvParameters);
+
+    while (1) {
+        xSemaphoreTake(pending_requests, INFINITE_TIMEOUT);
+
+        I2CWrapperRequest* request = I2CWrapper_PopRequest();
+
+        I2CWrapper_CompleteRequest(request, I2CWrapper_RunRequest(request));
+    }
+}
+
+// The request belongs to the caller again once done is set: nothing is read from it afterwards
+static void I2CWrapper_CompleteRequest(I2CWrapperRequest*   request,
+                                       I2CWrapperReturnCode return_code)
+{
+    request->return_code = return_code;
+
+    switch (request->notification) {
+        case I2C_WRAPPER_NOTIFY_CALLBACK:
+            request->callback(request);
+            break;
+
+        case I2C_WRAPPER_NOTIFY_QUEUE:
+            // Sized by the caller for its requests in flight: never blocks the bus manager
+            if (xQueueSend(request->queue, &request, IMMEDIATE_TIMEOUT) != pdPASS) {
+                lost_notifications++;
+                Printer_Printf(INFINITE_TIMEOUT,
+                               "Error in xQueueSend, request %p\n",
+                               (void*) request);
+            }
+            break;
+
+        case I2C_WRAPPER_NOTIFY_EVENT_GROUP:
+            xEventGroupSetBits(request->event_group, request->event_bits);
+            break;
+
+        default:
+            break;
+    }
+
+    taskENTER_CRITICAL();
+    TaskHandle_t waiter = request->waiter;
+
+    request->done = true;
+    taskEXIT_CRITICAL();
+
+    if (waiter != NULL) {
+        xTaskNotifyGive(waiter);
+    }
+}
+
+static I2CWrapperReturnCode I2CWrapper_LaunchI2CTransfer_Implementation(
+    I2CSetupInfo*             setup_info,
+    I2CTransactionDescriptor* transaction_descriptor)
+{
+    if ((setup_info == NULL) || (transaction_descriptor == NULL)) {
+        return I2C_WRAPPER_INVALID_INPUT_DATA;
+    }
+
+    I2CWrapperRequest request = {
+        .device                 = NULL,
+        .setup_info             = setup_info,
+        .transaction_descriptor = transaction_descriptor,
+        .steps                  = NULL,
+        .step_count             = 0,
+        .scan_descriptor        = NULL,
+        .notification           = I2C_WRAPPER_NOTIFY_NONE,
+    };
+    I2CWrapperReturnCode return_code;
+
+    if ((return_code = I2CWrapper_SubmitRequest(&request)) != I2C_WRAPPER_OK) {
+        return return_code;
+    }
+    // Always answered: the HAL and backstop timeouts bound the time a request holds the bus
+    return I2CWrapper_WaitI2CRequest_Implementation(&request, INFINITE_TIMEOUT);
+}
+
+static I2CWrapperReturnCode I2CWrapper_LaunchI2CBatch_Implementation(
+    I2CSetupInfo*        setup_info,
+    I2CWrapperBatchStep* steps,
+    uint8_t              step_count)
+{
+    if ((setup_info == NULL) || (!I2CWrapper_ValidSteps(steps, step_count))) {
+        return I2C_WRAPPER_INVALID_INPUT_DATA;
+    }
+
+    I2CWrapperRequest request = {
+        .device                 = NULL,
+        .setup_info             = setup_info,
+        .transaction_descriptor = NULL,
+        .steps                  = steps,
+        .step_count             = step_count,
+        .scan_descriptor        = NULL,
+        .notification           = I2C_WRAPPER_NOTIFY_NONE,
+    };
+    I2CWrapperReturnCode return_code;
+
+    if ((return_code = I2CWrapper_SubmitRequest(&request)) != I2C_WRAPPER_OK) {
+        return return_code;
+    }
+    return I2CWrapper_WaitI2CRequest_Implementation(&request, INFINITE_TIMEOUT);
+}
+
+static I2CWrapperReturnCode I2CWrapper_RegisterDevice_Implementation(
+    const I2CWrapperDeviceProfile* profile,
+    I2CWrapperDevice**             device)
+{
+    if ((profile == NULL) || (device == NULL)) {
+        return I2C_WRAPPER_INVALID_INPUT_DATA;
+    }
+
+    I2CWrapperDevice* free_device = NULL;
+
+    taskENTER_CRITICAL();
+    for (uint8_t i = 0; i < I2C_WRAPPER_MAX_DEVICES; i++) {
+        if (!devices[i].registered) {
+            free_device             = &devices[i];
+            free_device->registered = true;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if (free_device == NULL) {
+        return I2C_WRAPPER_REGISTRY_FULL;
+    }
+
+    free_device->profile           = *profile;
+    free_device->setup_info.role   = I2C_MASTER;
+    free_device->setup_info.mode   = profile->mode;
+    free_device->setup_info.timing = profile->timing;
+    *device                        = free_device;
+
+    return I2C_WRAPPER_OK;
+}
+
+// The device must have no request in progress
+static I2CWrapperReturnCode I2CWrapper_UnregisterDevice_Implementation(I2CWrapperDevice* device)
+{
+    if (!I2CWrapper_ValidDevice(device)) {
+        return I2C_WRAPPER_INVALID_INPUT_DATA;
+    }
+
+    device->registered = false;
+
+    return I2C_WRAPPER_OK;
+}
+
+static I2CWrapperReturnCode I2CWrapper_LaunchDeviceTransaction_Implementation(
+    I2CWrapperDevice*         device,
+    I2CTransactionDescriptor* transaction_descriptor)
+{
+    if ((!I2CWrapper_ValidDevice(device)) || (transaction_descriptor == NULL)) {
+        return I2C_WRAPPER_INVALID_INPUT_DATA;
+    }
+
+    I2CWrapperRequest request = {
+        .device                 = device,
+        .setup_info             = NULL,
+        .transaction_descriptor = transaction_descriptor,
+        .steps                  = NULL,
+        .step_count             = 0,
+        .scan_descriptor        = NULL,
+        .notification           = I2C_WRAPPER_NOTIFY_NONE,
+    };
+    I2CWrapperReturnCode return_code;
+
+    if ((return_code = I2CWrapper_SubmitRequest(&request)) != I2C_WRAPPER_OK) {
+        return return_code;
+    }
+    return I2CWrapper_WaitI2CRequest_Implementation(&request, INFINITE_TIMEOUT);
+}
+
+static I2CWrapperReturnCode I2CWrapper_LaunchDeviceBatch_Implementation(
+    I2CWrapperDevice*    device,
+    I2CWrapperBatchStep* steps,
+    uint8_t              step_count)
+{
+    if ((!I2CWrapper_ValidDevice(device)) || (!I2CWrapper_ValidSteps(steps, step_count))) {
+        return I2C_WRAPPER_INVALID_INPUT_DATA;
+    }
+
+    I2CWrapperRequest request = {
+        .device                 = device,
+        .setup_info             = NULL,
+        .transaction_descriptor = NULL,
+        .steps                  = steps,
+        .step_count             = step_count,
+        .scan_descriptor        = NULL,
+        .notification           = I2C_WRAPPER_NOTIFY_NONE,
+    };
+    I2CWrapperReturnCode return_code;
+
+    if ((return_code = I2CWrapper_SubmitRequest(&request)) != I2C_WRAPPER_OK) {
+        return return_code;
+    }
+    return I2CWrapper_WaitI2CRequest_Implementation(&request, INFINITE_TIMEOUT);
+}
+
+static I2CWrapperReturnCode I2CWrapper_SubmitI2CTransaction_Implementation(
+    I2CWrapperRequest* request)
+{
+    if ((request == NULL) ||
+        ((request->device != NULL) && (!I2CWrapper_ValidDevice(request->device))) ||
+        ((request->device == NULL) && (request->setup_info == NULL)) ||
+        ((request->transaction_descriptor == NULL) &&
+         (!I2CWrapper_ValidSteps(request->steps, request->step_count))) ||
+        ((request->notification == I2C_WRAPPER_NOTIFY_CALLBACK) && (request->callback == NULL)) ||
+        ((request->notification == I2C_WRAPPER_NOTIFY_QUEUE) && (request->queue == NULL)) ||
+        ((request->notification == I2C_WRAPPER_NOTIFY_EVENT_GROUP) &&
+         (request->event_group == NULL))) {
+        return I2C_WRAPPER_INVALID_INPUT_DATA;
+    }
+
+    // A descriptor takes precedence over the steps
+    if (request->transaction_descriptor != NULL) {
+        request->steps      = NULL;
+        request->step_count = 0;
+    }
+    request->scan_descriptor = NULL;
+
+    return I2CWrapper_SubmitRequest(request);
+}
+
+static I2CWrapperReturnCode I2CWrapper_WaitI2CRequest_Implementation(I2CWrapperRequest* request,
+                                                                     TickType_t         timeout)
+{
+    if (request == NULL) {
+        return I2C_WRAPPER_INVALID_INPUT_DATA;
+    }
+
+    TimeOut_t time_out;
+
+    vTaskSetTimeOutState(&time_out);
+    while (1) {
+        taskENTER_CRITICAL();
+        bool done = request->done;
+
+        request->waiter = done ? NULL : xTaskGetCurrentTaskHandle();
+        taskEXIT_CRITICAL();
+
+        if (done) {
+            return request->return_code;
+        }
+        // A notification left by an earlier wait that timed out only costs one more loop
+        if (xTaskCheckForTimeOut(&time_out, &timeout) != pdFALSE) {
+            break;
+        }
+        ulTaskNotifyTake(pdTRUE, timeout);
+    }
+
+    taskENTER_CRITICAL();
+    request->waiter = NULL;
+    taskEXIT_CRITICAL();
+
+    return request->done ? request->return_code : I2C_WRAPPER_REQUEST_PENDING;
+}
+
+static I2CWrapperReturnCode I2CWrapper_ScanI2CBus_Implementation(I2CSetupInfo*      setup_info,
+                                                                 I2CScanDescriptor* scan_descriptor)
+{
+    if ((setup_info == NULL) || (scan_descriptor == NULL)) {
+        return I2C_WRAPPER_INVALID_INPUT_DATA;
+    }
+
+    I2CWrapperRequest request = {
+        .device                 = NULL,
+        .setup_info             = setup_info,
+        .transaction_descriptor = NULL,
+        .steps                  = NULL,
+        .step_count             = 0,
+        .scan_descriptor        = scan_descriptor,
+        .notification           = I2C_WRAPPER_NOTIFY_NONE,
+    };
+    I2CWrapperReturnCode return_code;
+
+    if ((return_code = I2CWrapper_SubmitRequest(&request)) != I2C_WRAPPER_OK) {
+        return return_code;
+    }
+    return I2CWrapper_WaitI2CRequest_Implementation(&request, INFINITE_TIMEOUT);
 }
 
 I2CWrapperReturnCode I2CWrapper_Create(void)
 {
-    i2c_mutex = xSemaphoreCreateMutexStatic(&i2c_mutex_buffer);
-    if (i2c_mutex == NULL) {
-        return I2C_WRAPPER_I2C_MUTEX_NOT_CREATED;
+    for (uint8_t i = 0; i < I2C_WRAPPER_MAX_DEVICES; i++) {
+        devices[i].registered = false;
+    }
+    setup_applied      = false;
+    request_count      = 0;
+    lost_notifications = 0;
+    recovering_bus     = false;
+    pending_requests   = xSemaphoreCreateCountingStatic(I2C_WRAPPER_QUEUE_LENGTH,
+                                                        0,
+                                                        &pending_requests_buffer);
+    if (pending_requests == NULL) {
+        return I2C_WRAPPER_SEMAPHORE_NOT_CREATED;
+    }
+
+    bus_manager_handle = xTaskCreateStatic(I2CWrapper_BusManagerTask,
+                                           "I2C_bus_manager",
+                                           2 * configMINIMAL_STACK_SIZE,
+                                           NULL,
+                                           I2C_WRAPPER_TASK_PRIORITY,
+                                           bus_manager_stack,
+                                           &bus_manager_task);
+
+    if (bus_manager_handle == NULL) {
+        vSemaphoreDelete(pending_requests);
+        return I2C_WRAPPER_TASK_NOT_CREATED;
     }
     return I2C_WRAPPER_OK;
 }
 
 void I2CWrapper_Destroy(void)
 {
-    vSemaphoreDelete(i2c_mutex);
+    vTaskDelete(bus_manager_handle);
+    vSemaphoreDelete(pending_requests);
+}
+
+uint32_t I2CWrapper_GetLostNotifications(void)
+{
+    return lost_notifications;
 }
 
 I2CWrapperReturnCode (* I2CWrapper_LaunchI2CTransaction) (I2CSetupInfo* setup_info,
@@ -94,20 +720,59 @@ I2CWrapperReturnCode (* I2CWrapper_LaunchI2CTransaction) (I2CSetupInfo* setup_in
                                                           transaction_descriptor) =
     I2CWrapper_LaunchI2CTransfer_Implementation;
 
-void I2CWrapper_I2CCallback(I2CReturnCode return_code)
+I2CWrapperReturnCode (* I2CWrapper_LaunchI2CBatch) (I2CSetupInfo*        setup_info,
+                                                    I2CWrapperBatchStep* steps,
+                                                    uint8_t              step_count) =
+    I2CWrapper_LaunchI2CBatch_Implementation;
+
+I2CWrapperReturnCode (* I2CWrapper_RegisterDevice) (const I2CWrapperDeviceProfile* profile,
+                                                    I2CWrapperDevice**             device) =
+    I2CWrapper_RegisterDevice_Implementation;
+
+I2CWrapperReturnCode (* I2CWrapper_UnregisterDevice) (I2CWrapperDevice* device) =
+    I2CWrapper_UnregisterDevice_Implementation;
+
+I2CWrapperReturnCode (* I2CWrapper_LaunchDeviceTransaction) (I2CWrapperDevice*         device,
+                                                             I2CTransactionDescriptor*
+                                                             transaction_descriptor) =
+    I2CWrapper_LaunchDeviceTransaction_Implementation;
+
+I2CWrapperReturnCode (* I2CWrapper_LaunchDeviceBatch) (I2CWrapperDevice*    device,
+                                                       I2CWrapperBatchStep* steps,
+                                                       uint8_t              step_count) =
+    I2CWrapper_LaunchDeviceBatch_Implementation;
+
+I2CWrapperReturnCode (* I2CWrapper_SubmitI2CTransaction) (I2CWrapperRequest* request) =
+    I2CWrapper_SubmitI2CTransaction_Implementation;
+
+I2CWrapperReturnCode (* I2CWrapper_WaitI2CRequest) (I2CWrapperRequest* request,
+                                                    TickType_t         timeout) =
+    I2CWrapper_WaitI2CRequest_Implementation;
+
+I2CWrapperReturnCode (* I2CWrapper_ScanI2CBus) (I2CSetupInfo*      setup_info,
+                                                I2CScanDescriptor* scan_descriptor) =
+    I2CWrapper_ScanI2CBus_Implementation;
+
+void I2CWrapper_I2CCallback(void*         context,
+                            I2CReturnCode return_code,
+                            uint32_t      data_count,
+                            uint32_t      timestamp)
 {
-    if (current_task_handle == NULL) {
+    UNUSED(data_count);
+    UNUSED(timestamp);
+
+    // Transaction aborted by I2C_RecoverBus, called from the bus manager: no FromISR call from a
+    // task, and the bus manager already returns I2C_WRAPPER_TIMEOUT
+    if (recovering_bus) {
         return;
     }
 
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
 
-    xTaskNotifyFromISR(current_task_handle,
+    xTaskNotifyFromISR((TaskHandle_t) context,
                        return_code,
                        eSetValueWithOverwrite,
                        &xHigherPriorityTaskWoken);
 
-    current_task_handle = NULL;
-
     portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
@@ -33,7 +33,7 @@
 #define SI7021_MEASRH_NOHOLD_RSP_LEN 3
 #define SI7021_MEASRH_DELAY          20 // ms
 
-#define SI7021_CRC8_POLY             0x13100 // CRC8 (16bits) -> x^8 + x^5 + x^4 + 1
+#define SI7021_CRC8_POLYNOMIAL       0x31 // x^8 + x^5 + x^4 + 1
 #define SI7021_MAX_READ_VAL_ATTEMPTS 4
 
 #ifdef __cplusplus
@@ -46,6 +46,7 @@ typedef enum {
     SI7021_MUTEX_NOT_CREATED,
     SI7021_TASK_NOT_CREATED,
     SI7021_MUTEX_UNAVAILABLE,
+    SI7021_DEVICE_NOT_REGISTERED,
     SI7021_I2C_ERROR,
     SI7021_CHECKSUM_ERROR,
     SI7021_NB_OF_RETURN_CODES
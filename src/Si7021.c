@@ -36,39 +36,14 @@ typedef struct {
     StaticTask_t           task;
     StackType_t            task_stack[2 * configMINIMAL_STACK_SIZE];
     TaskHandle_t           task_handle;
-    uint16_t               addr;
+    I2CWrapperDevice*      device;         // From the first Si7021_Acquire to Si7021_Destroy
+    uint16_t               device_address; // Of the registered profile
     Si7021FirmwareRevision fw_revision;
     uint8_t                cmd_buffer[SI7021_MAX_CMD_LENGTH];
     uint8_t                rsp_buffer[SI7021_MAX_RSP_LENGTH];
 } Si7021Info;
 
-static Si7021Info   _Si7021;
-static I2CSetupInfo setup_info = {
-    .role = I2C_MASTER,
-    .mode = I2C_STANDARD_MODE,
-};
-
-static I2CTransactionDescriptor transaction_descriptor = {
-    .direction       = I2C_RX,
-    .addressing_mode = I2C_ADDRESSING_MODE_7_BIT,
-    .address         = 0x80,
-    .data_path       = I2C_USE_FIFO,
-    .data            = NULL,
-    .data_count      = 0,
-    .callback        = NULL
-};
-
-static uint8_t Si7021_ComputeCRC8(uint16_t data)
-{
-    for (uint8_t bit = 0; bit < 16; bit++) {
-        if (data & 0x8000) {
-            data = (data << 1) ^ SI7021_CRC8_POLY;
-        } else {
-            data <<= 1;
-        }
-    }
-    return data >>= 8;
-}
+static Si7021Info _Si7021;
 
 static float Si7021_ConvertTemp(uint16_t temp_code)
 {
@@ -91,15 +66,57 @@ static float Si7021_ConvertHumidity(uint16_t rh_code)
     return (humidity > 100.0) ? 100.0 : humidity;
 }
 
+// The address, addressing mode and data path come from the registered device profile
+static I2CTransactionDescriptor Si7021_WriteDescriptor(uint8_t* data,
+                                                       uint16_t data_length)
+{
+    I2CTransactionDescriptor descriptor = {
+        .type       = I2C_SIMPLE_TRANSACTION,
+        .direction  = I2C_TX,
+        .data       = data,
+        .data_count = data_length,
+        .crc        = I2C_CRC_NONE,
+    };
+
+    return descriptor;
+}
+
+static I2CTransactionDescriptor Si7021_ReadDescriptor(uint8_t* data,
+                                                      uint16_t data_length)
+{
+    I2CTransactionDescriptor descriptor = {
+        .type           = I2C_SIMPLE_TRANSACTION,
+        .direction      = I2C_RX,
+        .data           = data,
+        .data_count     = data_length,
+        .crc            = I2C_CRC_DATA, // Checked by the HAL as bytes arrive
+        .crc_polynomial = SI7021_CRC8_POLYNOMIAL,
+    };
+
+    return descriptor;
+}
+
+static Si7021ReturnCode Si7021_ReadReturnCode(I2CWrapperReturnCode return_code)
+{
+    switch (return_code) {
+        case I2C_WRAPPER_OK:
+            return SI7021_OK;
+
+        case I2C_WRAPPER_CRC_ERROR:
+            SI7021_ERROR("CRC Check Failed");
+            return SI7021_CHECKSUM_ERROR;
+
+        default:
+            return SI7021_I2C_ERROR;
+    }
+}
+
 static Si7021ReturnCode Si7021_Write(uint8_t* data,
                                      uint16_t data_length)
 {
-    transaction_descriptor.direction  = I2C_TX;
-    transaction_descriptor.address    = _Si7021.addr;
-    transaction_descriptor.data       = data;
-    transaction_descriptor.data_count = data_length;
+    I2CTransactionDescriptor descriptor = Si7021_WriteDescriptor(data, data_length);
 
-    if (I2CWrapper_LaunchI2CTransaction(&setup_info, &transaction_descriptor) != I2C_WRAPPER_OK) {
+    if (I2CWrapper_LaunchDeviceTransaction(_Si7021.device, &descriptor) != I2C_WRAPPER_OK) {
         return SI7021_I2C_ERROR;
     }
     return SI7021_OK;
@@ -108,17 +125,59 @@ static Si7021ReturnCode Si7021_Write(uint8_t* data,
 static Si7021ReturnCode Si7021_Read(uint8_t* data,
                                     uint16_t data_length)
 {
-    transaction_descriptor.direction  = I2C_RX;
-    transaction_descriptor.address    = _Si7021.addr;
-    transaction_descriptor.data       = data;
-    transaction_descriptor.data_count = data_length;
+    I2CTransactionDescriptor descriptor = Si7021_ReadDescriptor(data, data_length);
 
-    if (I2CWrapper_LaunchI2CTransaction(&setup_info, &transaction_descriptor) != I2C_WRAPPER_OK) {
+    return Si7021_ReadReturnCode(I2CWrapper_LaunchDeviceTransaction(_Si7021.device, &descriptor));
+}
+
+static Si7021ReturnCode Si7021_WriteRead(uint8_t* tx_data,
+                                         uint16_t tx_data_length,
+                                         uint8_t* rx_data,
+                                         uint16_t rx_data_length)
+{
+    I2CTransactionDescriptor descriptor = {
+        .type          = I2C_WRITE_READ_TRANSACTION,
+        .direction     = I2C_TX,
+        .data          = tx_data,
+        .data_count    = tx_data_length,
+        .rx_data       = rx_data,
+        .rx_data_count = rx_data_length,
+        .crc           = I2C_CRC_NONE,
+    };
+
+    if (I2CWrapper_LaunchDeviceTransaction(_Si7021.device, &descriptor) != I2C_WRAPPER_OK) {
         return SI7021_I2C_ERROR;
     }
     return SI7021_OK;
 }
 
+// The wrapper keeps the profile: registered again only for another address
+static Si7021ReturnCode Si7021_RegisterDevice(uint16_t i2c_addr)
+{
+    if ((_Si7021.device != NULL) && (_Si7021.device_address == i2c_addr)) {
+        return SI7021_OK;
+    }
+
+    I2CWrapperDeviceProfile profile = {
+        .mode            = I2C_STANDARD_MODE,
+        .timing          = NULL,
+        .addressing_mode = I2C_ADDRESSING_MODE_7_BIT,
+        .address         = i2c_addr,
+        .data_path       = I2C_USE_AUTO,
+    };
+
+    if (_Si7021.device != NULL) {
+        I2CWrapper_UnregisterDevice(_Si7021.device);
+        _Si7021.device = NULL;
+    }
+    if (I2CWrapper_RegisterDevice(&profile, &_Si7021.device) != I2C_WRAPPER_OK) {
+        return SI7021_DEVICE_NOT_REGISTERED;
+    }
+    _Si7021.device_address = i2c_addr;
+
+    return SI7021_OK;
+}
+
 static Si7021ReturnCode Si7021_Reset(void)
 {
     _Si7021.cmd_buffer[0] = SI7021_RESET_CMD;
@@ -138,21 +197,41 @@ static Si7021ReturnCode Si7021_PerformMeasurement(uint8_t  cmd_id,
     Si7021ReturnCode return_code = SI7021_OK;
 
     _Si7021.cmd_buffer[0] = cmd_id;
-    if ((return_code =
-             Si7021_Write(_Si7021.cmd_buffer, 1)) != SI7021_OK) {
-        SI7021_ERROR("Write() - Command %d Failed/n", cmd_id);
-        return return_code;
-    }
-
-    vTaskDelay(pdMS_TO_TICKS(delay));
     for (uint8_t i = 0; i < rsp_len; i++) {
         _Si7021.rsp_buffer[i] = 0x00;
     }
-    uint8_t read_attempts = 0;
-    do {
+    I2CTransactionDescriptor command_descriptor = Si7021_WriteDescriptor(_Si7021.cmd_buffer, 1);
+    I2CTransactionDescriptor read_descriptor    = Si7021_ReadDescriptor(_Si7021.rsp_buffer,
+                                                                        rsp_len);
+
+    // Command, conversion time and first read without another client in between
+    I2CWrapperBatchStep steps[] = {
+        {
+            .descriptor  = &command_descriptor,
+            .delay_ms    = delay,
+            .return_code = I2C_WRAPPER_STEP_NOT_RUN,
+        },
+        {
+            .descriptor  = &read_descriptor,
+            .delay_ms    = 0,
+            .return_code = I2C_WRAPPER_STEP_NOT_RUN,
+        },
+    };
+
+    I2CWrapper_LaunchDeviceBatch(_Si7021.device, steps, 2);
+    if (steps[0].return_code != I2C_WRAPPER_OK) {
+        SI7021_ERROR("Write() - Command %d Failed/n", cmd_id);
+        return SI7021_I2C_ERROR;
+    }
+
+    // The Si7021 NACKs the read until the conversion is over
+    return_code = Si7021_ReadReturnCode(steps[1].return_code);
+    uint8_t read_attempts = 1;
+    while ((return_code == SI7021_I2C_ERROR) &&
+           (read_attempts++ < SI7021_MAX_READ_VAL_ATTEMPTS)) {
         return_code =
             Si7021_Read(_Si7021.rsp_buffer, rsp_len);
-    } while ((return_code != SI7021_OK) && (read_attempts++ < SI7021_MAX_READ_VAL_ATTEMPTS - 1));
+    }
 
     return return_code;
 }
@@ -197,6 +276,8 @@ static void Si7021Task(void* pvParameters)
 
 Si7021ReturnCode Si7021_Create(void)
 {
+    _Si7021.device = NULL;
+
     _Si7021.mutex = xSemaphoreCreateMutexStatic(&(_Si7021.mutex_buffer));
     if (_Si7021.mutex == NULL) {
         return SI7021_MUTEX_NOT_CREATED;
@@ -220,6 +301,10 @@ Si7021ReturnCode Si7021_Create(void)
 void Si7021_Destroy(void)
 {
     vTaskDelete(_Si7021.task_handle);
+    if (_Si7021.device != NULL) {
+        I2CWrapper_UnregisterDevice(_Si7021.device);
+        _Si7021.device = NULL;
+    }
     vSemaphoreDelete(_Si7021.mutex);
 }
 
@@ -235,7 +320,10 @@ Si7021ReturnCode Si7021_Acquire(uint16_t i2c_addr)
 
     Si7021ReturnCode return_code = SI7021_OK;
 
-    _Si7021.addr = i2c_addr;
+    if ((return_code = Si7021_RegisterDevice(i2c_addr)) != SI7021_OK) {
+        xSemaphoreGive(_Si7021.mutex);
+        return return_code;
+    }
 
     if ((return_code = Si7021_Reset()) != SI7021_OK) {
         xSemaphoreGive(_Si7021.mutex);
@@ -244,6 +332,7 @@ Si7021ReturnCode Si7021_Acquire(uint16_t i2c_addr)
     return return_code;
 }
 
+// The device stays registered for the next Si7021_Acquire
 void Si7021_Release(void)
 {
     xSemaphoreGive(_Si7021.mutex);
@@ -264,14 +353,11 @@ Si7021ReturnCode Si7021_ReadRevision(Si7021FirmwareRevision* fw_revision)
     _Si7021.cmd_buffer[0] = SI7021_REVISION_CMD >> 8;
     _Si7021.cmd_buffer[1] = SI7021_REVISION_CMD & 0xFF;
 
-    if ((return_code =
-             Si7021_Write(_Si7021.cmd_buffer, 2)) != SI7021_OK) {
-        SI7021_ERROR("Write() - SI7021_REVISION_CMD Failed/n");
-        return return_code;
-    }
-
-    return_code =
-        Si7021_Read(_Si7021.rsp_buffer, SI7021_REVISION_RSP_LEN);
+    // Command and response in a single transaction (repeated START)
+    return_code = Si7021_WriteRead(_Si7021.cmd_buffer,
+                                   2,
+                                   _Si7021.rsp_buffer,
+                                   SI7021_REVISION_RSP_LEN);
 
     if (return_code == SI7021_OK) {
         uint8_t revision = _Si7021.rsp_buffer[0];
@@ -306,13 +392,8 @@ Si7021ReturnCode Si7021_ReadTemperature(float* temperature)
                      _Si7021.rsp_buffer[2]);
 
         uint16_t temp_code = (_Si7021.rsp_buffer[0] << 8) | _Si7021.rsp_buffer[1];
-        if (Si7021_ComputeCRC8(temp_code) != _Si7021.rsp_buffer[2]) {
-            SI7021_ERROR("CRC Check Failed");
-            return_code = SI7021_CHECKSUM_ERROR;
-        } else {
-            SI7021_DEBUG("temp_code: %d", temp_code);
-            *temperature = Si7021_ConvertTemp(temp_code);
-        }
+        SI7021_DEBUG("temp_code: %d", temp_code);
+        *temperature = Si7021_ConvertTemp(temp_code);
     }
 
     return return_code;
@@ -335,13 +416,8 @@ Si7021ReturnCode Si7021_ReadHumidity(float* humidity)
                      _Si7021.rsp_buffer[2]);
 
         uint16_t rh_code = (_Si7021.rsp_buffer[0] << 8) | _Si7021.rsp_buffer[1];
-        if (Si7021_ComputeCRC8(rh_code) != _Si7021.rsp_buffer[2]) {
-            SI7021_ERROR("CRC Check Failed");
-            return_code = SI7021_CHECKSUM_ERROR;
-        } else {
-            SI7021_DEBUG("rh_code: %d", rh_code);
-            *humidity = Si7021_ConvertHumidity(rh_code);
-        }
+        SI7021_DEBUG("rh_code: %d", rh_code);
+        *humidity = Si7021_ConvertHumidity(rh_code);
     }
 
     return return_code;